@@ -11,14 +11,41 @@
 
 #define DB_SQLITE 1
 #define DB_MYSQL 2
-// Change this to use a different database
+// Change this to use a different database. The classes of this backend can
+// be used without a namespace, for example DbAccess and DbStatement.
 #define DATABASE DB_SQLITE
 
-#if(DATABASE == DB_MYSQL)
-#include "DbAccessMySql.h"
-#elif(DATABASE == DB_SQLITE)
+// These select the backends that are compiled. Both backends can be used in
+// one program with the namespace names, for example DbSqlite::DbAccess and
+// DbMysql::DbAccess. The MySQL backend requires the MySQL client library.
+#ifndef DB_USE_SQLITE
+#define DB_USE_SQLITE (DATABASE == DB_SQLITE)
+#endif
+#ifndef DB_USE_MYSQL
+#define DB_USE_MYSQL (DATABASE == DB_MYSQL)
+#endif
+
+#if(DB_USE_SQLITE)
 #include "DbAccessSqlite.h"
 #endif
+#if(DB_USE_MYSQL)
+#include "DbAccessMysql.h"
+#endif
 
+#if(DATABASE == DB_MYSQL)
+using DbMysql::DbAccess;
+using DbMysql::DbStatement;
+using DbMysql::DbBatchInsert;
+using DbMysql::DbPipeline;
+using DbMysql::DbTransaction;
+#if(!DB_USE_SQLITE)
+using DbMysql::SQLiteMutex;
+#endif
+#elif(DATABASE == DB_SQLITE)
+using DbSqlite::DbAccess;
+using DbSqlite::DbStatement;
+using DbSqlite::DbBatchInsert;
+using DbSqlite::DbTransaction;
 #endif
 
+#endif
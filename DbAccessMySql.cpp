@@ -6,7 +6,15 @@
 */
 #include "DbAccess.h"
 
-#if(DATABASE == DB_MYSQL)
+#if(DB_USE_MYSQL)
+#include "errmsg.h"         // For CR_ client error numbers
+#include "mysqld_error.h"   // For ER_ server error numbers
+#include <stdio.h>          // For snprintf
+#include <stdlib.h>         // For strtoul
+#include <ctype.h>          // For toupper
+#include <mutex>            // For std::call_once
+#include <algorithm>        // For std::max
+#include <cmath>            // For std::isfinite
 
 #if(0)
 #define DEBUG_PRINT(x) printf("%s\n", x);
@@ -16,42 +24,50 @@
 
 // These comments need to be retested since the code has changed.
 //
-// GET_LENGTHS
-//      0 = Get the lengths for each row using mysql_stmt_fetch_column.
-//          - This works if field lengths are filled. In the CalcPredictions
-//            program, the first two field lengths (floats) are not filled by
-//            mysql, but if filled in code here, it does get the data properly.
-//            Changing database to DECIMAL instead of FLOAT returns the length.
-//
-//      1 = Get the lengths based on the meta data using mysql_stmt_result_metadata.
+// Prepared statement results are bound with native types from
+// mysql_stmt_result_metadata. See DbStatement::bindPreparedResults().
 //
 // STORE_RESULTS
+//      This applies to prepared statements and text queries.
 //      0 = Fetches results as needed.
 //          - This fails with a "commands out of sync" error if a normal statement
 //            is run during the prepared statement.
 //      1 = Calls mysql_stmt_store_result to get all results to client.
 //          - This works so that a prepared statement can be called, then normal
 //            statements can be run during the prepared statement.
+//      A statement can instead use DbStatement::setResultMode(DRM_Cursor) for
+//      large result sets. Then the rows are fetched from a server side cursor
+//      in blocks, and other statements can still be run.
 //
 // BIND_PREPARED_PARAMETERS
-//      0 = This uses simple string combining to build a query string. THIS
-//          DOES NOT ESCAPE STRINGS YET.
-//          - This works with all tested programs so far.
+//      0 = This uses string combining to build a query string. Text values
+//          are escaped with mysql_real_escape_string.
 //
 //      1 = This uses mysql_stmt_bind_param() to bind parameters to a query.
-//          - This fails with CalcPredictions in release mode. It works in debug mode.
-//          - This works with CalcIntegrals in all modes. (Only a single parameter
-//            for prepared statement?)
-#define GET_LENGTHS 0
+//          The values are sent with native types (LONGLONG, DOUBLE, STRING,
+//          BLOB, NULL), so there is no formatting or parsing of values.
+//          - This previously failed in release mode because the null
+//            indicator pointed to a local variable. The bind array now only
+//            points to values that are kept in the statement.
 #define STORE_RESULTS 1
 #define BIND_PREPARED_PARAMETERS 1
 
-MYSQL_RES *DbStatement::mResult;
-MYSQL_RES *DbStatement::mPreparedResult;
+namespace DbMysql
+{
+
+static std::once_flag sMySqlLibraryInit;
 
-DbResult DbAccess::open(char const *dbName)
+DbResult DbAccess::open(char const *dbName, int connectOptions)
     {
     DbResult result;
+    // mysql_init() initializes the library if needed, but that is not
+    // thread safe, so the library is initialized once before any connection.
+    std::call_once(sMySqlLibraryInit, []()
+        { mysql_library_init(0, nullptr, nullptr); });
+    close();
+    mDbName = dbName;
+    mConnectOptions = connectOptions;
+    mConnectionGeneration++;
     mConnection = mysql_init(NULL);
     if(mConnection)
         {
@@ -60,35 +76,304 @@ DbResult DbAccess::open(char const *dbName)
         // dbName is host/dbname
         std::vector<std::string> dbId;
         StringSplit(dbName, dbId, "/");
+        unsigned long clientFlags = 0;
+        if(connectOptions & DCO_LocalInfile)
+            {
+            // The option must be set before connecting so that the
+            // CLIENT_LOCAL_FILES capability is sent to the server.
+            unsigned int localInfile = 1;
+            mysql_options(mConnection, MYSQL_OPT_LOCAL_INFILE, &localInfile);
+            clientFlags |= CLIENT_LOCAL_FILES;
+            }
+        if(connectOptions & DCO_MultiStatements)
+            {
+            clientFlags |= CLIENT_MULTI_STATEMENTS;
+            }
         if(mysql_real_connect(mConnection, dbId[0].c_str(), user, pw,
-            dbId[1].c_str(), 0, NULL, 0) == NULL)
+            dbId[1].c_str(), 0, NULL, clientFlags) == NULL)
             {
+            result = getResult(mysql_errno(mConnection), mysql_error(mConnection),
+                nullptr);
             std::string errStr = "Unable to open database connection ";
 			errStr += dbName;
-            errStr += ". ";
-            errStr += mysql_error(mConnection);
-            result.setError(errStr);
+            result.insertContext(errStr);
             }
+        else if(connectOptions & DCO_LocalInfile)
+            {
+            refuseLocalFiles();
+            }
+        }
+    else
+        {
+        result.setNativeError(DEC_Connection, CR_OUT_OF_MEMORY,
+            "Unable to initialize MySQL connection");
+        }
+    return result;
+    }
+
+static int refuseInfileInit(void **ptr, char const * /*fileName*/, void * /*userData*/)
+    {
+    *ptr = nullptr;
+    return 1;
+    }
+
+static int refuseInfileRead(void * /*ptr*/, char * /*buf*/, unsigned int /*len*/)
+    {
+    return -1;
+    }
+
+static void refuseInfileEnd(void * /*ptr*/)
+    {
+    }
+
+static int refuseInfileError(void * /*ptr*/, char *errorMsg, unsigned int errorMsgLen)
+    {
+    snprintf(errorMsg, errorMsgLen, "Local files are only sent by DbBulkLoader");
+    return CR_UNKNOWN_ERROR;
+    }
+
+// The default handler would read any file that the server names, so it is
+// never used.
+void DbAccess::refuseLocalFiles()
+    {
+    mysql_set_local_infile_handler(mConnection, refuseInfileInit, refuseInfileRead,
+        refuseInfileEnd, refuseInfileError, nullptr);
+    }
+
+DbErrorCategory DbAccess::getErrorCategory(unsigned int mysqlErr)
+    {
+    DbErrorCategory category = DEC_None;
+    switch(mysqlErr)
+        {
+        case 0:
+            break;
+
+        case ER_LOCK_WAIT_TIMEOUT:
+        case ER_LOCK_DEADLOCK:
+            category = DEC_Busy;
+            break;
+
+        case ER_DUP_KEY:
+        case ER_DUP_ENTRY:
+        case ER_BAD_NULL_ERROR:
+        case ER_ROW_IS_REFERENCED_2:
+        case ER_NO_REFERENCED_ROW_2:
+            category = DEC_Constraint;
+            break;
+
+        case ER_NO_SUCH_TABLE:
+            category = DEC_NotFound;
+            break;
+
+        case ER_ACCESS_DENIED_ERROR:
+        case ER_BAD_DB_ERROR:
+        case CR_CONNECTION_ERROR:
+        case CR_CONN_HOST_ERROR:
+        case CR_SERVER_GONE_ERROR:
+        case CR_SERVER_LOST:
+            category = DEC_Connection;
+            break;
+
+        case CR_COMMANDS_OUT_OF_SYNC:
+        case CR_PARAMS_NOT_BOUND:
+            category = DEC_Misuse;
+            break;
+
+        default:
+            category = DEC_Other;
+            break;
+        }
+    return category;
+    }
+
+DbResult DbAccess::getResult(unsigned int mysqlErr, char const *mysqlMsg,
+    char const *staticMsg)
+    {
+    DbResult result;
+    DbErrorCategory category = getErrorCategory(mysqlErr);
+    if(category == DEC_None)
+        {
+        category = DEC_Other;
+        }
+    if(isDbErrorExpected(category) || !mysqlMsg || mysqlMsg[0] == '\0')
+        {
+        result.setNativeError(category, static_cast<int>(mysqlErr), staticMsg);
         }
     else
         {
-        result.setError("Unable to initialize MySQL connection");
+        result.setNativeError(category, static_cast<int>(mysqlErr), nullptr);
+        result.setError(mysqlMsg);
+        if(staticMsg)
+            {
+            result.insertStaticContext(staticMsg);
+            }
+        }
+    return result;
+    }
+
+DbResult DbAccess::reconnect()
+    {
+    std::string dbName = mDbName;
+    return open(dbName.c_str(), mConnectOptions);
+    }
+
+DbResult DbAccess::ping()
+    {
+    DbResult result;
+    if(!mConnection)
+        {
+        result.setNativeError(DEC_Connection, CR_SERVER_GONE_ERROR, "Not connected");
+        }
+    else if(mysql_ping(mConnection) != 0)
+        {
+        result = getResult(mysql_errno(mConnection), mysql_error(mConnection),
+            "Unable to ping server");
+        }
+    return result;
+    }
+
+DbResult DbAccess::rollback()
+    {
+    DbResult result;
+    if(mInTransaction)
+        {
+        finishUnfinishedResults(nullptr);
+        static char const query[] = "ROLLBACK";
+        if(mysql_real_query(mConnection, query, sizeof(query) - 1) != 0)
+            {
+            result = getResult(mysql_errno(mConnection), mysql_error(mConnection),
+                "Unable to roll back transaction");
+            }
+        mInTransaction = false;
         }
     return result;
     }
 
+void DbAccess::finishUnfinishedResults(DbStatement const *stmt)
+    {
+    if(mUnfinishedStmt && mUnfinishedStmt != stmt)
+        {
+        // This also clears mUnfinishedStmt.
+        mUnfinishedStmt->closeResults();
+        }
+    }
+
 void DbAccess::close()
     {
+    if(mUnfinishedStmt)
+        {
+        mUnfinishedStmt->closeResults();
+        }
+    mStmtCache.close();
     if(mConnection)
         {
         DEBUG_PRINT("mysql_close\n");
         mysql_close(mConnection);
         mConnection = nullptr;
         }
+    mInTransaction = false;
+    }
+
+MYSQL_STMT *DbMySqlStmtCache::acquire(std::string const &query)
+    {
+    MYSQL_STMT *stmt = nullptr;
+    auto iter = mEntries.find(query);
+    if(iter != mEntries.end() && iter->second.mStmt)
+        {
+        stmt = iter->second.mStmt;
+        iter->second.mStmt = nullptr;
+        iter->second.mLastUse = ++mUseCounter;
+        mNumStatements--;
+        }
+    return stmt;
+    }
+
+void DbMySqlStmtCache::release(std::string const &query, MYSQL_STMT *stmt)
+    {
+    CacheEntry &entry = mEntries[query];
+    if(entry.mStmt)
+        {
+        // Another statement with the same query was released first.
+        mysql_stmt_close(stmt);
+        }
+    else
+        {
+        if(mNumStatements >= MaxStatements)
+            {
+            evictStatement();
+            }
+        entry.mStmt = stmt;
+        entry.mLastUse = ++mUseCounter;
+        mNumStatements++;
+        }
+    }
+
+unsigned int DbMySqlStmtCache::countUse(std::string const &query)
+    {
+    if(mEntries.size() >= MaxQueries && mEntries.find(query) == mEntries.end())
+        {
+        // Forget the queries that do not have a statement.
+        for(auto iter = mEntries.begin(); iter != mEntries.end(); )
+            {
+            if(iter->second.mStmt)
+                { ++iter; }
+            else
+                { iter = mEntries.erase(iter); }
+            }
+        }
+    CacheEntry &entry = mEntries[query];
+    entry.mUseCount++;
+    entry.mLastUse = ++mUseCounter;
+    return entry.mUseCount;
+    }
+
+void DbMySqlStmtCache::evictStatement()
+    {
+    CacheEntry *oldest = nullptr;
+    for(auto &iter : mEntries)
+        {
+        if(iter.second.mStmt && (!oldest || iter.second.mLastUse < oldest->mLastUse))
+            {
+            oldest = &iter.second;
+            }
+        }
+    if(oldest)
+        {
+        DEBUG_PRINT("mysql_stmt_close\n");
+        mysql_stmt_close(oldest->mStmt);
+        oldest->mStmt = nullptr;
+        mNumStatements--;
+        }
+    }
+
+void DbMySqlStmtCache::close()
+    {
+    for(auto &iter : mEntries)
+        {
+        if(iter.second.mStmt)
+            {
+            DEBUG_PRINT("mysql_stmt_close\n");
+            mysql_stmt_close(iter.second.mStmt);
+            }
+        }
+    mEntries.clear();
+    mNumStatements = 0;
     }
 
 void DbStatement::close()
     {
+    closeResults();
+    releasePreparedStmt();
+    }
+
+void DbStatement::closeResults()
+    {
+    mDb.clearUnfinishedResults(this);
+    if(mDbDataState >= DBS_Get)
+        {
+        // The rows are no longer available.
+        mDbDataState = DBS_Init;
+        }
     if(mResult)
         {
         DEBUG_PRINT("mysql_free_result\n");
@@ -105,10 +390,73 @@ void DbStatement::close()
         }
     if(mPreparedStmt)
         {
-        DEBUG_PRINT("mysql_stmt_close\n");
-        mysql_stmt_close(mPreparedStmt);
+        DEBUG_PRINT("mysql_stmt_free_result\n");
+        mysql_stmt_free_result(mPreparedStmt);
+        }
+    }
+
+// A prepared statement is returned to the connection cache so that it can
+// be reused by another DbStatement with the same query.
+void DbStatement::releasePreparedStmt()
+    {
+    if(mPreparedStmt)
+        {
+        // A statement from a previous connection cannot be reused.
+        if(mPreparedQuery.length() > 0 && BIND_PREPARED_PARAMETERS &&
+            mPreparedGeneration == mDb.getConnectionGeneration())
+            {
+            DEBUG_PRINT("mysql_stmt_free_result\n");
+            mysql_stmt_free_result(mPreparedStmt);
+            mDb.getStmtCache().release(mPreparedQuery, mPreparedStmt);
+            }
+        else
+            {
+            DEBUG_PRINT("mysql_stmt_close\n");
+            mysql_stmt_close(mPreparedStmt);
+            }
         mPreparedStmt = nullptr;
         }
+    mPreparedQuery.clear();
+    }
+
+// This reuses the current statement or a cached statement if it was
+// prepared with the same query.
+DbResult DbStatement::prepare(MYSQL *conn, std::string const &query)
+    {
+    DbResult result;
+    if(!mPreparedStmt || mPreparedQuery != query ||
+        mPreparedGeneration != mDb.getConnectionGeneration())
+        {
+        releasePreparedStmt();
+        mPreparedGeneration = mDb.getConnectionGeneration();
+        mPreparedStmt = mDb.getStmtCache().acquire(query);
+        if(mPreparedStmt)
+            {
+            mPreparedQuery = query;
+            }
+        else
+            {
+            mPreparedStmt = mysql_stmt_init(conn);
+            DEBUG_PRINT(query.c_str());
+            DEBUG_PRINT("mysql_stmt_prepare\n");
+            if(!mPreparedStmt)
+                {
+                result = DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+                    "Unable to init SQL statement");
+                }
+            else if(mysql_stmt_prepare(mPreparedStmt, query.c_str(),
+                static_cast<unsigned long>(query.length())) == 0)
+                {
+                mPreparedQuery = query;
+                }
+            else
+                {
+                result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+                    mysql_stmt_error(mPreparedStmt), "Unable to prepare SQL statement");
+                }
+            }
+        }
+    return result;
     }
 
 DbResult DbStatement::bindValues(std::vector<std::string> const &values)
@@ -122,11 +470,9 @@ DbResult DbStatement::bindValues(std::vector<std::string> const &values)
     }
 
 
-/// @todo - the current code does not use this.
-/// See BIND_PREPARED_PARAMETERS and the fact that it replaces all parameters so
-/// that paramCount below is zero.
-DbResult DbStatement::bindPreparedParameters(MYSQL *conn, MYSQL_STMT *stmt,
-    std::vector<std::string> const &bindValues)
+// The bind array points to the typed values, so no values are formatted as
+// text, and the values do not need to be escaped.
+DbResult DbStatement::bindPreparedParameters(MYSQL_STMT *stmt)
     {
     DbResult result;
     unsigned long paramCount = 0;
@@ -136,60 +482,41 @@ DbResult DbStatement::bindPreparedParameters(MYSQL *conn, MYSQL_STMT *stmt,
         }
     if(paramCount > 0)
         {
-        if(paramCount == bindValues.size())
-            {
-            my_bool setNull = true;
-            my_bool clearNull = false;
-
-            mPreparedBindArray.resize(bindValues.size());
-            // Looks like isnull, len is not needed.
-            // BUT- must set buffer_length to num chars then.
-            mPreparedBindValues = bindValues;
-            mPreparedBindLengths.resize(bindValues.size());
-            mPreparedBindIsNull.resize(bindValues.size());
-            mPreparedBindError.resize(bindValues.size());
-
-            for(size_t i=0; i<mPreparedBindArray.size(); i++)
-                 {
-                 mPreparedBindIsNull[i] = false;
-            //     mPreparedBindValues[i].resize(bindValues[i].length() * 2);
-            //     mysql_real_escape_string(conn, const_cast<char*>(mPreparedBindValues[i].data()),
-            //         bindValues[i].c_str(), bindValues[i].length());
-                 }
-            for(size_t i=0; i<mPreparedBindArray.size(); i++)
-                {
-                mPreparedBindArray[i].length=0;
-                if(bindValues[i] == NULL_SQL_INDICATOR)
-                    {
-                    mPreparedBindArray[i].is_null=&setNull;
-                    }
-                else
+        if(paramCount == mBindValues.size())
+            {
+            mPreparedBindArray.assign(mBindValues.size(), MYSQL_BIND());
+            for(size_t i=0; i<mBindValues.size(); i++)
+                {
+                DbBindValue &value = mBindValues[i];
+                MYSQL_BIND &bind = mPreparedBindArray[i];
+                bind.buffer_type = value.mType;
+                switch(value.mType)
                     {
-                    mPreparedBindArray[i].is_null=&mPreparedBindIsNull[i];
-                    mPreparedBindArray[i].error = &mPreparedBindError[i];
-                    mPreparedBindArray[i].buffer_type=MYSQL_TYPE_STRING;
-                    mPreparedBindArray[i].buffer=const_cast<void *>(static_cast<void const *>(
-                        mPreparedBindValues[i].data()));
-                    mPreparedBindArray[i].buffer_length=static_cast<unsigned long>(
-                        mPreparedBindValues[i].length()+1);
-
-                    mPreparedBindLengths[i] = mPreparedBindValues[i].length();
-                    mPreparedBindArray[i].length = &mPreparedBindLengths[i];
+                    case MYSQL_TYPE_LONGLONG:
+                        bind.buffer = &value.mInt;
+                        break;
+
+                    case MYSQL_TYPE_DOUBLE:
+                        bind.buffer = &value.mDouble;
+                        break;
+
+                    case MYSQL_TYPE_STRING:
+                    case MYSQL_TYPE_BLOB:
+                        value.mLength = static_cast<unsigned long>(value.mText.length());
+                        bind.buffer = const_cast<char *>(value.mText.data());
+                        bind.buffer_length = value.mLength;
+                        bind.length = &value.mLength;
+                        break;
+
+                    default:
+                        break;
                     }
                 }
             DEBUG_PRINT("mysql_stmt_bind_param\n");
-            if(mysql_stmt_bind_param(stmt, mPreparedBindArray.data()) != NULL)
-                {
-                std::string errStr = "Unable to bind values. ";
-                errStr += mysql_error(conn);
-                result.setError(errStr.c_str());
-                }
-            for(int i=0; i<mPreparedBindError.size(); i++)
+            if(mysql_stmt_bind_param(stmt, mPreparedBindArray.data()) != 0)
                 {
-                if(mPreparedBindError[i])
-                    {
-                    result.setError("Bind error");
-                    }
+                result = DbAccess::getResult(mysql_stmt_errno(stmt),
+                    mysql_stmt_error(stmt), "Unable to bind values");
                 }
             }
         else
@@ -197,26 +524,164 @@ DbResult DbStatement::bindPreparedParameters(MYSQL *conn, MYSQL_STMT *stmt,
             std::string errStr = "Incorrect bind count. Query expects ";
             errStr += std::to_string(paramCount);
             errStr += " but the number of values is ";
-            errStr += std::to_string(bindValues.size());
+            errStr += std::to_string(mBindValues.size());
             errStr += ".\n";
+            result.setNativeError(DEC_Misuse, CR_PARAMS_NOT_BOUND, nullptr);
             result.setError(errStr.c_str());
             }
         }
     return result;
     }
 
-static size_t getNumParameters(std::string const &stmt)
+// Gets the next word of the query in upper case, and returns false at the
+// end of the query. Quoted text and comments are skipped, so they cannot
+// change how the query is classified. Operators such as ":=" are returned
+// as words.
+static bool getNextQueryWord(std::string const &query, size_t &pos,
+    std::string &word)
+    {
+    word.clear();
+    while(pos < query.length() && word.empty())
+        {
+        char c = query[pos];
+        char next = (pos+1 < query.length()) ? query[pos+1] : '\0';
+        if(c == '\'' || c == '\"' || c == '`')
+            {
+            pos++;
+            while(pos < query.length() && query[pos] != c)
+                {
+                if(query[pos] == '\\')
+                    {
+                    pos++;
+                    }
+                pos++;
+                }
+            pos++;
+            }
+        else if((c == '-' && next == '-') || c == '#')
+            {
+            while(pos < query.length() && query[pos] != '\n')
+                { pos++; }
+            }
+        else if(c == '/' && next == '*')
+            {
+            pos += 2;
+            while(pos+1 < query.length() && !(query[pos] == '*' && query[pos+1] == '/'))
+                { pos++; }
+            pos += 2;
+            }
+        else if(c == ':' && next == '=')
+            {
+            word = ":=";
+            pos += 2;
+            }
+        else if(isalnum(static_cast<unsigned char>(c)) || c == '_')
+            {
+            while(pos < query.length() && (isalnum(static_cast<unsigned char>(
+                query[pos])) || query[pos] == '_'))
+                {
+                word += static_cast<char>(toupper(static_cast<unsigned char>(query[pos])));
+                pos++;
+                }
+            }
+        else
+            {
+            pos++;
+            }
+        }
+    return !word.empty();
+    }
+
+static bool isQueryWord(std::string const &word, char const * const *words,
+    size_t numWords)
+    {
+    bool found = false;
+    for(size_t i=0; i<numWords && !found; i++)
+        {
+        found = (word == words[i]);
+        }
+    return found;
+    }
+
+// Finds whether the query only reads data, so that it can be executed again
+// on a new connection, and whether it starts or ends a transaction.
+// Locking reads, SELECT INTO, variable assignments, and functions that
+// change or read the state of the connection are not idempotent. Stored
+// functions are not known, so a query that calls one that has side effects
+// must use setIdempotent(false).
+static void classifyQuery(std::string const &query, bool &idempotent,
+    DbTransactionControls &control)
     {
-    return std::count(stmt.begin(), stmt.end(), ':');
+    static char const * const readKeywords[] = { "SELECT", "SHOW", "DESCRIBE",
+        "EXPLAIN" };
+    static char const * const sideEffectWords[] = { "INTO", ":=", "GET_LOCK",
+        "RELEASE_LOCK", "RELEASE_ALL_LOCKS", "LAST_INSERT_ID", "FOUND_ROWS",
+        "ROW_COUNT" };
+    size_t pos = 0;
+    std::string word;
+    std::string prevWord;
+    idempotent = false;
+    control = DTC_None;
+    if(getNextQueryWord(query, pos, word))
+        {
+        idempotent = isQueryWord(word, readKeywords,
+            sizeof(readKeywords) / sizeof(readKeywords[0]));
+        if(word == "BEGIN")
+            {
+            control = DTC_Begin;
+            }
+        else if(word == "START" || word == "COMMIT" || word == "ROLLBACK")
+            {
+            prevWord = word;
+            getNextQueryWord(query, pos, word);
+            if(prevWord == "START" && word == "TRANSACTION")
+                {
+                control = DTC_Begin;
+                }
+            // ROLLBACK TO SAVEPOINT does not end the transaction.
+            else if(prevWord != "START" && word != "TO")
+                {
+                control = DTC_End;
+                // COMMIT AND CHAIN starts the next transaction.
+                if(word == "AND" && getNextQueryWord(query, pos, word) &&
+                    word == "CHAIN")
+                    {
+                    control = DTC_Begin;
+                    }
+                }
+            }
+        }
+    while(idempotent && getNextQueryWord(query, pos, word))
+        {
+        if(isQueryWord(word, sideEffectWords,
+            sizeof(sideEffectWords) / sizeof(sideEffectWords[0])))
+            {
+            idempotent = false;
+            }
+        // FOR UPDATE, FOR SHARE and LOCK IN SHARE MODE take row locks.
+        else if((prevWord == "FOR" && (word == "UPDATE" || word == "SHARE")) ||
+            (prevWord == "LOCK" && word == "IN"))
+            {
+            idempotent = false;
+            }
+        prevWord.swap(word);
+        }
     }
 
 DbResult DbStatement::set(char const *query)
     {
     DbResult result;
-    close();
-    mMultiRowParams = getNumParameters(query);
+    // The prepared statement is kept in case the same query is set again.
+    closeResults();
+    mColumnMap.clear();
     mDbDataState = DBS_Init;
     mQueryString = query;
+    // The parameter table and the text with "?" parameters are only made once
+    // for each query.
+    mQueryScan.scan(mQueryString, DSF_Parameters | DSF_Rewrite |
+        DSF_PercentParams | DSF_BackslashEscapes);
+    mMultiRowParams = static_cast<int>(mQueryScan.getNumParameters());
+    classifyQuery(mQueryString, mIdempotent, mTransactionControl);
     return result;
     }
 
@@ -225,27 +690,42 @@ DbResult DbStatement::reset()
     DbResult result;
     if(mDbDataState >= DBS_Execute)
         {
-        mDbDataState = DBS_BindParams;
-        }
-    // If this is an insert statement, there are no results.
-    if(mResult)
-        {
-        mysql_data_seek(mResult, 0);
+        if(mUsePreparedStatement)
+            {
+            // The statement stays prepared, and only the values are bound again.
+            mDbDataState = DBS_BindParams;
+            }
+        else
+            {
+            // A text query contains the values, so it is built again. This
+            // also allows the adaptive mode to change to a prepared statement.
+            mDbDataState = DBS_Init;
+            }
         }
+    closeResults();
     return result;
     }
 
-DbResult DbStatement::getNormalResults(std::vector<std::string> &bindResults)
+DbResult DbStatement::getNormalResults(DbRowBuffer &row)
     {
     DbResult result;
 
     MYSQL *conn = mDb.getConnection();
     if(mDbDataState == DBS_Get)
         {
+#if(STORE_RESULTS)
+        // This allows other statements to run while the results are read,
+        // which is needed since the adaptive mode can use text queries.
+        DEBUG_PRINT("mysql_store_result\n");
+        mResult = mysql_store_result(conn);
+#else
         DEBUG_PRINT("mysql_use_result\n");
         mResult = mysql_use_result(conn);
+#endif
         if(mResult)
             {
+            // The field metadata is only read once for the result set.
+            mNumResultFields = mysql_num_fields(mResult);
             mDbDataState = DBS_Extract;
             }
         else
@@ -257,133 +737,213 @@ DbResult DbStatement::getNormalResults(std::vector<std::string> &bindResults)
     if(mDbDataState == DBS_Extract)
         {
         DEBUG_PRINT("mysql_fetch_row\n");
-        if(mResult != nullptr)
+        MYSQL_ROW fields = mysql_fetch_row(mResult);
+        if(fields != NULL)
             {
-            int numFields =  mysql_num_fields(mResult);
-            MYSQL_ROW row = mysql_fetch_row(mResult);
-            if(row != NULL)
+            // The lengths work for text and blobs, and prevent strlen.
+            unsigned long *lengths = mysql_fetch_lengths(mResult);
+            row.startRow(mNumResultFields);
+            for(unsigned int i=0; i<mNumResultFields; i++)
                 {
-                bindResults.resize(numFields);
-                for(size_t i=0; i<numFields; i++)
-                    {
-                    MYSQL_FIELD *field = mysql_fetch_field_direct(mResult,
-                        static_cast<unsigned int>(i));
-                    if(field->type == MYSQL_TYPE_BLOB)
-                        {
-                        unsigned long *lengths = mysql_fetch_lengths(mResult);
-                        unsigned long len = lengths[i];
-                        bindResults[i].resize(len);
-                        memcpy(const_cast<void*>(static_cast<const void*>(
-                            bindResults[i].data())), row[i], len);
-                        }
-                    else
-                        {
-                        if(row[i] == NULL)
-                            {
-                            bindResults[i] = "";
-                            }
-                        else
-                            {
-                            bindResults[i] = row[i];
-                            }
-                        }
-                    }
+                row.setField(i, fields[i], lengths[i]);
                 }
-            else
+            }
+        else
+            {
+            row.clear();
+            mDbDataState = DBS_Init;
+            closeResults();
+            }
+        }
+    else
+        {
+        row.clear();
+        if(mysql_field_count(conn) != 0)
+            {
+            result = DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+                "Unable to get results");
+            }
+        }
+    return result;
+    }
+
+
+// Binds each result column with a native type from the field metadata.
+// Integers and doubles are fetched into native values, dates and times into
+// MYSQL_TIME, and other columns into text buffers that grow as needed. The
+// buffers are kept, so later result sets do not allocate once they are
+// large enough.
+DbResult DbStatement::bindPreparedResults()
+    {
+    DbResult result;
+    static unsigned long const InitialTextSize = 64;
+    DEBUG_PRINT("mysql_stmt_result_metadata\n");
+    mPreparedResult = mysql_stmt_result_metadata(mPreparedStmt);
+    if(mPreparedResult)
+        {
+        MYSQL_FIELD *fields = mysql_fetch_fields(mPreparedResult);
+        mResultColumns.resize(mNumResultFields);
+        mPreparedBindResultArray.resize(mNumResultFields);
+        for(unsigned int i=0; i<mNumResultFields; i++)
+            {
+            DbResultColumn &column = mResultColumns[i];
+            MYSQL_BIND &bind = mPreparedBindResultArray[i];
+            bind = MYSQL_BIND();
+            bind.is_null = &column.mIsNull;
+            bind.length = &column.mLength;
+            bind.error = &column.mError;
+            switch(fields[i].type)
                 {
-                bindResults.resize(0);
-                mDbDataState = DBS_Init;
+                case MYSQL_TYPE_TINY:
+                case MYSQL_TYPE_SHORT:
+                case MYSQL_TYPE_INT24:
+                case MYSQL_TYPE_LONG:
+                case MYSQL_TYPE_LONGLONG:
+                case MYSQL_TYPE_YEAR:
+                    // An unsigned BIGINT above the int64_t range wraps.
+                    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                    bind.buffer = &column.mInt;
+                    bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+                    break;
+
+                case MYSQL_TYPE_FLOAT:
+                case MYSQL_TYPE_DOUBLE:
+                    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                    bind.buffer = &column.mDouble;
+                    break;
+
+                case MYSQL_TYPE_DATE:
+                case MYSQL_TYPE_TIME:
+                case MYSQL_TYPE_DATETIME:
+                case MYSQL_TYPE_TIMESTAMP:
+                    bind.buffer_type = fields[i].type;
+                    bind.buffer = &column.mTime;
+                    break;
+
+                default:
+                    // DECIMAL is fetched as text so that it stays exact.
+                    if(column.mText.size() == 0)
+                        {
+                        column.mText.resize(InitialTextSize);
+                        }
+                    bind.buffer_type = MYSQL_TYPE_STRING;
+                    bind.buffer = column.mText.data();
+                    bind.buffer_length = column.mText.size();
+                    break;
                 }
+            column.mBindType = bind.buffer_type;
             }
-        else
+        DEBUG_PRINT("mysql_stmt_bind_result\n");
+        if(mysql_stmt_bind_result(mPreparedStmt, mPreparedBindResultArray.data()) != 0)
             {
-            bindResults.resize(0);
+            result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+                mysql_stmt_error(mPreparedStmt), "Unable to bind results");
             }
         }
     else
         {
-        std::string errStr = "Unable to get results. ";
-        errStr += mysql_error(conn);
-        result.setError(errStr.c_str());
+        result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+            mysql_stmt_error(mPreparedStmt), "Unable to get result metadata");
         }
     return result;
     }
 
+// The start of the value is already in the buffer, so the buffer is grown
+// and only the rest of the value is fetched. The larger buffer is bound for
+// the following rows.
+DbResult DbStatement::fetchTruncatedColumn(unsigned int columnIndex)
+    {
+    DbResult result;
+    DbResultColumn &column = mResultColumns[columnIndex];
+    size_t oldSize = column.mText.size();
+    column.mText.resize(std::max<size_t>(column.mLength + 1, oldSize * 2));
+    MYSQL_BIND columnBind = MYSQL_BIND();
+    unsigned long columnLen = 0;
+    columnBind.buffer_type = MYSQL_TYPE_STRING;
+    columnBind.buffer = column.mText.data() + oldSize;
+    columnBind.buffer_length = column.mText.size() - oldSize;
+    columnBind.length = &columnLen;
+    DEBUG_PRINT("mysql_stmt_fetch_column\n");
+    if(mysql_stmt_fetch_column(mPreparedStmt, &columnBind, columnIndex, oldSize) != 0)
+        {
+        result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+            mysql_stmt_error(mPreparedStmt), "Unable to get column data");
+        }
+    MYSQL_BIND &bind = mPreparedBindResultArray[columnIndex];
+    bind.buffer = column.mText.data();
+    bind.buffer_length = column.mText.size();
+    return result;
+    }
 
-DbResult DbStatement::getPreparedResults(std::vector<std::string> &bindResults)
+// The attributes are set for every execute, since a cached statement may
+// have been used with another mode.
+DbResult DbStatement::setCursorAttributes()
+    {
+    DbResult result;
+    unsigned long cursorType = (mResultMode == DRM_Cursor) ?
+        CURSOR_TYPE_READ_ONLY : CURSOR_TYPE_NO_CURSOR;
+    unsigned long prefetchRows = mPrefetchRows;
+    if(mysql_stmt_attr_set(mPreparedStmt, STMT_ATTR_CURSOR_TYPE, &cursorType) != 0 ||
+        (mResultMode == DRM_Cursor && mysql_stmt_attr_set(mPreparedStmt,
+        STMT_ATTR_PREFETCH_ROWS, &prefetchRows) != 0))
+        {
+        result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+            mysql_stmt_error(mPreparedStmt), "Unable to set cursor");
+        }
+    return result;
+    }
+
+// Formats the time in the same format as a text query result.
+static size_t formatTime(MYSQL_TIME const &time, enum_field_types type, char *text,
+    size_t textSize)
+    {
+    int len;
+    if(type == MYSQL_TYPE_DATE)
+        {
+        len = snprintf(text, textSize, "%04u-%02u-%02u", time.year, time.month,
+            time.day);
+        }
+    else if(type == MYSQL_TYPE_TIME)
+        {
+        len = snprintf(text, textSize, "%s%02u:%02u:%02u", time.neg ? "-" : "",
+            time.hour, time.minute, time.second);
+        }
+    else
+        {
+        len = snprintf(text, textSize, "%04u-%02u-%02u %02u:%02u:%02u", time.year,
+            time.month, time.day, time.hour, time.minute, time.second);
+        }
+    if(time.second_part != 0 && len > 0)
+        {
+        len += snprintf(text + len, textSize - len, ".%06lu", time.second_part);
+        }
+    return len > 0 ? static_cast<size_t>(len) : 0;
+    }
+
+DbResult DbStatement::getPreparedResults(DbRowBuffer &row)
     {
     DbResult result;
 
-    MYSQL *conn = mDb.getConnection();
     if(mDbDataState == DBS_Get)
         {
-        unsigned int fieldCount = mysql_stmt_field_count(mPreparedStmt);
-        mPreparedBindResultArray.resize(fieldCount);
-        bindResults.resize(fieldCount);
-        mPreparedResultLengths.resize(fieldCount);
-        mPreparedResultIsNull.resize(fieldCount);
-        if(fieldCount > 0)
+        mNumResultFields = mysql_stmt_field_count(mPreparedStmt);
+        if(mNumResultFields > 0)
             {
-#if(GET_LENGTHS == 0)
 #if(STORE_RESULTS)
             // store results gets all results, so should only be done once per execute.
+            // A cursor fetches the rows in blocks instead.
             DEBUG_PRINT("mysql_stmt_store\n");
-            int retVal = mysql_stmt_store_result(mPreparedStmt);
-            if(retVal != 0)
+            if(mResultMode != DRM_Cursor && mysql_stmt_store_result(mPreparedStmt) != 0)
                 {
-                std::string errStr = "Unable to store prepared results. ";
-                int x = mysql_errno(conn);
-                errStr += mysql_stmt_error(mPreparedStmt);
-                result.setError(errStr.c_str());
+                result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+                    mysql_stmt_error(mPreparedStmt), "Unable to store prepared results");
                 }
 #endif
-             mDbDataState = DBS_Extract;
-#else
-            mPreparedResult = mysql_stmt_result_metadata(mPreparedStmt);
-            MYSQL_FIELD *fields = mysql_fetch_fields(mPreparedResult);
-            mPreparedResultStrings.resize(fieldCount);
-            for(size_t i=0; i<mPreparedBindResultArray.size(); i++)
-                {
-                int len = fields[i].length + 1; // Add one for end null byte.
-                mPreparedBindResultArray[i].length = &mPreparedResultLengths[i];
-                mPreparedResultStrings[i].resize(len);
-                mPreparedBindResultArray[i].buffer = const_cast<char*>(mPreparedResultStrings[i].data());
-                mPreparedBindResultArray[i].buffer_length = len;
-                mPreparedBindResultArray[i].buffer_type = MYSQL_TYPE_STRING;
-                }
-            // Now set the bindings.
-            DEBUG_PRINT("mysql_stmt_bind_result\n");
-            if(mysql_stmt_bind_result(mPreparedStmt, mPreparedBindResultArray.data()) == 0)
-                {
-#if(STORE_RESULTS)
-                // IF THIS IS NOT DONE, then the normal statement cannot be run
-                // while a prepared statement is running.
-                // This is used to get all results at once to the client.
-                // This takes more memory than needed?
-                DEBUG_PRINT("mysql_stmt_store_result\n");
-                // Move the results to the client. Length results are still not available.
-                if(mysql_stmt_store_result(mPreparedStmt) == 0)
-                    {
-#endif
-                    mDbState = DBS_Extract;
-#if(STORE_RESULTS)
-
-                    }
-                else
-                    {
-                    std::string errStr = "Unable to get result local. ";
-                    errStr += mysql_stmt_error(mPreparedStmt);
-                    result.setError(errStr.c_str());
-                    }
-#endif
-                }
-            else
+            if(result.isOk())
                 {
-                std::string errStr = "Unable to bind results. ";
-                errStr += mysql_stmt_error(mPreparedStmt);
-                result.setError(errStr.c_str());
+                result = bindPreparedResults();
                 }
-#endif
+            mDbDataState = DBS_Extract;
             }
         else
             {
@@ -393,139 +953,142 @@ DbResult DbStatement::getPreparedResults(std::vector<std::string> &bindResults)
 
     if(mDbDataState == DBS_Extract && result.isOk())
         {
-#if(GET_LENGTHS == 0)
-            // First get the result lengths.
-            // If this is used, I think that this and mysql_stmt_bind_result
-            // should be called before every fetch so that the lengths are
-            // reset every row. The disadvantage of this method is that the
-            // memory has to be resized (std::string) every row.
-            for(size_t i=0; i<mPreparedBindResultArray.size(); i++)
-                {
-                mPreparedBindResultArray[i].buffer = nullptr;
-                mPreparedBindResultArray[i].buffer_length = 0;
-                mPreparedBindResultArray[i].is_null = &mPreparedResultIsNull[i];
-                mPreparedBindResultArray[i].length = &mPreparedResultLengths[i];
-                }
-        int retValx = mysql_stmt_bind_result(mPreparedStmt, mPreparedBindResultArray.data());
-        if(retValx != 0)
-            {
-            std::string errStr = "Unable to bind results. ";
-            errStr += mysql_stmt_error(mPreparedStmt);
-            result.setError(errStr.c_str());
-            }
-#endif
-        int retVal = 0;
-        if(retVal == 0)
-            {
-            DEBUG_PRINT("mysql_stmt_fetch\n");
-            // This will fill mPreparedResultLengths.
-            retVal = mysql_stmt_fetch(mPreparedStmt);
-            }
-#if(GET_LENGTHS == 0)
-        const char *state = mysql_sqlstate(conn);
-        const char *stmt_state = mysql_stmt_sqlstate(mPreparedStmt);
-        char const *err = mysql_stmt_error(mPreparedStmt);
-
-        // MYSQL_DATA_TRUNCATED is returned when first two fields are floats.
+        DEBUG_PRINT("mysql_stmt_fetch\n");
+        int retVal = mysql_stmt_fetch(mPreparedStmt);
         if(retVal == MYSQL_DATA_TRUNCATED || retVal == 0)
             {
-            for(size_t i=0; i<mPreparedResultLengths.size() && result.isOk(); i++)
+            bool rebind = false;
+            row.startRow(mNumResultFields);
+            for(unsigned int i=0; i<mNumResultFields && result.isOk(); i++)
                 {
-                // Zero is returned for floats or null.
-                if(*mPreparedBindResultArray[i].is_null)
+                DbResultColumn &column = mResultColumns[i];
+                if(column.mIsNull)
+                    {
+                    row.setField(i, nullptr, 0);
+                    }
+                else if(column.mBindType == MYSQL_TYPE_LONGLONG)
                     {
-                    mPreparedResultLengths[i] = 0;
+                    row.setFieldInt64(i, column.mInt);
                     }
-                else if(mPreparedResultLengths[i] == 0)
+                else if(column.mBindType == MYSQL_TYPE_DOUBLE)
                     {
-                    // A better way to do this may be to use mysql_stmt_result_metadata/mysql_fetch_fields.
-                    mPreparedResultLengths[i] = 12;
+                    row.setFieldDouble(i, column.mDouble);
                     }
-                bindResults[i].resize(mPreparedResultLengths[i]);
-                mPreparedBindResultArray[i].buffer = const_cast<char*>(bindResults[i].data());
-                mPreparedBindResultArray[i].buffer_length = mPreparedResultLengths[i];
-                mPreparedBindResultArray[i].length = &mPreparedResultLengths[i];
-                if(mysql_stmt_fetch_column(mPreparedStmt, &mPreparedBindResultArray[i],
-                    static_cast<unsigned int>(i), 0) != 0)
+                else if(column.mBindType == MYSQL_TYPE_STRING)
                     {
-                    std::string errStr = "Unable to get column data. ";
-                    errStr += mysql_stmt_error(mPreparedStmt);
-                    result.setError(errStr.c_str());
+                    if(column.mError)
+                        {
+                        result = fetchTruncatedColumn(i);
+                        rebind = true;
+                        }
+                    row.setField(i, column.mText.data(), column.mLength);
+                    }
+                else
+                    {
+                    static size_t const MaxTimeTextSize = 32;
+                    char *text = row.setFieldSpace(i, MaxTimeTextSize);
+                    row.setFieldLength(i, formatTime(column.mTime, column.mBindType,
+                        text, MaxTimeTextSize + 1));
                     }
                 }
+            if(rebind && result.isOk() && mysql_stmt_bind_result(mPreparedStmt,
+                mPreparedBindResultArray.data()) != 0)
+                {
+                result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+                    mysql_stmt_error(mPreparedStmt), "Unable to bind results");
+                }
             }
         else if(retVal == MYSQL_NO_DATA)
             {
-            bindResults.resize(0);
+            row.clear();
             mDbDataState = DBS_Init;
+            closeResults();
             }
-#else
-        if(retVal == MYSQL_DATA_TRUNCATED || retVal == 0)
-            {
-            for(size_t i=0; i<mPreparedResultLengths.size(); i++)
-                {
-                bindResults[i] = mPreparedResultStrings[i];
-                }
-            }
-        else if(retVal == MYSQL_NO_DATA)
+        else
             {
-            closePreparedResult();
-            closePreparedStatement();
-            bindResults.resize(0);
-            mDbState = DBS_Init;
+            result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+                mysql_stmt_error(mPreparedStmt), "Unable to fetch row");
             }
-#endif
         }
     return result;
     }
 
-// @param bindResults The returned results. Size is zero if there are no
-//      more rows.
-DbResult DbStatement::getResults(std::vector<std::string> &bindResults)
+DbResult DbStatement::getColumnTime(int columnIndex, MYSQL_TIME &time) const
     {
     DbResult result;
-    if(mUsePreparedStatement)
+    time = MYSQL_TIME();
+    size_t index = static_cast<size_t>(columnIndex);
+    if(mUsePreparedStatement && index < mResultColumns.size() &&
+        mResultColumns[index].mBindType != MYSQL_TYPE_STRING &&
+        mResultColumns[index].mBindType != MYSQL_TYPE_LONGLONG &&
+        mResultColumns[index].mBindType != MYSQL_TYPE_DOUBLE)
         {
-        result = getPreparedResults(bindResults);
+        time = mResultColumns[index].mTime;
         }
     else
         {
-        result = getNormalResults(bindResults);
+        char const *text = mRow.getFieldText(index);
+        if(text[0] == '-')
+            {
+            time.neg = 1;
+            text++;
+            }
+        unsigned int fields[6] = { 0 };
+        unsigned long secondPart = 0;
+        int numRead;
+        if(strchr(text, '-'))
+            {
+            numRead = sscanf(text, "%u-%u-%u %u:%u:%u.%lu", &fields[0], &fields[1],
+                &fields[2], &fields[3], &fields[4], &fields[5], &secondPart);
+            }
+        else
+            {
+            numRead = sscanf(text, "%u:%u:%u.%lu", &fields[3], &fields[4],
+                &fields[5], &secondPart);
+            }
+        if(numRead > 0)
+            {
+            time.year = fields[0];
+            time.month = fields[1];
+            time.day = fields[2];
+            time.hour = fields[3];
+            time.minute = fields[4];
+            time.second = fields[5];
+            time.second_part = secondPart;
+            }
+        else
+            {
+            result.setNativeError(DEC_Misuse, 0, "Column is not a time");
+            }
         }
     return result;
     }
 
-static std::string normalizeMySqlBindParameterStatement(std::string const &stmt)
+// @param row The returned results. The number of fields is zero if there
+//      are no more rows.
+DbResult DbStatement::getResults(DbRowBuffer &row)
     {
-    std::string mysqlStmt = stmt;
-    for(size_t startI=0; startI<mysqlStmt.length(); startI++)
+    DbResult result;
+    if(mUsePreparedStatement)
         {
-        if(mysqlStmt[startI] == ':')
-            {
-            size_t endI=startI+1;
-            for(; endI<mysqlStmt.length(); endI++)
-                {
-                if(!isalpha(mysqlStmt[endI]))
-                    break;
-                }
-            mysqlStmt.replace(startI, endI-startI, "?");
-            }
-        else if(mysqlStmt[startI] == '%')
-            {
-            mysqlStmt.replace(startI, 2, "?");  // Convert %s
-            }
+        result = getPreparedResults(row);
         }
-    return mysqlStmt;
+    else
+        {
+        result = getNormalResults(row);
+        }
+    return result;
     }
 
+// @param firstParamPos The position of the first parameter in the VALUES list.
 static std::string normalizeMySqlBindParameterMultiRowStatement(std::string const &stmt,
-    int numRows, int paramsPerRow)
+    size_t firstParamPos, int numRows, int paramsPerRow)
     {
     std::string mysqlStmt = stmt;
-    size_t pos = mysqlStmt.find(':');
-    if(pos != std::string::npos)
+    if(firstParamPos != std::string::npos && firstParamPos > 0)
         {
-        mysqlStmt.resize(pos-1);
+        mysqlStmt.resize(firstParamPos-1);
+        mysqlStmt.reserve(mysqlStmt.length() + numRows * (paramsPerRow * 2 + 2));
         for(int rowI=0; rowI<numRows; rowI++)
             {
             mysqlStmt.append("(");
@@ -544,17 +1107,65 @@ static std::string normalizeMySqlBindParameterMultiRowStatement(std::string cons
     return mysqlStmt;
     }
 
-static std::string getMySqlStatement(std::string const &stmt,
-    std::vector<std::string> const &bindValues)
+// Appends a value to a query string. Text values are escaped.
+static void appendMySqlValue(MYSQL *conn, std::string &mysqlStmt,
+    DbBindValue const &value)
     {
-    std::string mysqlStmt = stmt;
+    switch(value.mType)
+        {
+        case MYSQL_TYPE_LONGLONG:
+            mysqlStmt.append(std::to_string(value.mInt));
+            break;
+
+        case MYSQL_TYPE_DOUBLE:
+            // MySQL has no text for infinity or NaN, so these are NULL.
+            if(std::isfinite(value.mDouble))
+                {
+                // This is enough digits to get the same double back.
+                char buf[32];
+                snprintf(buf, sizeof(buf), "%.17g", value.mDouble);
+                mysqlStmt.append(buf);
+                }
+            else
+                {
+                mysqlStmt.append("NULL");
+                }
+            break;
+
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_BLOB:
+            {
+            size_t pos = mysqlStmt.length();
+            // The escaped text can be twice as long plus the ending null.
+            mysqlStmt.resize(pos + value.mText.length() * 2 + 3);
+            mysqlStmt[pos++] = '\'';
+            unsigned long len = mysql_real_escape_string(conn, &mysqlStmt[pos],
+                value.mText.data(), static_cast<unsigned long>(value.mText.length()));
+            pos += len;
+            mysqlStmt[pos++] = '\'';
+            mysqlStmt.resize(pos);
+            }
+            break;
+
+        default:
+            mysqlStmt.append("NULL");
+            break;
+        }
+    }
+
+// This replaces "?" parameters with the values. The output is built in a
+// single pass so that large statements do not take quadratic time.
+static std::string getMySqlStatement(MYSQL *conn, std::string const &stmt,
+    std::vector<DbBindValue> const &bindValues)
+    {
+    std::string mysqlStmt;
 
     // This groups multiple bind value rows for one statement and is much
     // faster than inserting a single row.
     // It puts the burden of grouping on the client. Instead we will try
     // prepared statements to see if that works.
     /*
-    size_t numParameters = getNumParameters(stmt);
+    size_t numParameters = DbSqlScanner::countParameters(stmt.data(), stmt.length());
     int numGroups = bindValues.size() / numParameters;
 
     /// @todo - This does not bind parameters with ":tag" column binding values.
@@ -592,34 +1203,200 @@ static std::string getMySqlStatement(std::string const &stmt,
     else
 */
         {
-        int bindIndex = 0;
-        for(size_t startI=0; startI<mysqlStmt.length(); startI++)
+        DbSqlScanner scanner;
+        scanner.scan(stmt, DSF_Parameters | DSF_BackslashEscapes);
+        size_t len = stmt.length();
+        for(auto const &value : bindValues)
+            {
+            len += value.mText.length() + 2;
+            }
+        mysqlStmt.reserve(len);
+        size_t copyPos = 0;
+        for(size_t i=0; i<scanner.getNumParameters() && i<bindValues.size(); i++)
+            {
+            DbSqlParameter const &param = scanner.getParameter(i);
+            mysqlStmt.append(stmt, copyPos, param.mPos - copyPos);
+            appendMySqlValue(conn, mysqlStmt, bindValues[i]);
+            copyPos = param.mPos + param.mLength;
+            }
+        mysqlStmt.append(stmt, copyPos, std::string::npos);
+        }
+    return mysqlStmt;
+    }
+
+// Returns the position of the last "VALUES" before endPos in any case, or npos.
+static size_t findValuesKeyword(std::string const &query, size_t endPos)
+    {
+    static char const keyword[] = "VALUES";
+    size_t const keywordLen = sizeof(keyword) - 1;
+    size_t foundPos = std::string::npos;
+    for(size_t pos=0; pos + keywordLen <= endPos; pos++)
+        {
+        size_t i = 0;
+        while(i < keywordLen && toupper(static_cast<unsigned char>(query[pos+i])) ==
+            keyword[i])
+            {
+            i++;
+            }
+        if(i == keywordLen)
+            {
+            foundPos = pos;
+            }
+        }
+    return foundPos;
+    }
+
+// The size is read from the server once for each batch.
+DbResult DbBatchInsert::readMaxPacketSize()
+    {
+    DbResult result;
+    // This is the default for old servers, so it is always safe.
+    mMaxPacketSize = 1024 * 1024;
+    MYSQL *conn = mDb.getConnection();
+    mDb.finishUnfinishedResults(nullptr);
+    if(mysql_query(conn, "SELECT @@max_allowed_packet") == 0)
+        {
+        MYSQL_RES *res = mysql_store_result(conn);
+        if(res)
             {
-            if(mysqlStmt[startI] == '?')
+            MYSQL_ROW row = mysql_fetch_row(res);
+            if(row && row[0])
                 {
-                std::string valStr = "";
-                bool allDigits = true;
-                for(int i=0; i<bindValues[bindIndex].length(); i++)
-                    {
-                    if(!isdigit(bindValues[bindIndex][i]))
-                        {
-                        allDigits = false;
-                        }
-                    }
-                if(allDigits)
-                    {
-                    valStr = bindValues[bindIndex];
-                    }
-                else
-                    {
-                    valStr = '\'' + bindValues[bindIndex] + '\'';
-                    }
-                mysqlStmt.replace(startI, 1, valStr);
-                bindIndex++;
+                mMaxPacketSize = strtoul(row[0], nullptr, 10);
                 }
+            mysql_free_result(res);
             }
         }
-    return mysqlStmt;
+    else
+        {
+        result = DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+            "Unable to get max_allowed_packet");
+        }
+    return result;
+    }
+
+DbResult DbBatchInsert::set(char const *query)
+    {
+    DbResult result = flush();
+    std::string queryStr = query;
+    DbSqlScanner scanner;
+    scanner.scan(queryStr, DSF_Parameters | DSF_PercentParams | DSF_BackslashEscapes);
+    size_t rowStart = std::string::npos;
+    size_t rowEnd = std::string::npos;
+    if(scanner.getNumParameters() > 0)
+        {
+        size_t valuesPos = findValuesKeyword(queryStr, scanner.getParameter(0).mPos);
+        if(valuesPos != std::string::npos)
+            {
+            rowStart = queryStr.find('(', valuesPos);
+            }
+        }
+    if(rowStart != std::string::npos)
+        {
+        // Find the matching parenthesis, so that functions in the row work.
+        int depth = 0;
+        for(size_t i=rowStart; i<queryStr.length() && rowEnd == std::string::npos; i++)
+            {
+            if(queryStr[i] == '(')
+                {
+                depth++;
+                }
+            else if(queryStr[i] == ')' && --depth == 0)
+                {
+                rowEnd = i;
+                }
+            }
+        }
+    if(rowEnd != std::string::npos)
+        {
+        mPrefix = queryStr.substr(0, rowStart);
+        mRowTemplate = queryStr.substr(rowStart, rowEnd + 1 - rowStart);
+        mSuffix = queryStr.substr(rowEnd + 1);
+        while(mSuffix.length() > 0 && (mSuffix.back() == ';' || mSuffix.back() == ' '))
+            {
+            mSuffix.pop_back();
+            }
+        mRowScan.scan(mRowTemplate, DSF_Parameters | DSF_PercentParams |
+            DSF_BackslashEscapes);
+        mBatchText = mPrefix;
+        mNumBatchRows = 0;
+        }
+    else
+        {
+        result.setNativeError(DEC_Misuse, 0, "Batch insert requires a row of values");
+        }
+    if(result.isOk() && mMaxPacketSize == 0)
+        {
+        result = readMaxPacketSize();
+        }
+    return result;
+    }
+
+DbResult DbBatchInsert::addRow()
+    {
+    DbResult result;
+    MYSQL *conn = mDb.getConnection();
+    mRowText.clear();
+    size_t copyPos = 0;
+    for(size_t i=0; i<mRowScan.getNumParameters(); i++)
+        {
+        DbSqlParameter const &param = mRowScan.getParameter(i);
+        mRowText.append(mRowTemplate, copyPos, param.mPos - copyPos);
+        if(i < mValues.size())
+            {
+            appendMySqlValue(conn, mRowText, mValues[i]);
+            }
+        else
+            {
+            mRowText.append("NULL");
+            }
+        copyPos = param.mPos + param.mLength;
+        }
+    mRowText.append(mRowTemplate, copyPos, std::string::npos);
+
+    // One is for the comma between rows.
+    size_t newLength = mBatchText.length() + 1 + mRowText.length() + mSuffix.length();
+    if(mNumBatchRows > 0 && (mNumBatchRows >= mMaxRows || newLength > mMaxPacketSize))
+        {
+        result = flush();
+        }
+    if(result.isOk())
+        {
+        if(mNumBatchRows > 0)
+            {
+            mBatchText.append(1, ',');
+            }
+        mBatchText.append(mRowText);
+        mNumBatchRows++;
+        }
+    return result;
+    }
+
+DbResult DbBatchInsert::flush()
+    {
+    DbResult result;
+    if(mNumBatchRows > 0)
+        {
+        MYSQL *conn = mDb.getConnection();
+        mBatchText.append(mSuffix);
+        mDb.finishUnfinishedResults(nullptr);
+        DEBUG_PRINT("mysql_real_query\n");
+        if(mysql_real_query(conn, mBatchText.data(),
+            static_cast<unsigned long>(mBatchText.length())) == 0)
+            {
+            mNumRows += mNumBatchRows;
+            }
+        else
+            {
+            result = DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+                "Unable to insert rows");
+            }
+        mNumRoundTrips++;
+        // The memory is kept for the next batch.
+        mBatchText.assign(mPrefix);
+        mNumBatchRows = 0;
+        }
+    return result;
     }
 
 void DbStatement::startMultiRowInsert(int numRows)
@@ -637,7 +1414,102 @@ DbResult DbStatement::endMultiRowInsert()
     return result;
     }
 
+void DbPipeline::add(char const *query)
+    {
+    if(mNumStatements > 0)
+        {
+        mQuery += ';';
+        }
+    mQuery += query;
+    mNumStatements++;
+    bool idempotent;
+    DbTransactionControls control;
+    classifyQuery(query, idempotent, control);
+    mTransactionControls.push_back(control);
+    }
+
+DbResult DbPipeline::execute()
+    {
+    DbResult result;
+    mAffectedRows.clear();
+    if(mNumStatements > 0)
+        {
+        MYSQL *conn = mDb.getConnection();
+        // The status is 0 if there is a result, -1 if there are no more
+        // results, and greater than 0 for an error.
+        int status = -1;
+        if(!(mDb.getConnectOptions() & DCO_MultiStatements))
+            {
+            result.setNativeError(DEC_Misuse, CR_UNKNOWN_ERROR,
+                "The connection must be opened with DCO_MultiStatements");
+            }
+        else
+            {
+            mDb.finishUnfinishedResults(nullptr);
+            DEBUG_PRINT("mysql_real_query\n");
+            status = mysql_real_query(conn, mQuery.data(),
+                static_cast<unsigned long>(mQuery.length()));
+            }
+        while(status == 0)
+            {
+            MYSQL_RES *res = mysql_store_result(conn);
+            if(res)
+                {
+                mysql_free_result(res);
+                }
+            else if(mysql_field_count(conn) != 0)
+                {
+                status = 1;
+                break;
+                }
+            mAffectedRows.push_back(mysql_affected_rows(conn));
+            status = mysql_next_result(conn);
+            }
+        if(status > 0)
+            {
+            result = DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+                "Unable to execute pipeline");
+            }
+        for(size_t i=0; i<mAffectedRows.size(); i++)
+            {
+            if(mTransactionControls[i] != DTC_None)
+                {
+                mDb.setInTransaction(mTransactionControls[i] == DTC_Begin);
+                }
+            }
+        clear();
+        }
+    return result;
+    }
+
+// A lost connection is reconnected, and the statement is executed again if
+// it is idempotent and nothing has been read from it yet. This is not done
+// in a transaction, since the transaction is lost with the connection, and
+// later statements would then be committed one at a time.
 DbResult DbStatement::execute()
+    {
+    DbResult result = executeOnce();
+    if(!result.isOk() && result.getCategory() == DEC_Connection && mIdempotent &&
+        mDbDataState <= DBS_Execute && !mDb.isInTransaction())
+        {
+        DbResult reconnectResult = mDb.reconnect();
+        if(reconnectResult.isOk())
+            {
+            // The prepared statement belongs to the lost connection.
+            releasePreparedStmt();
+            mDbDataState = DBS_Init;
+            mMultiRowIndex = mMultiRowSize;
+            result = executeOnce();
+            }
+        }
+    if(result.isOk() && mTransactionControl != DTC_None)
+        {
+        mDb.setInTransaction(mTransactionControl == DTC_Begin);
+        }
+    return result;
+    }
+
+DbResult DbStatement::executeOnce()
     {
     DbResult result;
 
@@ -647,6 +1519,12 @@ DbResult DbStatement::execute()
         }
     MYSQL *conn = mDb.getConnection();
 //    printf("%d %d %d\n", mDbDataState, mMultiRowIndex, mMultiRowSize);
+    if(mDbDataState <= DBS_Execute && mMultiRowIndex >= mMultiRowSize)
+        {
+        // A command will be sent, so results of other statements on this
+        // connection must be finished.
+        mDb.finishUnfinishedResults(this);
+        }
     if(mDbDataState == DBS_Init && mMultiRowIndex >= mMultiRowSize)
         {
         /// @todo - if multirow, then clear params and generate ? from mBindValues.size()
@@ -654,52 +1532,60 @@ DbResult DbStatement::execute()
         if(isMultiRow())
             {
             int numRows = mBindValues.size() / mMultiRowParams;
+            size_t firstParamPos = (mQueryScan.getNumParameters() > 0) ?
+                mQueryScan.getParameter(0).mPos : std::string::npos;
             query = normalizeMySqlBindParameterMultiRowStatement(mQueryString,
-                numRows, mMultiRowParams);
+                firstParamPos, numRows, mMultiRowParams);
+            }
+        else
+            {
+            query = mQueryScan.getRewrittenText();
+            }
+        if(mResultMode == DRM_Cursor)
+            {
+            // Cursors are only available for prepared statements.
+            mUsePreparedStatement = true;
+            }
+        else if(mPrepareMode == DPM_Adaptive)
+            {
+            // A query that is only run once is faster as a text query, since
+            // a prepared statement needs a prepare and an execute round trip.
+            mUsePreparedStatement = (mPreparedStmt && mPreparedQuery == query) ||
+                mDb.getStmtCache().countUse(query) >= PREPARE_AFTER_USES;
             }
         else
             {
-            query = normalizeMySqlBindParameterStatement(mQueryString);
+            mUsePreparedStatement = (mPrepareMode == DPM_Prepared);
             }
         if(mUsePreparedStatement)
             {
-            if(!mPreparedStmt)
-                {
-                mPreparedStmt = mysql_stmt_init(conn);
-                }
-            DEBUG_PRINT(query.c_str());
-            DEBUG_PRINT("mysql_stmt_prepare\n");
     #if(BIND_PREPARED_PARAMETERS == 0)
-            std::string noParamQuery = getMySqlStatement(query.c_str(), mBindValues);
+            std::string noParamQuery = getMySqlStatement(conn, query, mBindValues);
             query = noParamQuery;
             mBindValues.resize(0);
     #endif
-            if(mysql_stmt_prepare(mPreparedStmt, query.c_str(),
-                static_cast<unsigned long>(query.length())) == NULL)
+            result = prepare(conn, query);
+            if(result.isOk())
                 {
                 mDbDataState = DBS_BindParams;
                 }
-            else
-                {
-                std::string errStr = "Unable to prepare SQL statement. ";
-                errStr += mysql_stmt_error(mPreparedStmt);
-                result.setError(errStr.c_str());
-                }
             }
         else
             {
-            std::string noParamQuery = getMySqlStatement(query.c_str(), mBindValues);
+            std::string noParamQuery = getMySqlStatement(conn, query, mBindValues);
             DEBUG_PRINT(noParamQuery.c_str());
             DEBUG_PRINT("mysql_query\n");
-            if(mysql_query(conn, noParamQuery.c_str()) == NULL)
+            if(mysql_query(conn, noParamQuery.c_str()) == 0)
                 {
                 mDbDataState = DBS_Get;
+#if(STORE_RESULTS == 0)
+                mDb.setUnfinishedResults(this);
+#endif
                 }
             else
                 {
-                std::string errStr = "Unable to query. ";
-                errStr += mysql_error(conn);
-                result.setError(errStr.c_str());
+                result = DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+                    "Unable to query");
                 }
             }
         }
@@ -707,7 +1593,11 @@ DbResult DbStatement::execute()
         {
         // This binds a whole set of bind values, therefore it should only be
         // done once for one prepare and execute.
-        result = bindPreparedParameters(conn, mPreparedStmt, mBindValues);
+        result = bindPreparedParameters(mPreparedStmt);
+        if(result.isOk())
+            {
+            result = setCursorAttributes();
+            }
         if(result.isOk())
             {
             mDbDataState = DBS_Execute;
@@ -716,15 +1606,22 @@ DbResult DbStatement::execute()
     if(result.isOk() && mDbDataState == DBS_Execute && mMultiRowIndex >= mMultiRowSize)
         {
         DEBUG_PRINT("mysql_stmt_execute\n");
-        if(mysql_stmt_execute(mPreparedStmt) == NULL)
+        if(mysql_stmt_execute(mPreparedStmt) == 0)
             {
             mDbDataState = DBS_Get;
+#if(STORE_RESULTS == 0)
+            // The rows of a cursor are kept on the server, so they do not
+            // prevent other commands.
+            if(mResultMode != DRM_Cursor)
+                {
+                mDb.setUnfinishedResults(this);
+                }
+#endif
             }
         else
             {
-            std::string errStr = "Unable to execute. ";
-            errStr += mysql_stmt_error(mPreparedStmt);
-            result.setError(errStr.c_str());
+            result = DbAccess::getResult(mysql_stmt_errno(mPreparedStmt),
+                mysql_stmt_error(mPreparedStmt), "Unable to execute");
             }
         mMultiRowIndex = 0;
         }
@@ -736,8 +1633,8 @@ DbResult DbStatement::testRow(bool &gotRow)
     DbResult result = execute();
     if(result.isOk())
         {
-        result = getResults(mBindResults);
-        gotRow = (mBindResults.size() > 0);
+        result = getResults(mRow);
+        gotRow = (mRow.getNumFields() > 0);
         }
     return result;
     }
@@ -747,34 +1644,49 @@ DbResult DbStatement::getRow()
     DbResult result = execute();
     if(result.isOk())
         {
-        result = getResults(mBindResults);
+        result = getResults(mRow);
         if(result.isOk())
             {
-            if(mBindResults.size() == 0)
+            if(mRow.getNumFields() == 0)
                 {
-                result.setError("Unable to get row");
+                result.setNativeError(DEC_NotFound, MYSQL_NO_DATA, "Unable to get row");
                 }
             }
         }
     return result;
     }
 
-void DbStatement::setBindValue(int ordinal, char const *str)
+DbBindValue &DbStatement::getBindValue(int ordinal)
     {
     size_t index = (mMultiRowIndex * mMultiRowParams) + ordinal -1;
     if(mBindValues.size() <= index)
         {
         mBindValues.resize(index + 1);
         }
-    mBindValues[index] = str;
+    return mBindValues[index];
+    }
+
+void DbStatement::setBindText(int ordinal, char const *val, size_t len,
+    enum_field_types type)
+    {
+    DbBindValue &value = getBindValue(ordinal);
+    value.mType = type;
+    value.mText.assign(val, len);
     }
 
-void DbStatement::setBindValue(char const *param, char const *str)
+int DbStatement::findParam(char const *param, int startOrdinal) const
     {
-    size_t paramEndI = mQueryString.find(param);
-    int ordinal = static_cast<int>(std::count(mQueryString.begin(),
-        mQueryString.begin()+paramEndI, ':')) + 1;
-    setBindValue(ordinal, str);
+    std::string_view paramName(param);
+    int foundOrdinal = 0;
+    for(size_t i=static_cast<size_t>(startOrdinal);
+        i<mQueryScan.getNumParameters() && foundOrdinal == 0; i++)
+        {
+        if(mQueryScan.getParameterName(i) == paramName)
+            {
+            foundOrdinal = static_cast<int>(i+1);
+            }
+        }
+    return foundOrdinal;
     }
 
 /*
@@ -813,6 +1725,62 @@ std::vector<std::string> DbStatement::getValuesFromDictString(std::string const
     }
 */
 
+void DbStatement::buildColumnMap()
+    {
+    if(!mColumnMap.isBuilt())
+        {
+        MYSQL_RES *metadata = nullptr;
+        if(mUsePreparedStatement)
+            {
+            if(mPreparedStmt)
+                {
+                metadata = mysql_stmt_result_metadata(mPreparedStmt);
+                }
+            }
+        else
+            {
+            metadata = mResult;
+            }
+        // The map is not built until the metadata is available after execute.
+        if(metadata)
+            {
+            unsigned int numFields = mysql_num_fields(metadata);
+            MYSQL_FIELD *fields = mysql_fetch_fields(metadata);
+            for(unsigned int i=0; i<numFields; i++)
+                {
+                mColumnMap.addColumnName(fields[i].name);
+                }
+            mColumnMap.setBuilt();
+            if(mUsePreparedStatement)
+                {
+                // According to docs for mysql_stmt_result_metadata(),
+                // it says to free using mysql_free_result.
+                mysql_free_result(metadata);
+                }
+            }
+        }
+    }
+
+DbColumn DbStatement::findColumn(char const *columnName)
+    {
+    buildColumnMap();
+    return mColumnMap.findColumn(columnName);
+    }
+
+DbResult DbStatement::getColumn(char const *columnName, DbColumn &column)
+    {
+    DbResult result;
+    column = findColumn(columnName);
+    if(!column.isValid())
+        {
+        std::string errStr = "Unable to find column ";
+        errStr += columnName;
+        result.setNativeError(DEC_Misuse, 0, nullptr);
+        result.setError(errStr);
+        }
+    return result;
+    }
+
 DbResult DbStatement::getLastInsertedRowIndex(int64_t &lastInsertedRowIndex)
     {
     DbResult result;
@@ -820,5 +1788,6 @@ DbResult DbStatement::getLastInsertedRowIndex(int64_t &lastInsertedRowIndex)
     return result;
     }
 
-#endif
+}   // namespace DbMysql
 
+#endif
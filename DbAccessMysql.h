@@ -9,8 +9,8 @@
 
 /// This file contains wrapper classes that hides which database is used.
 
-#ifndef DB_ACCESS_SQLITE
-#define DB_ACCESS_SQLITE
+#ifndef DB_ACCESS_MYSQL
+#define DB_ACCESS_MYSQL
 
 // Include path on Windows may be "C:\Program Files\MySQL\MySQL Connector C 6.1\include"
 // Library path may be "C:\Program Files\MySQL\MySQL Connector C 6.1\lib"
@@ -18,15 +18,113 @@
 #include "mysql.h"
 #include "StringUtil.h"
 #include <stdint.h>
+#include <string.h>     // For strlen, strchr
 #include "DbResult.h"
+#include "DbColumnMap.h"
+#include "DbSqlScanner.h"
+#include "DbArray.h"
+#include "DbRowBuffer.h"
 #include <vector>
+#include <limits>
+#include <cmath>      // For std::isfinite
+#include <assert.h>
 
 typedef uint8_t byte;
 #define RETURN_DOUBLE_NULL_AS_NAN 1
-#define USE_PREPARED_STATEMENT 1
+// A query is prepared on the server once it has been executed this many times
+// on a connection. Until then, the adaptive mode uses a text query, which only
+// needs one round trip.
+#define PREPARE_AFTER_USES 2
+
+#include <unordered_map>
+
+enum DbPrepareModes
+    {
+    DPM_Text,           // Values are escaped and combined into a text query.
+    DPM_Prepared,       // Always use server side prepared statements.
+    DPM_Adaptive        // Use prepared statements for queries that are reused.
+    };
+// Values are bound to prepared statements unless a statement opts into the
+// adaptive or text mode with setPrepareMode().
+#define DEFAULT_PREPARE_MODE DPM_Prepared
+
+enum DbResultModes
+    {
+    DRM_Store,          // All rows are read to the client after the execute.
+    DRM_Cursor          // Rows are read from a server side cursor as needed.
+    };
+// The number of rows that are read from a cursor with each fetch request.
+#define DEFAULT_CURSOR_PREFETCH_ROWS 1000
+
+enum DbConnectOptions
+    {
+    DCO_None = 0,
+    DCO_LocalInfile = 0x1,  // Allow DbBulkLoader to send LOAD DATA LOCAL rows.
+    DCO_MultiStatements = 0x2   // Allow DbPipeline to send several statements.
+    };
+
+// The classes are in a namespace so that this can be compiled with the
+// SQLite backend. See DbAccess.h.
+namespace DbMysql
+{
+
+/// Keeps prepared statements for a connection, so that a query that is run
+/// many times is only prepared once. The key is the query text with "?"
+/// parameters. A statement is removed from the cache while it is in use,
+/// so two DbStatements never share a MYSQL_STMT.
+class DbMySqlStmtCache
+    {
+    public:
+        DbMySqlStmtCache():
+            mNumStatements(0), mUseCounter(0)
+            {}
+        ~DbMySqlStmtCache()
+            { close(); }
+
+        /// Returns a statement that is already prepared for the query, or
+        /// nullptr if the query is not in the cache.
+        MYSQL_STMT *acquire(std::string const &query);
+        /// Returns the statement to the cache. If the cache is full, the
+        /// least recently used statement is closed.
+        void release(std::string const &query, MYSQL_STMT *stmt);
+        /// Counts an execution of the query and returns the total count.
+        unsigned int countUse(std::string const &query);
+        /// Closes all statements. This must be done before the connection
+        /// is closed.
+        void close();
+
+    private:
+        // The MySQL server limits the number of prepared statements
+        // (max_prepared_stmt_count), so only a limited number are kept.
+        static const size_t MaxStatements = 64;
+        // Use counts are kept for more queries than statements so that the
+        // adaptive mode can find the reused queries.
+        static const size_t MaxQueries = 1024;
+        struct CacheEntry
+            {
+            MYSQL_STMT *mStmt;
+            unsigned int mUseCount;
+            uint64_t mLastUse;
+            };
+        std::unordered_map<std::string, CacheEntry> mEntries;
+        size_t mNumStatements;
+        uint64_t mUseCounter;
+
+        void evictStatement();
+    };
+
+class DbStatement;
+class DbTransaction;
+
+/// Statements that start or end a transaction.
+enum DbTransactionControls { DTC_None, DTC_Begin, DTC_End };
 
 /// Provides the overall access to the database.
 //
+// Each DbAccess is a separate connection. Different connections can be used
+// from different threads, but a connection and its statements must only be
+// used by one thread at a time.
+//
 // Example use (error handling is not shown):
 // Select:
 //      DbStatement stmt(db);
@@ -51,8 +149,14 @@ typedef uint8_t byte;
 class DbAccess
     {
     public:
+        // The types that are used with this backend. See DbBackend.h.
+        typedef DbMysql::DbStatement Statement;
+        typedef DbMysql::DbTransaction Transaction;
+        static constexpr int Database = DB_MYSQL;
+
         DbAccess():
-            mConnection(nullptr)
+            mConnection(nullptr), mUnfinishedStmt(nullptr), mConnectionGeneration(0),
+            mConnectOptions(DCO_None), mInTransaction(false)
             {}
 
         ~DbAccess()
@@ -63,20 +167,115 @@ class DbAccess
 
         /// Open the database.
         /// @param dbName This should be the database name without the path.
-        DbResult open(char const *dbName);
+        /// @param connectOptions A combination of DbConnectOptions. The
+        ///     server only allows LOAD DATA LOCAL if the client asks for it
+        ///     when connecting, so DCO_LocalInfile is needed for DbBulkLoader.
+        ///     Even then, local files are only sent by DbBulkLoader.
+        ///     DCO_MultiStatements is needed for DbPipeline. It allows any text
+        ///     query on the connection to contain several statements, so
+        ///     values must be escaped.
+        DbResult open(char const *dbName, int connectOptions=DCO_None);
         void close();
+        int getConnectOptions() const
+            { return mConnectOptions; }
+        /// Makes any request from the server for a local file fail. This is
+        /// done when the connection is opened, and after DbBulkLoader is
+        /// done with its own handler.
+        void refuseLocalFiles();
+        /// Closes and opens the connection again with the same name. Prepared
+        /// statements from the previous connection are no longer used.
+        DbResult reconnect();
+        /// Checks that the server connection is still working.
+        DbResult ping();
+        /// This is true after a statement such as START TRANSACTION or BEGIN,
+        /// until COMMIT or ROLLBACK. It is not known if autocommit is
+        /// turned off with SET, so that must not be used. Lost connections
+        /// are not reconnected during a transaction.
+        bool isInTransaction() const
+            { return mInTransaction; }
+        void setInTransaction(bool inTransaction)
+            { mInTransaction = inTransaction; }
+        /// Rolls back a transaction that was not ended. This does nothing if
+        /// there is no transaction.
+        DbResult rollback();
 
         MYSQL *getConnection()
             { return mConnection; }
+        /// This changes every time the connection is opened.
+        unsigned int getConnectionGeneration() const
+            { return mConnectionGeneration; }
+        DbMySqlStmtCache &getStmtCache()
+            { return mStmtCache; }
+
+        /// Only one statement on a connection can have results that have not
+        /// been read from the server. Before another statement sends a
+        /// command, the unfinished results of the previous statement are
+        /// closed. This is only used if results are not stored on the client.
+        void setUnfinishedResults(DbStatement *stmt)
+            { mUnfinishedStmt = stmt; }
+        void clearUnfinishedResults(DbStatement const *stmt)
+            {
+            if(mUnfinishedStmt == stmt)
+                { mUnfinishedStmt = nullptr; }
+            }
+        void finishUnfinishedResults(DbStatement const *stmt);
 
         DbResult getErrorInfo() const
             { return result; }
 
+        /// Returns a result with the native MySQL error number and error category.
+        /// Expected errors such as duplicate keys or lock timeouts do not
+        /// build any strings. Other errors also contain the MySQL message.
+        /// @param staticMsg This must be a string literal.
+        static DbResult getResult(unsigned int mysqlErr, char const *mysqlMsg,
+            char const *staticMsg);
+        static DbErrorCategory getErrorCategory(unsigned int mysqlErr);
+
     private:
         MYSQL *mConnection;
+        DbMySqlStmtCache mStmtCache;
+        DbStatement *mUnfinishedStmt;
+        std::string mDbName;
+        unsigned int mConnectionGeneration;
+        int mConnectOptions;
+        bool mInTransaction;
         DbResult result;
     };
 
+/// A bind parameter value with the native type. The text is only used for
+/// strings and blobs.
+struct DbBindValue
+    {
+    DbBindValue():
+        mType(MYSQL_TYPE_NULL), mInt(0), mDouble(0), mLength(0)
+        {}
+    enum_field_types mType;     // MYSQL_TYPE_NULL, LONGLONG, DOUBLE, STRING or BLOB
+    int64_t mInt;
+    double mDouble;
+    std::string mText;
+    unsigned long mLength;      // The length that MYSQL_BIND points to.
+    };
+
+/// A result column of a prepared statement. The bind type is chosen from
+/// the field metadata, so numbers and times are fetched as native values.
+struct DbResultColumn
+    {
+    DbResultColumn():
+        mBindType(MYSQL_TYPE_STRING), mInt(0), mDouble(0), mTime(),
+        mLength(0), mIsNull(0), mError(0)
+        {}
+    enum_field_types mBindType;
+    int64_t mInt;
+    double mDouble;
+    MYSQL_TIME mTime;
+    // The buffer for other columns. This grows when a value is truncated,
+    // and is kept for following rows.
+    std::vector<char> mText;
+    unsigned long mLength;
+    my_bool mIsNull;
+    my_bool mError;
+    };
+
 /// Provides the ability to execute statements to the database.
 class DbStatement
     {
@@ -84,14 +283,22 @@ class DbStatement
         // One way that this can be used is to make a long running prepared
         // statement, and then run small normal statements to get or set specific items.
         explicit DbStatement(DbAccess &db):
-            mDb(db), mPreparedStmt(nullptr),
-            mUsePreparedStatement(USE_PREPARED_STATEMENT), mDbDataState(DBS_Init),
-            mMultiRowSize(0), mMultiRowIndex(0), mMultiRowParams(0)
+            mMultiRowSize(0), mMultiRowIndex(0), mMultiRowParams(0),
+            mDbDataState(DBS_Init), mNumResultFields(0), mPreparedStmt(nullptr),
+            mPreparedGeneration(0), mIdempotent(false), mTransactionControl(DTC_None),
+            mResult(nullptr), mPreparedResult(nullptr),
+            mUsePreparedStatement(DEFAULT_PREPARE_MODE != DPM_Text),
+            mPrepareMode(DEFAULT_PREPARE_MODE), mResultMode(DRM_Store),
+            mPrefetchRows(DEFAULT_CURSOR_PREFETCH_ROWS), mDb(db)
             {}
 	    DbStatement(DbAccess &db, char const *query):
-            mDb(db), mPreparedStmt(nullptr),
-            mUsePreparedStatement(USE_PREPARED_STATEMENT), mDbDataState(DBS_Init),
-            mMultiRowSize(0), mMultiRowIndex(0), mMultiRowParams(0)
+            mMultiRowSize(0), mMultiRowIndex(0), mMultiRowParams(0),
+            mDbDataState(DBS_Init), mNumResultFields(0), mPreparedStmt(nullptr),
+            mPreparedGeneration(0), mIdempotent(false), mTransactionControl(DTC_None),
+            mResult(nullptr), mPreparedResult(nullptr),
+            mUsePreparedStatement(DEFAULT_PREPARE_MODE != DPM_Text),
+            mPrepareMode(DEFAULT_PREPARE_MODE), mResultMode(DRM_Store),
+            mPrefetchRows(DEFAULT_CURSOR_PREFETCH_ROWS), mDb(db)
 		    { set(query); }
         ~DbStatement()
             {
@@ -99,15 +306,43 @@ class DbStatement
             }
 
         void close();
+        /// Frees the results of the last execute. The prepared statement is kept.
+        void closeResults();
 
         void usePreparedStatement(bool prep)
-            { mUsePreparedStatement = prep; }
+            { setPrepareMode(prep ? DPM_Prepared : DPM_Text); }
+        /// The mode is used the next time the statement starts executing
+        /// the query.
+        void setPrepareMode(DbPrepareModes mode)
+            { mPrepareMode = mode; }
+        /// The cursor mode is for large result sets. The rows are kept on the
+        /// server, and only prefetchRows rows are in client memory at a time.
+        /// Other statements can be run on the connection while the rows are
+        /// read. This always uses a prepared statement. The mode is used the
+        /// next time the statement is executed.
+        void setResultMode(DbResultModes mode,
+            unsigned long prefetchRows = DEFAULT_CURSOR_PREFETCH_ROWS)
+            {
+            mResultMode = mode;
+            mPrefetchRows = prefetchRows;
+            }
+        /// If the connection is lost, an idempotent statement is executed
+        /// again after reconnecting. This is set by set() for queries that
+        /// only read, such as SELECT. Locking reads such as SELECT FOR UPDATE
+        /// are not idempotent. The retry is never done while the connection
+        /// is in a transaction, since the transaction is lost with the
+        /// connection. Use false for a query that calls a stored function
+        /// that has side effects.
+        void setIdempotent(bool idempotent)
+            { mIdempotent = idempotent; }
 
         // Set the query string. Bind the values for the query using bindValues().
-        // Resets the internal state.
+        // Resets the internal state. A prepared statement is kept, and is
+        // reused if the same query is set again.
         DbResult set(char const *query);
 
         // Resets the statement to the beginning. This does not clear bindings.
+        // A prepared statement is executed again without preparing.
         // This should be used to redo an insert, and then the bindings do not
         // need to be cleared.
 	    DbResult reset();
@@ -120,6 +355,7 @@ class DbStatement
         /// Start multiple row inserts. This is often many times faster than
         /// individual inserts. Make sure to call endMultiRowInsert() in order
         /// to store all data. This binds many values to during a single execute.
+        /// DbBatchInsert also limits the statement size to max_allowed_packet.
         void startMultiRowInsert(int numRows);
         DbResult endMultiRowInsert();
         bool isMultiRow() const
@@ -143,109 +379,138 @@ class DbStatement
         // Bind an array of strings in order.
         DbResult bindValues(std::vector<std::string> const &values);
 
-#define NULL_SQL_INDICATOR "\001"
         void bindNull(int ordinal)
-            { setBindValue(ordinal, NULL_SQL_INDICATOR); }
+            { setBindNull(ordinal); }
         void bindInt(int ordinal, int val)
-            {
-            std::string str = std::to_string(val);
-            setBindValue(ordinal, str.c_str());
-            }
+            { setBindInt(ordinal, val); }
         void bindInt(char const *param, int val)
             {
-            std::string str = std::to_string(val);
-            setBindValue(param, str.c_str());
+            for(int ord=findParam(param, 0); ord != 0; ord=findParam(param, ord))
+                { setBindInt(ord, val); }
             }
+        void bindInt64(int ordinal, int64_t val)
+            { setBindInt(ordinal, val); }
         void bindInt64(char const *param, int64_t val)
             {
-            std::string str = std::to_string(val);
-            setBindValue(param, str.c_str());
+            for(int ord=findParam(param, 0); ord != 0; ord=findParam(param, ord))
+                { setBindInt(ord, val); }
             }
         void bindFloat(int ordinal, float val)
-            {
-            std::string str = std::to_string(val);
-            setBindValue(ordinal, str.c_str());
-            }
+            { setBindDouble(ordinal, val); }
         void bindFloat(char const *param, float val)
-            { 
-            std::string str = std::to_string(val);
-            setBindValue(param, str.c_str());
-            }
+            { bindDouble(param, val); }
         void bindDouble(int ordinal, double val)
-            {
-            std::string str = std::to_string(val);
-            setBindValue(ordinal, str.c_str());
-            }
+            { setBindDouble(ordinal, val); }
         void bindDouble(char const *param, double val)
-            { 
-            std::string str = std::to_string(val);
-            setBindValue(param, str.c_str());
+            {
+            for(int ord=findParam(param, 0); ord != 0; ord=findParam(param, ord))
+                { setBindDouble(ord, val); }
             }
-        // WARNING - SQLITE_STATIC means that the val parameter must be around while
-        // the statement is executing.
+        // The text is copied, so it does not need to be kept while the
+        // statement is executing.
         void bindText(int ordinal, char const *val)
+            { setBindText(ordinal, val, strlen(val), MYSQL_TYPE_STRING); }
+        void bindText(char const *param, char const *val)
             {
-            setBindValue(ordinal, val);
+            for(int ord=findParam(param, 0); ord != 0; ord=findParam(param, ord))
+                { setBindText(ord, val, strlen(val), MYSQL_TYPE_STRING); }
             }
-        void bindText(char const *param, char const *val)
+        void bindBlob(int ordinal, const void *bytes, int elNumBytes)
             {
-            setBindValue(param, val);
+            setBindText(ordinal, static_cast<char const *>(bytes),
+                static_cast<size_t>(elNumBytes), MYSQL_TYPE_BLOB);
             }
-//        void bindBlob(int ordinal, const void *bytes, int elNumBytes)
-//            {
-//            }
+        /// Binds all values to a single parameter that is used with
+        /// DbString::WHERE_IN_ARRAY().
+        DbResult bindArray(int ordinal, DbArrayView<int64_t> values)
+            { return bindArrayJson(ordinal, values); }
+        DbResult bindArray(int ordinal, DbArrayView<std::string_view> values)
+            { return bindArrayJson(ordinal, values); }
+        DbResult bindArray(int ordinal, DbArrayView<std::string> values)
+            { return bindArrayJson(ordinal, values); }
 
         //********* Get values
 
         int getColumnInt(int columnIndex) const
-            { return std::stoi(mBindResults[columnIndex]); }
+            { return mRow.getFieldInt(columnIndex); }
         int64_t getColumnInt64(int columnIndex) const
-            { return std::stoll(mBindResults[columnIndex]); }
+            { return mRow.getFieldInt64(columnIndex); }
         bool getColumnBool(int columnIndex) const
-            { return mBindResults[columnIndex] != ""; }
+            { return mRow.getField(columnIndex).length() != 0; }
 #if(RETURN_DOUBLE_NULL_AS_NAN)
         double getColumnDouble(int columnIndex) const
             {
-            if(mBindResults[columnIndex].length() == 0)
+            if(mRow.isNull(columnIndex))
                 { return std::numeric_limits<double>::quiet_NaN(); }
             else
-                { return std::stod(mBindResults[columnIndex]); }
+                { return mRow.getFieldDouble(columnIndex); }
             }
 #else
         double getColumnDouble(int columnIndex) const
-            { return std::stod(mBindResults[columnIndex]); }
+            { return mRow.getFieldDouble(columnIndex); }
 #endif
-        // Since this must be called in order, this is removed.
-//    int getColumnBytes(int columnIndex) const
-//        { return mDb->sqlite3_column_bytes(mStatement, columnIndex); }
+        int getColumnBytes(int columnIndex) const
+            { return static_cast<int>(mRow.getField(columnIndex).length()); }
+        bool isColumnNull(int columnIndex) const
+            { return mRow.isNull(columnIndex); }
+        /// Returns the type that the value was fetched as. This is
+        /// MYSQL_TYPE_NULL for a NULL value. Prepared statements return
+        /// MYSQL_TYPE_LONGLONG, MYSQL_TYPE_DOUBLE, a time type or
+        /// MYSQL_TYPE_STRING. Text queries always return MYSQL_TYPE_STRING.
+        enum_field_types getColumnType(int columnIndex) const
+            {
+            size_t index = static_cast<size_t>(columnIndex);
+            enum_field_types type = MYSQL_TYPE_STRING;
+            if(mRow.isNull(index))
+                {
+                type = MYSQL_TYPE_NULL;
+                }
+            else if(mUsePreparedStatement && index < mResultColumns.size())
+                {
+                type = mResultColumns[index].mBindType;
+                }
+            return type;
+            }
 
-        /// This will return nullptr if the database contains NULL.
+        /// A NULL is returned as an empty string. The text is only valid
+        /// until the next row is read.
         char const *getColumnText(int columnIndex) const
-            { return mBindResults[columnIndex].c_str(); }
+            { return mRow.getFieldText(columnIndex); }
+        /// Gets a DATE, TIME, DATETIME or TIMESTAMP column. Prepared statements
+        /// fetch the native time, and text queries parse the text.
+        DbResult getColumnTime(int columnIndex, MYSQL_TIME &time) const;
         // columnIndex is base 0.
-        /// @todo - this could be made more efficient by not copying data.
         DbResult getColumnBlob(int columnIndex, std::vector<byte> &bytes)
             {
             DbResult result;
-            bytes.resize(mBindResults[columnIndex].size());
-            memcpy(bytes.data(), mBindResults[columnIndex].data(), bytes.size());
+            std::string_view field = mRow.getField(columnIndex);
+            bytes.assign(field.begin(), field.end());
             return result;
             }
 
+        /// Find a result column by name. The names are read from the field
+        /// metadata on the first call, so this is fast in row loops.
+        /// This must be called after the statement is executed, for example
+        /// after the first testRow().
+        DbResult getColumn(char const *columnName, DbColumn &column);
+        /// This is the same as getColumn, except that an invalid column is
+        /// returned without an error if the column does not exist.
+        DbColumn findColumn(char const *columnName);
+
         DbResult getLastInsertedRowIndex(int64_t &lastInsertedRowIndex);
 
-        static DbResult getDbResult(int sqliteErr)
+        /// The MySQL functions set their own errors, so this is always OK.
+        static DbResult getDbResult(int /*nativeErr*/)
             {
-            DbResult result;
-//            if(IS_SQLITE_ERROR(sqliteErr))
-//                { result.setError("Error with db"); }
-            return result;
+            return DbResult();
             }
         DbResult getErrorInfo() const
             { return mDb.getErrorInfo(); }
 
     private:
         std::string mQueryString;
+        // The bind parameters and the query with "?" parameters.
+        DbSqlScanner mQueryScan;
         // https://stackoverflow.com/questions/1176352/pdo-prepared-inserts-multiple-rows-in-single-query
         // This stuff has never been tested yet. Multiple row insert without prepared
         // statements was tested, and was 100 times (row size=200) faster than single row insert.
@@ -268,41 +533,239 @@ class DbStatement
             };
         enum DbDataStates mDbDataState;
 
-        // Used for normal or prepared statements.
-        std::vector<std::string> mBindValues;
-        std::vector<std::string> mBindResults;
+        // Used for normal or prepared statements. The prepared bind array
+        // points into these values, so they must not change between binding
+        // and executing.
+        std::vector<DbBindValue> mBindValues;
+        DbRowBuffer mRow;
+        // The number of fields is only read once for each result set.
+        unsigned int mNumResultFields;
 
         // Prepared statement storage
         MYSQL_STMT *mPreparedStmt;
+        // The query that mPreparedStmt is prepared with. This is empty if
+        // the statement is not prepared.
+        std::string mPreparedQuery;
+        // The connection generation that mPreparedStmt was prepared on.
+        unsigned int mPreparedGeneration;
+        bool mIdempotent;
+        // This is set from the query, and changes the transaction state of
+        // the connection when the statement succeeds.
+        DbTransactionControls mTransactionControl;
 
-        std::vector<unsigned long> mPreparedBindLengths;
-        std::vector<my_bool> mPreparedBindIsNull;
-        std::vector<my_bool> mPreparedBindError;
-        std::vector<std::string> mPreparedBindValues;   // buffers for SQL parameters;
         std::vector<MYSQL_BIND> mPreparedBindArray;     // full definitions of SQL parameters
 
-        std::vector<std::string> mPreparedResultStrings;    // buffers for returned field results
-        std::vector<my_bool> mPreparedResultIsNull;         // buffers for returned is null results
-        std::vector<unsigned long> mPreparedResultLengths;  // lengths of returned field results
+        // The result bind array points into the columns, so the columns
+        // must not be resized while the results are bound.
+        std::vector<DbResultColumn> mResultColumns;
         std::vector<MYSQL_BIND> mPreparedBindResultArray;   // definitions of returned field results
 
-        // MySQL requires ending results before starting a new query/execute.
-        // This may not be true for multi-threading.
-        // Making the result static allows cleaning up previous statements.
-        static MYSQL_RES *mResult;
-        static MYSQL_RES *mPreparedResult;
+        // MySQL requires ending results before starting a new query/execute
+        // on the same connection. This is tracked by DbAccess.
+        MYSQL_RES *mResult;
+        MYSQL_RES *mPreparedResult;
+        // This is set from the prepare mode when the query starts executing.
         bool mUsePreparedStatement;
+        DbPrepareModes mPrepareMode;
+        DbResultModes mResultMode;
+        unsigned long mPrefetchRows;
 
         DbAccess &mDb;
+        DbColumnMap mColumnMap;
+
+        // ordinal is base 1. The values are added as needed.
+        DbBindValue &getBindValue(int ordinal);
+        void setBindNull(int ordinal)
+            { getBindValue(ordinal).mType = MYSQL_TYPE_NULL; }
+        void setBindInt(int ordinal, int64_t val)
+            {
+            DbBindValue &value = getBindValue(ordinal);
+            value.mType = MYSQL_TYPE_LONGLONG;
+            value.mInt = val;
+            }
+        void setBindDouble(int ordinal, double val)
+            {
+            DbBindValue &value = getBindValue(ordinal);
+            value.mType = MYSQL_TYPE_DOUBLE;
+            value.mDouble = val;
+            }
+        void setBindText(int ordinal, char const *val, size_t len,
+            enum_field_types type);
+        // Returns the next ordinal after startOrdinal for the parameter name,
+        // or zero if there are no more. If the same name is used more than
+        // once in the query, all of the parameters with the name are found.
+        int findParam(char const *param, int startOrdinal) const;
+        template<typename T> DbResult bindArrayJson(int ordinal,
+            DbArrayView<T> values)
+            {
+            std::string json;
+            appendDbJsonArray(json, values);
+            setBindText(ordinal, json.data(), json.length(), MYSQL_TYPE_STRING);
+            return DbResult();
+            }
+        void buildColumnMap();
+        DbResult getResults(DbRowBuffer &row);
+        DbResult getNormalResults(DbRowBuffer &row);
+        DbResult getPreparedResults(DbRowBuffer &row);
+        DbResult bindPreparedResults();
+        DbResult fetchTruncatedColumn(unsigned int columnIndex);
+        DbResult bindPreparedParameters(MYSQL_STMT *stmt);
+        DbResult setCursorAttributes();
+        DbResult prepare(MYSQL *conn, std::string const &query);
+        DbResult executeOnce();
+        void releasePreparedStmt();
+    };
+
+/// Inserts many rows with a few multi-row INSERT statements. Each row is
+/// escaped and added to the statement text, and the statement is sent when
+/// the next row would exceed the server's max_allowed_packet or the row
+/// limit. Call flush() after the last row, and check its result.
+///
+/// Example:
+///      DbBatchInsert batch(db);
+///      batch.set("INSERT INTO Cat(catId, catName) VALUES(?, ?)");
+///      for(...)
+///          {
+///          batch.bindInt(1, id);
+///          batch.bindText(2, name);
+///          batch.addRow();
+///          }
+///      DbResult result = batch.flush();
+class DbBatchInsert
+    {
+    public:
+        /// @param maxRows The maximum number of rows for one statement.
+        explicit DbBatchInsert(DbAccess &db, size_t maxRows=1000):
+            mDb(db), mMaxRows(maxRows), mMaxPacketSize(0), mNumBatchRows(0),
+            mNumRows(0), mNumRoundTrips(0)
+            {}
+        /// Call flush() and check its result before this is destroyed. The
+        /// result of a flush here cannot be returned, so debug builds assert
+        /// that no rows are waiting to be sent.
+        ~DbBatchInsert()
+            {
+            assert(mNumBatchRows == 0);
+            flush();
+            }
+
+        /// The query must contain one row of values such as "VALUES(?, ?)".
+        /// Any text after the values, such as ON DUPLICATE KEY UPDATE, is kept.
+        DbResult set(char const *query);
 
         // ordinal is base 1.
-        void setBindValue(int ordinal, char const *str);
-        void setBindValue(char const *param, char const *str);
-        DbResult getResults(std::vector<std::string> &bindResults);
-        DbResult getNormalResults(std::vector<std::string> &bindResults);
-        DbResult getPreparedResults(std::vector<std::string> &bindResults);
-        DbResult bindPreparedParameters(MYSQL *conn, MYSQL_STMT *stmt,
-            std::vector<std::string> const &bindValues);
+        void bindNull(int ordinal)
+            { getValue(ordinal).mType = MYSQL_TYPE_NULL; }
+        void bindInt(int ordinal, int val)
+            { bindInt64(ordinal, val); }
+        void bindInt64(int ordinal, int64_t val)
+            {
+            DbBindValue &value = getValue(ordinal);
+            value.mType = MYSQL_TYPE_LONGLONG;
+            value.mInt = val;
+            }
+        /// Infinity and NaN are inserted as NULL, since MySQL has no value
+        /// for them, and one would fail every row of the batch.
+        void bindDouble(int ordinal, double val)
+            {
+            DbBindValue &value = getValue(ordinal);
+            value.mType = std::isfinite(val) ? MYSQL_TYPE_DOUBLE : MYSQL_TYPE_NULL;
+            value.mDouble = val;
+            }
+        void bindText(int ordinal, char const *val)
+            {
+            DbBindValue &value = getValue(ordinal);
+            value.mType = MYSQL_TYPE_STRING;
+            value.mText = val;
+            }
+
+        /// Adds the bound values as a row. This sends the previous rows first
+        /// if this row does not fit.
+        DbResult addRow();
+        /// Sends the rows that have not been sent.
+        DbResult flush();
+
+        size_t getNumRows() const
+            { return mNumRows; }
+        size_t getNumRoundTrips() const
+            { return mNumRoundTrips; }
+        double getRowsPerRoundTrip() const
+            {
+            return mNumRoundTrips ? static_cast<double>(mNumRows) / mNumRoundTrips : 0;
+            }
+
+    private:
+        DbAccess &mDb;
+        size_t mMaxRows;
+        size_t mMaxPacketSize;
+        // The query is split into "INSERT ... VALUES", the row "(?,?)" and
+        // any text after the row.
+        std::string mPrefix;
+        std::string mRowTemplate;
+        std::string mSuffix;
+        DbSqlScanner mRowScan;
+        std::vector<DbBindValue> mValues;
+        std::string mRowText;
+        std::string mBatchText;
+        size_t mNumBatchRows;
+        size_t mNumRows;
+        size_t mNumRoundTrips;
+
+        DbBindValue &getValue(int ordinal)
+            {
+            if(mValues.size() < static_cast<size_t>(ordinal))
+                { mValues.resize(ordinal); }
+            return mValues[ordinal-1];
+            }
+        DbResult readMaxPacketSize();
+    };
+
+/// Sends several statements to the server in one packet, which is one round
+/// trip. The connection must be opened with DCO_MultiStatements.
+/// The results are read in order with mysql_next_result. Any result rows are discarded, so
+/// this is for statements such as INSERT, UPDATE and COMMIT. The statements
+/// must not have bind parameters, so values must be escaped by the caller.
+/// Execution stops at the first statement that fails.
+///
+/// Example:
+///      db.open("localhost/dbname", DCO_MultiStatements);
+///      DbPipeline pipeline(db);
+///      pipeline.add("UPDATE Cat SET age=age+1");
+///      pipeline.add("DELETE FROM Dog WHERE age > 20");
+///      DbResult result = pipeline.execute();
+class DbPipeline
+    {
+    public:
+        explicit DbPipeline(DbAccess &db):
+            mDb(db), mNumStatements(0)
+            {}
+        /// The query must not end with a semicolon.
+        void add(char const *query);
+        /// Sends all added statements, then clears them. The affected rows
+        /// of each statement that ran are available until the next execute.
+        DbResult execute();
+        void clear()
+            {
+            mQuery.clear();
+            mNumStatements = 0;
+            mTransactionControls.clear();
+            }
+
+        size_t getNumStatements() const
+            { return mNumStatements; }
+        /// The number of statements that ran in the last execute. If a
+        /// statement failed, this is the index of the failed statement.
+        size_t getNumExecuted() const
+            { return mAffectedRows.size(); }
+        /// For SELECT statements, this is the number of rows.
+        uint64_t getAffectedRows(size_t index) const
+            { return mAffectedRows[index]; }
+
+    private:
+        DbAccess &mDb;
+        std::string mQuery;
+        size_t mNumStatements;
+        std::vector<uint64_t> mAffectedRows;
+        std::vector<DbTransactionControls> mTransactionControls;
     };
 
 /// Defines a transaction so that the transaction ends on destruction.
@@ -317,14 +780,26 @@ class DbTransaction
             end();
             }
         // By default, mysql runs with autocommit enabled. Not recommended for InnoDB tables.
+        // The commit and the start of the next transaction are one
+        // statement, so they take one round trip.
         void transact()
             {
             DbStatement stmt(dbAccess);
             stmt.usePreparedStatement(false);
-            DbResult result = end(stmt);
-            if(result.isOk())
+            stmt.set(dbAccess.isInTransaction() ? "COMMIT AND CHAIN" :
+                "START TRANSACTION");
+            stmt.execute();
+            }
+        /// Starts a transaction if the connection is not in one. The
+        /// constructor does not start one, since MySQL runs with autocommit.
+        void begin()
+            {
+            if(!dbAccess.isInTransaction())
                 {
-                start(stmt);
+                DbStatement stmt(dbAccess);
+                stmt.usePreparedStatement(false);
+                stmt.set("START TRANSACTION");
+                stmt.execute();
                 }
             }
         void end()
@@ -333,14 +808,17 @@ class DbTransaction
             stmt.usePreparedStatement(false);
             end(stmt);
             }
+        /// Discards the changes of the transaction.
+        void rollback()
+            {
+            DbStatement stmt(dbAccess);
+            stmt.usePreparedStatement(false);
+            stmt.set("ROLLBACK");
+            stmt.execute();
+            }
     private:
         DbAccess &dbAccess;
 
-        DbResult start(DbStatement &stmt)
-            {
-            stmt.set("START TRANSACTION");
-            return stmt.execute();
-            }
         DbResult end(DbStatement &stmt)
             {
             stmt.set("COMMIT");
@@ -355,5 +833,6 @@ class SQLiteMutex
             {}
     };
 
-#endif
+}   // namespace DbMysql
 
+#endif
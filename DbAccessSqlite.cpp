@@ -6,19 +6,23 @@
 */
 #define _CRT_SECURE_NO_WARNINGS 1
 #include <algorithm>    // for std:find()
+#include <stdio.h>      // For snprintf()
 #include <stdlib.h>     // For getenv()
 
 #include "DbAccess.h"
 #include "DbString.h"
 
-#if(DATABASE == DB_SQLITE)
+#if(DB_USE_SQLITE)
+
+namespace DbSqlite
+{
 
 static std::string getSqliteLibraryPath()
     {
     return "libsqlite3.so.0";
     }
 
-DbResult DbAccess::open(char const *dbName)
+DbResult DbAccess::open(char const *dbName, int openFlags)
     {
     DbResult result;
     bool gotDll = false;
@@ -29,17 +33,312 @@ DbResult DbAccess::open(char const *dbName)
         }
     if(!gotDll)
         {
-        result.setError("Unable to open sqlite3.dll");
-        result.insertContext(getDbResultString(getErrorInfo()));
+        result.setNativeError(DEC_Connection, 0, "Unable to open sqlite3.dll");
         }
     if(result.isOk())
 		{
-        if(IS_SQLITE_ERROR(SQLite::openDb(dbName)))
+        int retCode = SQLite::openDb(dbName, openFlags);
+        if(IS_SQLITE_ERROR(retCode))
             {
+            result = getResult(retCode, nullptr);
 			std::string errStr = "Unable to open database file ";
 			errStr += dbName;
-            result.setError(errStr);
-            result.insertContext(getDbResultString(getErrorInfo()));
+            result.insertContext(errStr);
+            }
+        }
+    if(result.isOk() && mResultCache)
+        {
+        invalidateAll();
+        setCacheHooks(true);
+        }
+    return result;
+    }
+
+// SQLite table and function names are not case sensitive.
+static std::string toLowerName(char const *name)
+    {
+    std::string lowerName = name ? name : "";
+    for(auto &c : lowerName)
+        {
+        if(c >= 'A' && c <= 'Z')
+            {
+            c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+    return lowerName;
+    }
+
+static void addTableName(std::vector<std::string> &tables, char const *table)
+    {
+    std::string name = toLowerName(table);
+    if(std::find(tables.begin(), tables.end(), name) == tables.end())
+        {
+        tables.push_back(name);
+        }
+    }
+
+// These functions can return a different value each time they are called.
+// The date and time functions only do so with 'now', but all calls are
+// treated the same.
+static bool isVolatileFunction(char const *function)
+    {
+    static char const *volatileFunctions[] =
+        {
+        "random", "randomblob", "changes", "total_changes", "last_insert_rowid",
+        "date", "time", "datetime", "julianday", "unixepoch", "strftime",
+        "timediff", "current_date", "current_time", "current_timestamp"
+        };
+    std::string name = toLowerName(function);
+    bool found = false;
+    for(auto const *volatileFunction : volatileFunctions)
+        {
+        if(name == volatileFunction)
+            {
+            found = true;
+            break;
+            }
+        }
+    return found;
+    }
+
+DbResult DbAccess::enableResultCache(size_t maxMemoryBytes)
+    {
+    DbResult result;
+    if(!getDb() || !getCapabilities().mResultCacheHooks)
+        {
+        result.setNativeError(DEC_Misuse, SQLITE_MISUSE,
+            "The result cache needs an open database and SQLite 3.14");
+        }
+    if(result.isOk())
+        {
+        mResultCache.reset(new DbResultCache(maxMemoryBytes));
+        setCacheHooks(true);
+        }
+    return result;
+    }
+
+void DbAccess::disableResultCache()
+    {
+    if(mResultCache)
+        {
+        setCacheHooks(false);
+        mResultCache.reset();
+        mCacheGeneration++;
+        }
+    }
+
+void DbAccess::setCacheHooks(bool enable)
+    {
+    if(getDb())
+        {
+        void *userData = enable ? this : nullptr;
+        sqlite3_set_authorizer(getDb(), enable ? authorizerCallback : nullptr,
+            userData);
+        sqlite3_update_hook(getDb(), enable ? updateCallback : nullptr, userData);
+        sqlite3_rollback_hook(getDb(), enable ? rollbackCallback : nullptr,
+            userData);
+        }
+    }
+
+void DbAccess::invalidateTable(std::string const &table)
+    {
+    mCacheGeneration++;
+    if(mResultCache)
+        {
+        mResultCache->invalidateTable(table);
+        }
+    }
+
+void DbAccess::invalidateAll()
+    {
+    mCacheGeneration++;
+    if(mResultCache)
+        {
+        mResultCache->clear();
+        }
+    }
+
+// This is called for each table, column and function while a statement is
+// prepared, including the statements of sqlite3_exec.
+int DbAccess::authorizerCallback(void *userData, int action, char const *arg1,
+    char const *arg2, char const * /*dbName*/, char const * /*trigger*/)
+    {
+    DbAccess *db = static_cast<DbAccess*>(userData);
+    DbStatementTables *tables = db->mRecordTables;
+    switch(action)
+        {
+        case SQLITE_READ:
+            if(tables)
+                {
+                addTableName(tables->mReadTables, arg1);
+                }
+            break;
+
+        case SQLITE_INSERT:
+        case SQLITE_UPDATE:
+        case SQLITE_DELETE:
+            if(tables)
+                {
+                addTableName(tables->mWriteTables, arg1);
+                }
+            break;
+
+        case SQLITE_FUNCTION:
+            if(tables && isVolatileFunction(arg2))
+                {
+                tables->mVolatile = true;
+                }
+            break;
+
+        case SQLITE_SELECT:
+        case SQLITE_RECURSIVE:
+            break;
+
+        case SQLITE_PRAGMA:
+        case SQLITE_TRANSACTION:
+        case SQLITE_SAVEPOINT:
+            if(tables)
+                {
+                tables->mVolatile = true;
+                }
+            break;
+
+        default:
+            // Everything else changes the schema, so the results are removed
+            // now, and again when the statement is executed.
+            db->invalidateAll();
+            if(tables)
+                {
+                tables->mChangesSchema = true;
+                }
+            break;
+        }
+    return SQLITE_OK;
+    }
+
+void DbAccess::updateCallback(void *userData, int /*op*/, char const * /*dbName*/,
+    char const *table, int64_t /*rowid*/)
+    {
+    DbAccess *db = static_cast<DbAccess*>(userData);
+    db->invalidateTable(toLowerName(table));
+    }
+
+void DbAccess::rollbackCallback(void *userData)
+    {
+    // Results that were read in the transaction may contain rolled back rows.
+    static_cast<DbAccess*>(userData)->invalidateAll();
+    }
+
+void DbAccess::SQLError(int retCode, char const *errMsg)
+    {
+    mLastErrorCode = retCode;
+    if(isDbErrorExpected(getErrorCategory(retCode)) || !errMsg)
+        {
+        mLastErrorMsg.clear();
+        }
+    else
+        {
+        mLastErrorMsg = errMsg;
+        }
+    }
+
+DbErrorCategory DbAccess::getErrorCategory(int sqliteErr)
+    {
+    DbErrorCategory category = DEC_None;
+    // Extended result codes contain the primary result code in the low byte.
+    switch(sqliteErr & 0xFF)
+        {
+        case SQLITE_OK:
+        case SQLITE_ROW:
+        case SQLITE_DONE:
+            break;
+
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+            category = DEC_Busy;
+            break;
+
+        case SQLITE_CONSTRAINT:
+            category = DEC_Constraint;
+            break;
+
+        case SQLITE_NOTFOUND:
+            category = DEC_NotFound;
+            break;
+
+        case SQLITE_CANTOPEN:
+            category = DEC_Connection;
+            break;
+
+        case SQLITE_IOERR:
+        case SQLITE_CORRUPT:
+        case SQLITE_FULL:
+            category = DEC_Io;
+            break;
+
+        case SQLITE_MISMATCH:
+        case SQLITE_MISUSE:
+        case SQLITE_RANGE:
+            category = DEC_Misuse;
+            break;
+
+        default:
+            category = DEC_Other;
+            break;
+        }
+    return category;
+    }
+
+DbResult DbAccess::getResult(int sqliteErr, char const *staticMsg) const
+    {
+    DbResult result;
+    DbErrorCategory category = getErrorCategory(sqliteErr);
+    if(category == DEC_None)
+        {
+        // The step did not return an error, but was not the expected value.
+        category = DEC_Other;
+        }
+    if(isDbErrorExpected(category) || mLastErrorMsg.length() == 0 ||
+        sqliteErr != mLastErrorCode)
+        {
+        result.setNativeError(category, sqliteErr, staticMsg);
+        }
+    else
+        {
+        result.setNativeError(category, sqliteErr, nullptr);
+        result.setError(mLastErrorMsg);
+        if(staticMsg)
+            {
+            result.insertStaticContext(staticMsg);
+            }
+        }
+    return result;
+    }
+
+void DbAccess::captureExecution(char const *sql, DbCaptureLog::Clock::time_point start)
+    {
+    if(mCaptureLog)
+        {
+        DbCapturedExecution exec;
+        exec.mSqlId = mCaptureLog->getSqlId(sql);
+        exec.mStartNs = mCaptureLog->getNs(start);
+        exec.mDurationNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+            DbCaptureLog::Clock::now() - start).count());
+        mCaptureLog->writeExecution(exec);
+        }
+    }
+
+DbResult DbAccess::getErrorInfo() const
+    {
+    DbResult result;
+    if(IS_SQLITE_ERROR(mLastErrorCode))
+        {
+        result.setNativeError(getErrorCategory(mLastErrorCode), mLastErrorCode,
+            nullptr);
+        if(mLastErrorMsg.length() > 0)
+            {
+            result.setError(mLastErrorMsg);
             }
         }
     return result;
@@ -71,6 +370,27 @@ DbResult DbAccess::setCaching(int cacheSize, int pageSize)
     return result;
     }
 
+// SQLite allocates the memory when the buffer is nullptr.
+DbResult DbAccess::setLookaside(int slotSize, int numSlots)
+    {
+    DbResult result;
+    if(getDb() && getCapabilities().mDbConfig)
+        {
+        int retCode = sqlite3_db_config(getDb(), SQLITE_DBCONFIG_LOOKASIDE,
+            nullptr, slotSize, numSlots);
+        if(IS_SQLITE_ERROR(retCode))
+            {
+            result = getResult(retCode, "Unable to set lookaside");
+            }
+        }
+    else
+        {
+        result.setNativeError(DEC_Misuse, SQLITE_MISUSE,
+            "Lookaside needs an open database and SQLite 3.7");
+        }
+    return result;
+    }
+
 static std::string osPathJoin(std::string const &dir, std::string const &fn)
     {
     std::string joinedStr = dir;
@@ -82,62 +402,417 @@ static std::string osPathJoin(std::string const &dir, std::string const &fn)
     return (joinedStr + fn);
     }
 
-DbResult DbStatement::set(char const *query)
+DbResult DbStatement::set(char const *query, unsigned int prepareFlags)
     {
     DbResult result;
-    int retCode = SQLiteStatement::set(query);
+    mColumnMap.clear();
+    finishCapture(0);
+    endResultCache();
+    mCaptureExec.mBinds.clear();
+    mTables.clear();
+    mDoubleBound = false;
+    // The authorizer only records the tables while the statement is prepared.
+    if(mDb.mResultCache)
+        {
+        mDb.mRecordTables = &mTables;
+        }
+    int retCode = SQLiteStatement::set(query, prepareFlags);
+    mDb.mRecordTables = nullptr;
     if(!IS_SQLITE_OK(retCode))
         {
-        result.setError("Unable to set statement");
-        result.insertContext(getDbResultString(getErrorInfo()));
+        result = mDb.getResult(retCode, "Unable to set statement");
         }
+    // The generation of a valid log is never zero, so the SQL id is found
+    // again at the next step.
+    mCaptureGeneration = 0;
     return result;
     }
 
+int DbStatement::reset()
+    {
+    finishCapture(0);
+    endResultCache();
+    return SQLiteStatement::reset();
+    }
+
+// Only results that the caller read to the end are cached. A partial copy
+// is discarded, so that a caller that only reads the first row of a large
+// result does not pay to read the rest.
+void DbStatement::endResultCache()
+    {
+    mFillRows.reset();
+    mStepped = false;
+    mCachedRows.reset();
+    }
+
+// This is called for the first step after a set or reset. A write removes the
+// results of the tables that it writes. A cacheable query either finds its
+// rows in the result cache, or starts copying the rows from the database.
+void DbStatement::startStep(bool readRows)
+    {
+    mStepped = true;
+    if(mDb.mCaptureLog && mCaptureGeneration != mDb.mCaptureGeneration)
+        {
+        char const *sql = mDb.sqlite3_sql(getStatement());
+        if(sql)
+            {
+            mCaptureExec.mSqlId = mDb.mCaptureLog->getSqlId(sql);
+            mCaptureGeneration = mDb.mCaptureGeneration;
+            }
+        }
+    if(mDb.mCaptureLog && mCaptureGeneration == mDb.mCaptureGeneration)
+        {
+        mCapturing = true;
+        mCaptureExec.mNumRows = 0;
+        mCaptureStart = DbCaptureLog::Clock::now();
+        }
+    DbResultCache *cache = mDb.mResultCache.get();
+    if(cache)
+        {
+        if(mTables.mChangesSchema)
+            {
+            mDb.invalidateAll();
+            }
+        for(auto const &table : mTables.mWriteTables)
+            {
+            mDb.invalidateTable(table);
+            }
+        if(readRows && mTables.isCacheable() && !mDoubleBound)
+            {
+            char *expandedSql = mDb.sqlite3_expanded_sql(getStatement());
+            if(expandedSql)
+                {
+                mCacheKey = expandedSql;
+                mDb.sqlite3_free(expandedSql);
+                int numColumns = SQLiteStatement::getColumnCount();
+                mCachedRows = cache->find(mCacheKey);
+                // The column count changes if a table is altered.
+                if(mCachedRows && mCachedRows->getNumColumns() == numColumns)
+                    {
+                    mNextCachedRowIndex = 0;
+                    mCachedTextValues.resize(static_cast<size_t>(numColumns));
+                    }
+                else
+                    {
+                    mCachedRows.reset();
+                    mFillRows = std::make_shared<DbCachedRows>(numColumns);
+                    for(int i=0; i<numColumns; i++)
+                        {
+                        mFillRows->addColumnName(SQLiteStatement::getColumnName(i));
+                        }
+                    mFillGeneration = mDb.mCacheGeneration;
+                    }
+                }
+            }
+        }
+    }
+
+void DbStatement::addFillRow()
+    {
+    DbCachedRows &rows = *mFillRows;
+    for(int i=0; i<rows.getNumColumns(); i++)
+        {
+        int type = SQLiteStatement::getColumnType(i);
+        switch(type)
+            {
+            case SQLITE_INTEGER:
+                rows.addInt(SQLiteStatement::getColumnInt64(i));
+                break;
+
+            case SQLITE_FLOAT:
+                rows.addDouble(SQLiteStatement::getColumnDouble(i));
+                break;
+
+            case SQLITE_NULL:
+                rows.addNull();
+                break;
+
+            default:
+                {
+                int numBytes;
+                void const *bytes = SQLiteStatement::getColumnBlob(i, numBytes);
+                if(type == SQLITE_BLOB)
+                    {
+                    rows.addBlob(bytes, static_cast<size_t>(numBytes));
+                    }
+                else
+                    {
+                    rows.addText(static_cast<char const *>(bytes),
+                        static_cast<size_t>(numBytes));
+                    }
+                }
+                break;
+            }
+        }
+    // Large results would remove many smaller results, so they are not cached.
+    if(!mDb.mResultCache ||
+        rows.getMemoryBytes() > mDb.mResultCache->getStats().mMaxMemoryBytes / 4)
+        {
+        mFillRows.reset();
+        }
+    }
+
+void DbStatement::finishFill()
+    {
+    if(mDb.mResultCache && mFillGeneration == mDb.mCacheGeneration)
+        {
+        mFillRows->shrink();
+        mDb.mResultCache->insert(mCacheKey, mTables.mReadTables, mFillRows);
+        }
+    mFillRows.reset();
+    }
+
+double DbStatement::getCachedDouble(int columnIndex) const
+    {
+#if(RETURN_DOUBLE_NULL_AS_NAN)
+    if(mCachedRows->getType(mCachedRowIndex, columnIndex) == DbCachedRows::CVT_Null)
+        { return std::numeric_limits<double>::quiet_NaN(); }
+#endif
+    return mCachedRows->getDouble(mCachedRowIndex, columnIndex);
+    }
+
+int DbStatement::getCachedType(int columnIndex) const
+    {
+    int type = SQLITE_NULL;
+    switch(mCachedRows->getType(mCachedRowIndex, columnIndex))
+        {
+        case DbCachedRows::CVT_Int:     type = SQLITE_INTEGER;  break;
+        case DbCachedRows::CVT_Double:  type = SQLITE_FLOAT;    break;
+        case DbCachedRows::CVT_Text:    type = SQLITE_TEXT;     break;
+        case DbCachedRows::CVT_Blob:    type = SQLITE_BLOB;     break;
+        case DbCachedRows::CVT_Null:    break;
+        }
+    return type;
+    }
+
+// Numbers are converted to text in the same way as SQLite. The text is valid
+// until the next row.
+char const *DbStatement::getCachedText(int columnIndex) const
+    {
+    char const *text = nullptr;
+    char buf[32];
+    switch(mCachedRows->getType(mCachedRowIndex, columnIndex))
+        {
+        case DbCachedRows::CVT_Int:
+            snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(
+                mCachedRows->getInt(mCachedRowIndex, columnIndex)));
+            mCachedTextValues[columnIndex] = buf;
+            text = mCachedTextValues[columnIndex].c_str();
+            break;
+
+        case DbCachedRows::CVT_Double:
+            snprintf(buf, sizeof(buf), "%.15g",
+                mCachedRows->getDouble(mCachedRowIndex, columnIndex));
+            mCachedTextValues[columnIndex] = buf;
+            if(mCachedTextValues[columnIndex].find_first_of(".eni") == std::string::npos)
+                {
+                mCachedTextValues[columnIndex] += ".0";
+                }
+            text = mCachedTextValues[columnIndex].c_str();
+            break;
+
+        case DbCachedRows::CVT_Text:
+        case DbCachedRows::CVT_Blob:
+            text = mCachedRows->getText(mCachedRowIndex, columnIndex);
+            break;
+
+        case DbCachedRows::CVT_Null:
+            break;
+        }
+    return text;
+    }
+
 DbResult DbStatement::testRow(bool &gotRow)
     {
-    int retCode = SQLiteStatement::step();
-    gotRow = (retCode == SQLITE_ROW);
     DbResult result;
-    if(!IS_SQLITE_OK(retCode))
+    if(!mStepped)
+        {
+        startStep(true);
+        }
+    if(mCachedRows)
+        {
+        gotRow = (mNextCachedRowIndex < mCachedRows->getNumRows());
+        if(gotRow)
+            {
+            mCachedRowIndex = mNextCachedRowIndex++;
+            }
+        finishCaptureStep(gotRow ? SQLITE_ROW : SQLITE_DONE);
+        }
+    else
         {
-        result.setError("Unable to test row");
-        result.insertContext(getDbResultString(getErrorInfo()));
+        int retCode = SQLiteStatement::step();
+        gotRow = (retCode == SQLITE_ROW);
+        if(!IS_SQLITE_OK(retCode))
+            {
+            result = mDb.getResult(retCode, "Unable to test row");
+            }
+        finishCaptureStep(retCode);
+        if(mFillRows)
+            {
+            if(gotRow)
+                {
+                addFillRow();
+                }
+            else if(retCode == SQLITE_DONE)
+                {
+                finishFill();
+                }
+            else
+                {
+                mFillRows.reset();
+                }
+            }
         }
     return result;
     }
 
+void DbStatement::captureBind(int ordinal, DbCaptureValueTypes type, int64_t intVal,
+    double doubleVal, char const *text, size_t len)
+    {
+    if(ordinal > 0)
+        {
+        size_t index = static_cast<size_t>(ordinal - 1);
+        if(index >= mCaptureExec.mBinds.size())
+            {
+            mCaptureExec.mBinds.resize(index + 1);
+            }
+        DbCapturedValue &value = mCaptureExec.mBinds[index];
+        value.mType = type;
+        value.mInt = intVal;
+        value.mDouble = doubleVal;
+        if(text)
+            {
+            value.mText.assign(text, len);
+            }
+        else
+            {
+            value.mText.clear();
+            if(type == DCV_Text)
+                {
+                value.mType = DCV_Null;
+                }
+            }
+        }
+    }
+
+void DbStatement::finishCaptureStep(int retCode)
+    {
+    if(mCapturing)
+        {
+        if(retCode == SQLITE_ROW)
+            {
+            mCaptureExec.mNumRows++;
+            }
+        else
+            {
+            finishCapture(retCode);
+            }
+        }
+    }
+
+// The log may have been changed or removed since the execution started, so
+// then the execution is not written.
+void DbStatement::finishCapture(int retCode)
+    {
+    if(mCapturing)
+        {
+        mCapturing = false;
+        DbCaptureLog *log = mDb.mCaptureLog;
+        if(log && mCaptureGeneration == mDb.mCaptureGeneration)
+            {
+            mCaptureExec.mStartNs = log->getNs(mCaptureStart);
+            mCaptureExec.mDurationNs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                DbCaptureLog::Clock::now() - mCaptureStart).count());
+            mCaptureExec.mNativeCode = IS_SQLITE_ERROR(retCode) ? retCode : 0;
+            log->writeExecution(mCaptureExec);
+            }
+        }
+    }
+
 DbResult DbStatement::getRow()
     {
     bool gotRow;
     DbResult result = testRow(gotRow);
     if(result.isOk() && !gotRow)
         {
-        result.setError("Unable to get row");
-        result.insertContext(getDbResultString(getErrorInfo()));
+        result.setNativeError(DEC_NotFound, SQLITE_DONE, "Unable to get row");
         }
     return result;
     }
 
 DbResult DbStatement::execute()
     { 
+    if(!mStepped)
+        {
+        startStep(false);
+        }
     int retCode = SQLiteStatement::step();
+    finishCapture(retCode);
     // SQLITE_ROW is returned from pragma executing.
     bool executed = (retCode == SQLITE_DONE || retCode == SQLITE_ROW);
     DbResult result;
     if(!IS_SQLITE_OK(retCode) || !executed)
         {
-        result.setError("Unable to execute");
-        result.insertContext(getDbResultString(getErrorInfo()));
+        result = mDb.getResult(retCode, "Unable to execute");
         }
     return result;
     }
 
+void DbStatement::buildColumnMap()
+    {
+    if(!mColumnMap.isBuilt())
+        {
+        int numColumns = getColumnCount();
+        for(int i=0; i<numColumns; i++)
+            {
+            mColumnMap.addColumnName(getColumnName(i));
+            }
+        mColumnMap.setBuilt();
+        }
+    }
+
+DbColumn DbStatement::findColumn(char const *columnName)
+    {
+    buildColumnMap();
+    return mColumnMap.findColumn(columnName);
+    }
+
+DbResult DbStatement::getColumn(char const *columnName, DbColumn &column)
+    {
+    DbResult result;
+    column = findColumn(columnName);
+    if(!column.isValid())
+        {
+        std::string errStr = "Unable to find column ";
+        errStr += columnName;
+        result.setNativeError(DEC_Misuse, SQLITE_RANGE, nullptr);
+        result.setError(errStr);
+        }
+    return result;
+    }
+
+void const *DbStatement::getColumnBlob(int columnIndex, int &numBytes) const
+    {
+    void const *blob;
+    if(mCachedRows)
+        {
+        std::string_view bytes = mCachedRows->getBytes(mCachedRowIndex, columnIndex);
+        blob = bytes.empty() ? nullptr : bytes.data();
+        numBytes = static_cast<int>(bytes.length());
+        }
+    else
+        {
+        blob = SQLiteStatement::getColumnBlob(columnIndex, numBytes);
+        }
+    return blob;
+    }
+
 DbResult DbStatement::getColumnBlob(int columnIndex, std::vector<byte> &bytes)
     {
     DbResult result;
     int numBytes;
-    void const *blob = SQLiteStatement::getColumnBlob(columnIndex, numBytes);
+    void const *blob = getColumnBlob(columnIndex, numBytes);
     if(blob)
         {
         /// @todo - there is an extra memory copy here.
@@ -176,8 +851,49 @@ DbResult DbStatement::bindValues(std::vector<std::string> const &values)
             errStr += value;
             errStr += ", ";
             }
+        result.setNativeError(DEC_Misuse, SQLITE_RANGE, nullptr);
         result.setError(errStr.c_str());
-        result.insertContext(getDbResultString(getErrorInfo()));
+        }
+    return result;
+    }
+
+void DbTransaction::begin()
+    {
+    if(!isInTransaction())
+        {
+        auto start = DbCaptureLog::Clock::now();
+        SQLiteTransaction::begin();
+        mDb.captureExecution("BEGIN TRANSACTION", start);
+        }
+    }
+
+void DbTransaction::end()
+    {
+    if(isInTransaction())
+        {
+        auto start = DbCaptureLog::Clock::now();
+        SQLiteTransaction::end();
+        mDb.captureExecution("END TRANSACTION", start);
+        }
+    }
+
+void DbTransaction::rollback()
+    {
+    if(isInTransaction())
+        {
+        auto start = DbCaptureLog::Clock::now();
+        SQLiteTransaction::rollback();
+        mDb.captureExecution("ROLLBACK TRANSACTION", start);
+        }
+    }
+
+DbResult DbBatchInsert::addRow()
+    {
+    DbResult result = mStmt.execute();
+    mStmt.reset();
+    if(result.isOk())
+        {
+        mNumRows++;
         }
     return result;
     }
@@ -198,5 +914,6 @@ DbResult DbStatement::getLastInsertedRowIndex(int64_t &lastInsertedRowId)
     return result;
     }
 
-#endif
+}   // namespace DbSqlite
 
+#endif
@@ -14,46 +14,161 @@
 
 #include "SQLite.h"
 #include "DbResult.h"
+#include "DbColumnMap.h"
+#include "DbArray.h"
+#include "DbResultCache.h"
+#include "DbCapture.h"
 //#include <cstddef>		// For std::byte
 #ifdef __linux__
 typedef unsigned char byte;
 #endif
+#include <memory>
 #include <vector>
 
+// The classes are in a namespace so that this can be compiled with the
+// MySQL backend. See DbAccess.h.
+namespace DbSqlite
+{
+
+class DbStatement;
+class DbTransaction;
+
+/// The tables that a statement uses. The authorizer fills this while the
+/// statement is prepared.
+struct DbStatementTables
+    {
+    DbStatementTables():
+        mVolatile(false), mChangesSchema(false)
+        {}
+    void clear()
+        {
+        mReadTables.clear();
+        mWriteTables.clear();
+        mVolatile = false;
+        mChangesSchema = false;
+        }
+    bool isCacheable() const
+        {
+        return !mReadTables.empty() && mWriteTables.empty() && !mVolatile &&
+            !mChangesSchema;
+        }
+    // The table names are lower case.
+    std::vector<std::string> mReadTables;
+    std::vector<std::string> mWriteTables;
+    // The result can change without a table change, such as with random().
+    bool mVolatile;
+    bool mChangesSchema;
+    };
+
 /// Provides the overall access to the database.
 class DbAccess:public SQLite, public SQLiteListener
     {
     public:
+        // The types that are used with this backend. See DbBackend.h.
+        typedef DbSqlite::DbStatement Statement;
+        typedef DbSqlite::DbTransaction Transaction;
+        static constexpr int Database = DB_SQLITE;
+
         DbAccess():
-            pragmaSetCaching(false), transactSeconds(5)
+            mLastErrorCode(SQLITE_OK), pragmaSetCaching(false), transactSeconds(5),
+            mCacheGeneration(0), mRecordTables(nullptr), mCaptureLog(nullptr),
+            mCaptureGeneration(0)
             {
             setListener(this);
             }
         /// Open the database.
         /// @param dbName This should be the database name without the path.
-        DbResult open(char const *dbName);
+        /// @param openFlags The SQLITE_OPEN_... flags. Use SQLITE_OPEN_NOMUTEX
+        ///     if only one thread at a time uses this connection.
+        DbResult open(char const *dbName,
+            int openFlags=SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
         int getTransactSeconds()
             { return transactSeconds; }
 
         /// This is for optimization. This will only be set if the sizes were
         /// not set in the pragma config file.
         DbResult setCaching(int cacheSize=-1, int pageSize=-1);
-        DbResult getErrorInfo() const
-            { return SqlErrorResult; }
+        /// This is for optimization. The lookaside memory is used for small
+        /// allocations of this connection. This must be called after open()
+        /// and before any statements are set.
+        DbResult setLookaside(int slotSize, int numSlots);
+        /// This builds strings for the last error, so it should only be used
+        /// for reporting. Use getResult() to check errors.
+        DbResult getErrorInfo() const;
+
+        /// Returns a result with the native SQLite code and error category.
+        /// Expected errors such as SQLITE_CONSTRAINT or SQLITE_BUSY do not
+        /// build any strings. Other errors also contain the SQLite message.
+        /// @param staticMsg This must be a string literal.
+        DbResult getResult(int sqliteErr, char const *staticMsg) const;
+        static DbErrorCategory getErrorCategory(int sqliteErr);
 
         /// Define this in the derived class to handle SQL errors.
-        virtual void SQLError(int /*retCode*/, char const *errMsg) override
-            {
-            SqlErrorResult.setWarning(errMsg);
-            }
+        virtual void SQLError(int retCode, char const *errMsg) override;
         virtual void SQLResultCallback(int /*numColumns*/, char ** /*colVal*/,
             char ** /*colName*/)
             {}
 
+        /// Keeps the rows of queries so that a repeated query with the same
+        /// bound values does not run again. The tables that each query reads
+        /// are found when the statement is set, and the results are removed
+        /// when a table is written on this connection, when the schema
+        /// changes, or on a rollback. Writes from other connections are not
+        /// seen, so only use this when this connection is the only writer.
+        /// Statements that are set before this is called are not cached,
+        /// and their writes are only seen for rowid tables, so call this
+        /// after open(). Queries that use random() or date and time
+        /// functions, and statements with bound doubles, are not cached.
+        /// A result is only cached if its rows are read to the end.
+        /// This needs SQLite 3.14 or later.
+        DbResult enableResultCache(size_t maxMemoryBytes);
+        void disableResultCache();
+        bool isResultCacheEnabled() const
+            { return mResultCache != nullptr; }
+        DbResultCacheStats getResultCacheStats() const
+            {
+            return mResultCache ? mResultCache->getStats() : DbResultCacheStats();
+            }
+
+        /// Records the executions of statements and transactions in the log,
+        /// so that they can be replayed with DbReplay. Statements that were
+        /// set before this is called are also recorded, but values that were
+        /// bound before this is called are not. Set this to nullptr to stop
+        /// recording. The log must exist until then.
+        void setCaptureLog(DbCaptureLog *log)
+            {
+            mCaptureLog = log;
+            mCaptureGeneration++;
+            }
+        /// Records an execution that is not run with a DbStatement.
+        void captureExecution(char const *sql, DbCaptureLog::Clock::time_point start);
+
     private:
-        DbResult SqlErrorResult;
+        friend class DbStatement;
+        // The message is only copied for unexpected errors.
+        int mLastErrorCode;
+        std::string mLastErrorMsg;
         bool pragmaSetCaching;
         int transactSeconds;
+        std::unique_ptr<DbResultCache> mResultCache;
+        // This changes whenever cached results are removed, so that a result
+        // that was read during a write is not added.
+        uint64_t mCacheGeneration;
+        // This is only set while a DbStatement is prepared.
+        DbStatementTables *mRecordTables;
+        DbCaptureLog *mCaptureLog;
+        // This changes whenever the log changes, so that a statement gets
+        // its SQL id again from the new log.
+        uint64_t mCaptureGeneration;
+
+        void setCacheHooks(bool enable);
+        void invalidateTable(std::string const &table);
+        void invalidateAll();
+        static int authorizerCallback(void *userData, int action, char const *arg1,
+            char const *arg2, char const *dbName, char const *trigger);
+        static void updateCallback(void *userData, int op, char const *dbName,
+            char const *table, int64_t rowid);
+        static void rollbackCallback(void *userData);
     };
 
 /// Provides the ability to execute statements to the database.
@@ -61,13 +176,33 @@ class DbStatement:public SQLiteStatement
     {
     public:
         explicit DbStatement(DbAccess &db):
-            SQLiteStatement(db), mDb(db)
+            SQLiteStatement(db), mDb(db), mDoubleBound(false), mStepped(false),
+            mCachedRowIndex(0), mNextCachedRowIndex(0), mFillGeneration(0),
+            mCaptureGeneration(0), mCapturing(false)
             {}
         DbStatement(DbAccess &db, char const *query):
-	    SQLiteStatement(db, query), mDb(db)
-            {}
+	    SQLiteStatement(db), mDb(db), mDoubleBound(false), mStepped(false),
+            mCachedRowIndex(0), mNextCachedRowIndex(0), mFillGeneration(0),
+            mCaptureGeneration(0), mCapturing(false)
+            { set(query); }
+        ~DbStatement()
+            {
+            finishCapture(0);
+            endResultCache();
+            }
         // Set the query string. Bind the values for the query using bindValues().
-        DbResult set(char const *query);
+        /// @param prepareFlags Use SQLITE_PREPARE_PERSISTENT for statements
+        ///     that are kept and run many times.
+        DbResult set(char const *query, unsigned int prepareFlags=0);
+        // These hide the SQLiteStatement functions so that the result cache
+        // and the capture log know when a query starts again.
+        int reset();
+        int clearBindings()
+            {
+            mDoubleBound = false;
+            mCaptureExec.mBinds.clear();
+            return SQLiteStatement::clearBindings();
+            }
 
         // If the query is failing, make sure the bound values are in memory.
         // Search for SQLITE_STATIC in the code for more info.
@@ -85,18 +220,184 @@ class DbStatement:public SQLiteStatement
         DbResult endMultiRowInsert()
             { return DbResult(); }
 
-        // columnIndex is base 0.
+        /// Find a result column by name. The names are read from the prepared
+        /// statement on the first call, so this is fast in row loops.
+        DbResult getColumn(char const *columnName, DbColumn &column);
+        /// This is the same as getColumn, except that an invalid column is
+        /// returned without an error if the column does not exist.
+        DbColumn findColumn(char const *columnName);
+
+        // These return the cached names when the rows are from the result
+        // cache.
+        int getColumnCount() const
+            {
+            return mCachedRows ? mCachedRows->getNumColumns() :
+                SQLiteStatement::getColumnCount();
+            }
+        char const *getColumnName(int columnIndex) const
+            {
+            return mCachedRows ? mCachedRows->getColumnName(columnIndex) :
+                SQLiteStatement::getColumnName(columnIndex);
+            }
+
+        // columnIndex is base 0. These return the cached values when the
+        // rows are from the result cache.
+        // Returns SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL.
+        int getColumnType(int columnIndex) const
+            {
+            return mCachedRows ? getCachedType(columnIndex) :
+                SQLiteStatement::getColumnType(columnIndex);
+            }
+        int getColumnInt(int columnIndex) const
+            {
+            return mCachedRows ? static_cast<int>(mCachedRows->getInt(
+                mCachedRowIndex, columnIndex)) : SQLiteStatement::getColumnInt(columnIndex);
+            }
+        int64_t getColumnInt64(int columnIndex) const
+            {
+            return mCachedRows ? mCachedRows->getInt(mCachedRowIndex, columnIndex) :
+                SQLiteStatement::getColumnInt64(columnIndex);
+            }
+        bool getColumnBool(int columnIndex) const
+            { return(getColumnInt(columnIndex) != 0); }
+        double getColumnDouble(int columnIndex) const
+            {
+            return mCachedRows ? getCachedDouble(columnIndex) :
+                SQLiteStatement::getColumnDouble(columnIndex);
+            }
+        /// This will return nullptr if the database contains NULL.
+        char const *getColumnText(int columnIndex) const
+            {
+            return mCachedRows ? getCachedText(columnIndex) :
+                SQLiteStatement::getColumnText(columnIndex);
+            }
+        void const *getColumnBlob(int columnIndex, int &numBytes) const;
         DbResult getColumnBlob(int columnIndex, std::vector<byte> &bytes);
 
         DbResult getLastInsertedRowIndex(int64_t &lastInsertedRowIndex);
 
+        // These hide the SQLiteStatement functions so that the values can be
+        // recorded in the capture log. Parameter names are changed to
+        // ordinals, so the log only contains ordinals.
+        int bindNull(int ordinal)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Null, 0, 0, nullptr, 0); }
+            return SQLiteStatement::bindNull(ordinal);
+            }
+        int bindNull(char const *param)
+            { return bindNull(getParamOrdinal(param)); }
+        int bindInt(int ordinal, int val)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Int, val, 0, nullptr, 0); }
+            return SQLiteStatement::bindInt(ordinal, val);
+            }
+        int bindInt(char const *param, int val)
+            { return bindInt(getParamOrdinal(param), val); }
+        int bindInt64(int ordinal, int64_t val)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Int, val, 0, nullptr, 0); }
+            return SQLiteStatement::bindInt64(ordinal, val);
+            }
+        int bindInt64(char const *param, int64_t val)
+            { return bindInt64(getParamOrdinal(param), val); }
+        // Queries with bound doubles are not cached, since the expanded SQL
+        // that is the cache key does not contain all digits.
+        int bindDouble(int ordinal, double val)
+            {
+            mDoubleBound = true;
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Double, 0, val, nullptr, 0); }
+            return SQLiteStatement::bindDouble(ordinal, val);
+            }
+        int bindDouble(char const *param, double val)
+            { return bindDouble(getParamOrdinal(param), val); }
+        int bindFloat(int ordinal, float val)
+            { return bindDouble(ordinal, val); }
+        int bindFloat(char const *param, float val)
+            { return bindDouble(param, val); }
+        int bindText(int ordinal, char const *val)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Text, 0, 0, val, val ? strlen(val) : 0); }
+            return SQLiteStatement::bindText(ordinal, val);
+            }
+        int bindText(char const *param, char const *val)
+            { return bindText(getParamOrdinal(param), val); }
+        int bindBlob(int ordinal, const void *bytes, int elNumBytes)
+            {
+            if(mDb.mCaptureLog)
+                {
+                captureBind(ordinal, DCV_Blob, 0, 0, static_cast<char const *>(bytes),
+                    static_cast<size_t>(elNumBytes));
+                }
+            return SQLiteStatement::bindBlob(ordinal, bytes, elNumBytes);
+            }
+        int bindTextCopy(int ordinal, char const *val, size_t len)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Text, 0, 0, val, len); }
+            return SQLiteStatement::bindTextCopy(ordinal, val, len);
+            }
+        int bindBlobCopy(int ordinal, const void *bytes, size_t numBytes)
+            {
+            if(mDb.mCaptureLog)
+                {
+                captureBind(ordinal, DCV_Blob, 0, 0, static_cast<char const *>(bytes),
+                    numBytes);
+                }
+            return SQLiteStatement::bindBlobCopy(ordinal, bytes, numBytes);
+            }
+        int bindTextView(int ordinal, std::string_view val, SQLiteBindModes mode)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Text, 0, 0, val.data(), val.length()); }
+            return SQLiteStatement::bindTextView(ordinal, val, mode);
+            }
+        int bindBlobView(int ordinal, const void *bytes, size_t numBytes,
+            SQLiteBindModes mode)
+            {
+            if(mDb.mCaptureLog)
+                {
+                captureBind(ordinal, DCV_Blob, 0, 0, static_cast<char const *>(bytes),
+                    numBytes);
+                }
+            return SQLiteStatement::bindBlobView(ordinal, bytes, numBytes, mode);
+            }
+        int bindTextOwned(int ordinal, std::string &&val)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Text, 0, 0, val.data(), val.length()); }
+            return SQLiteStatement::bindTextOwned(ordinal, std::move(val));
+            }
+        int bindBlobOwned(int ordinal, std::string &&bytes)
+            {
+            if(mDb.mCaptureLog)
+                { captureBind(ordinal, DCV_Blob, 0, 0, bytes.data(), bytes.length()); }
+            return SQLiteStatement::bindBlobOwned(ordinal, std::move(bytes));
+            }
+
         // WARNING - The bind values must be kept around while the statement is executing.
         DbResult bindValues(std::vector<std::string> const &values);
+        /// Binds all values to a single parameter that is used with
+        /// DbString::WHERE_IN_ARRAY(). The values are copied, so they do not
+        /// need to be kept around while the statement is executing.
+        DbResult bindArray(int ordinal, DbArrayView<int64_t> values)
+            { return bindArrayJson(ordinal, values); }
+        DbResult bindArray(int ordinal, DbArrayView<std::string_view> values)
+            { return bindArrayJson(ordinal, values); }
+        DbResult bindArray(int ordinal, DbArrayView<std::string> values)
+            { return bindArrayJson(ordinal, values); }
         static DbResult getDbResult(int sqliteErr)
             {
             DbResult result;
             if(IS_SQLITE_ERROR(sqliteErr))
-                { result.setError("Error with db"); }
+                {
+                result.setNativeError(DbAccess::getErrorCategory(sqliteErr),
+                    sqliteErr, "Error with db");
+                }
             return result;
             }
         DbResult getErrorInfo() const
@@ -104,16 +405,129 @@ class DbStatement:public SQLiteStatement
 
     private:
         DbAccess &mDb;
+        DbColumnMap mColumnMap;
+        DbStatementTables mTables;
+        bool mDoubleBound;
+        // A step was done after the last set or reset.
+        bool mStepped;
+        // These are set when the rows are read from the result cache.
+        std::shared_ptr<DbCachedRows const> mCachedRows;
+        size_t mCachedRowIndex;
+        size_t mNextCachedRowIndex;
+        // Text for numbers that are read as text from the cached rows.
+        mutable std::vector<std::string> mCachedTextValues;
+        // These are set while the rows are read from the database and copied
+        // for the result cache.
+        std::shared_ptr<DbCachedRows> mFillRows;
+        std::string mCacheKey;
+        uint64_t mFillGeneration;
+        // The execution that is recorded in the capture log. The SQL id is
+        // only valid if the generation matches the DbAccess generation. It is
+        // found at the first step, so that statements that were set before
+        // the log are recorded.
+        DbCapturedExecution mCaptureExec;
+        uint64_t mCaptureGeneration;
+        bool mCapturing;
+        DbCaptureLog::Clock::time_point mCaptureStart;
+
+        void buildColumnMap();
+        void startStep(bool readRows);
+        void endResultCache();
+        void addFillRow();
+        void finishFill();
+        int getCachedType(int columnIndex) const;
+        double getCachedDouble(int columnIndex) const;
+        char const *getCachedText(int columnIndex) const;
+        int getParamOrdinal(char const *param)
+            { return mDb.sqlite3_bind_parameter_index(getStatement(), param); }
+        void captureBind(int ordinal, DbCaptureValueTypes type, int64_t intVal,
+            double doubleVal, char const *text, size_t len);
+        /// Counts a row, or writes the execution at the end of the rows.
+        void finishCaptureStep(int retCode);
+        /// Writes the execution if one was started.
+        /// @param retCode The return code from the last step.
+        void finishCapture(int retCode);
+        template<typename T> DbResult bindArrayJson(int ordinal,
+            DbArrayView<T> values)
+            {
+            std::string json;
+            appendDbJsonArray(json, values);
+            return getDbResult(bindTextCopy(ordinal, json.data(), json.length()));
+            }
+    };
+
+/// This has the same interface as the MySQL DbBatchInsert. SQLite does not
+/// have network round trips, so each row is inserted with the same prepared
+/// statement. Use a DbTransaction around the rows for speed.
+class DbBatchInsert
+    {
+    public:
+        explicit DbBatchInsert(DbAccess &db, size_t /*maxRows*/=1000):
+            mStmt(db), mNumRows(0)
+            {}
+
+        /// The query must contain one row of values such as "VALUES(?, ?)".
+        /// The statement is run for each row, so it is prepared as persistent.
+        DbResult set(char const *query)
+            { return mStmt.set(query, SQLITE_PREPARE_PERSISTENT); }
+
+        // ordinal is base 1.
+        void bindNull(int ordinal)
+            { mStmt.bindNull(ordinal); }
+        void bindInt(int ordinal, int val)
+            { mStmt.bindInt(ordinal, val); }
+        void bindInt64(int ordinal, int64_t val)
+            { mStmt.bindInt64(ordinal, val); }
+        void bindDouble(int ordinal, double val)
+            { mStmt.bindDouble(ordinal, val); }
+        void bindText(int ordinal, char const *val)
+            { mStmt.bindText(ordinal, val); }
+        /// SBM_Static only needs the buffer to be kept until addRow() if the
+        /// parameter is bound again before the next row.
+        void bindTextView(int ordinal, std::string_view val, SQLiteBindModes mode)
+            { mStmt.bindTextView(ordinal, val, mode); }
+
+        /// Inserts the bound values as a row.
+        DbResult addRow();
+        DbResult flush()
+            { return DbResult(); }
+
+        size_t getNumRows() const
+            { return mNumRows; }
+        size_t getNumRoundTrips() const
+            { return mNumRows; }
+        double getRowsPerRoundTrip() const
+            { return mNumRows ? 1 : 0; }
+
+    private:
+        DbStatement mStmt;
+        size_t mNumRows;
     };
 
 /// Defines a transaction so that the transaction ends on destruction.
+/// These hide the SQLiteTransaction functions so that the transaction can
+/// be recorded in the capture log.
 class DbTransaction:public SQLiteTransaction
     {
     public:
         explicit DbTransaction(DbAccess &db):
-	    SQLiteTransaction(db)
-	    {}
+	    SQLiteTransaction(db, false), mDb(db)
+	    { begin(); }
+        ~DbTransaction()
+            { end(); }
+        void transact()
+            {
+            end();
+            begin();
+            }
+        void begin();
+        void end();
+        void rollback();
+
+    private:
+        DbAccess &mDb;
     };
 
-#endif
+}   // namespace DbSqlite
 
+#endif
@@ -0,0 +1,76 @@
+/*
+* DbArray.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbArray.h"
+
+static void appendJsonString(std::string &json, std::string_view str)
+    {
+    static char const hexDigits[] = "0123456789abcdef";
+    json.append(1, '\"');
+    size_t copyPos = 0;
+    for(size_t i=0; i<str.length(); i++)
+        {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if(c < 0x20 || c == '\"' || c == '\\' || c == '\'')
+            {
+            json.append(str.data() + copyPos, i - copyPos);
+            if(c == '\"' || c == '\\')
+                {
+                json.append(1, '\\');
+                json.append(1, static_cast<char>(c));
+                }
+            else
+                {
+                json.append("\\u00");
+                json.append(1, hexDigits[c >> 4]);
+                json.append(1, hexDigits[c & 0xF]);
+                }
+            copyPos = i + 1;
+            }
+        }
+    json.append(str.data() + copyPos, str.length() - copyPos);
+    json.append(1, '\"');
+    }
+
+template<typename T> static void appendJsonStrings(std::string &json,
+    DbArrayView<T> values)
+    {
+    json.append(1, '[');
+    for(size_t i=0; i<values.size(); i++)
+        {
+        if(i != 0)
+            {
+            json.append(1, ',');
+            }
+        appendJsonString(json, values.data()[i]);
+        }
+    json.append(1, ']');
+    }
+
+void appendDbJsonArray(std::string &json, DbArrayView<int64_t> values)
+    {
+    json.reserve(json.length() + values.size() * 8 + 2);
+    json.append(1, '[');
+    for(size_t i=0; i<values.size(); i++)
+        {
+        if(i != 0)
+            {
+            json.append(1, ',');
+            }
+        json.append(std::to_string(values.data()[i]));
+        }
+    json.append(1, ']');
+    }
+
+void appendDbJsonArray(std::string &json, DbArrayView<std::string_view> values)
+    {
+    appendJsonStrings(json, values);
+    }
+
+void appendDbJsonArray(std::string &json, DbArrayView<std::string> values)
+    {
+    appendJsonStrings(json, values);
+    }
@@ -0,0 +1,66 @@
+/*
+* DbArray.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Allows binding a whole array of values to a single bind parameter. The
+// array is bound as JSON text and expanded by the database into a table with
+// a single "value" column. See DbString::WHERE_IN_ARRAY().
+//
+// Example:
+//    dbStr.SELECT("name").FROM("Cat").WHERE_IN_ARRAY("catId");
+//    stmt.set(dbStr.getDbStr().c_str());
+//    stmt.bindArray(1, catIds);
+//    dbStr.SELECT("catId").FROM("Cat").WHERE_IN_ARRAY("name", DAT_Text);
+//
+// SQLite uses json_each, which is built in since 3.38 (and in most builds
+// before that). MySQL uses JSON_TABLE, which requires version 8.0.
+
+#ifndef DB_ARRAY_H
+#define DB_ARRAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// The type of the array values. MySQL needs this for the type of the
+/// JSON_TABLE column, so that an integer column is compared with integers
+/// and can use its index.
+enum DbArrayTypes
+    {
+    DAT_Integer,        // BIGINT
+    DAT_Text            // LONGTEXT, so long strings are not truncated.
+    };
+
+/// Refers to an array of values without copying them.
+template<typename T> class DbArrayView
+    {
+    public:
+        DbArrayView(T const *values, size_t numValues):
+            mValues(values), mNumValues(numValues)
+            {}
+        DbArrayView(std::vector<T> const &values):
+            mValues(values.data()), mNumValues(values.size())
+            {}
+        T const *data() const
+            { return mValues; }
+        size_t size() const
+            { return mNumValues; }
+
+    private:
+        T const *mValues;
+        size_t mNumValues;
+    };
+
+/// Appends a JSON array such as [1,2,3].
+void appendDbJsonArray(std::string &json, DbArrayView<int64_t> values);
+/// Appends a JSON array such as ["a","b"]. Quotes, backslashes and control
+/// characters are escaped. Single quotes are also escaped so that the JSON
+/// can be placed in a quoted SQL string.
+void appendDbJsonArray(std::string &json, DbArrayView<std::string_view> values);
+void appendDbJsonArray(std::string &json, DbArrayView<std::string> values);
+
+#endif
@@ -0,0 +1,280 @@
+/*
+* DbBackend.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Allows code to be written once for any backend. There are two ways.
+//
+// 1. Template on the access type. The calls are direct, so there is no
+//    dispatch cost. Each access type defines the Statement and Transaction
+//    types that are used with it.
+//      template<typename Access> DbResult countItems(Access &db, int64_t &count)
+//          {
+//          DB_CHECK_BACKEND(Access);
+//          typename Access::Statement stmt(db);
+//          DbResult result = stmt.set("SELECT COUNT(*) FROM Item");
+//          ...
+//          }
+//      countItems(sqliteDb, count);
+//      countItems(mysqlDb, count);
+//
+// 2. Use DbAnyAccess and DbAnyStatement when the backend is selected at run
+//    time. Each call is a virtual call.
+//      DbAnyAccess anyDb(mysqlDb);
+//      DbAnyStatement stmt(anyDb);
+//      stmt.set("SELECT COUNT(*) FROM Item");
+
+#ifndef DB_BACKEND_H
+#define DB_BACKEND_H
+
+#include "DbAccess.h"
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if(DB_USE_SQLITE)
+typedef DbSqlite::DbAccess SqliteAccess;
+#endif
+#if(DB_USE_MYSQL)
+typedef DbMysql::DbAccess MysqlAccess;
+#endif
+
+/// The statement type for an access type.
+template<typename Access> using DbStatementOf = typename Access::Statement;
+
+/// This is true if the access type and its Statement type have the
+/// functions that are shared by all backends.
+template<typename Access, typename = void> struct IsDbBackend:
+    public std::false_type
+    {};
+
+template<typename Access> struct IsDbBackend<Access, std::void_t<
+    decltype(Access::Database),
+    typename Access::Transaction,
+    decltype(std::declval<Access&>().open(""), std::declval<Access&>().getErrorInfo()),
+    decltype(typename Access::Statement(std::declval<Access&>())),
+    decltype(std::declval<typename Access::Statement&>().set("")),
+    decltype(std::declval<typename Access::Statement&>().execute()),
+    decltype(std::declval<typename Access::Statement&>().reset()),
+    decltype(std::declval<typename Access::Statement&>().testRow(
+        std::declval<bool&>())),
+    decltype(std::declval<typename Access::Statement&>().getRow()),
+    decltype(std::declval<typename Access::Statement&>().bindNull(1)),
+    decltype(std::declval<typename Access::Statement&>().bindInt(1, 0)),
+    decltype(std::declval<typename Access::Statement&>().bindInt64(1, int64_t())),
+    decltype(std::declval<typename Access::Statement&>().bindDouble(1, 0.0)),
+    decltype(std::declval<typename Access::Statement&>().bindText(1, "")),
+    decltype(std::declval<typename Access::Statement&>().getColumnInt(0)),
+    decltype(std::declval<typename Access::Statement&>().getColumnInt64(0)),
+    decltype(std::declval<typename Access::Statement&>().getColumnDouble(0)),
+    decltype(std::declval<typename Access::Statement&>().getColumnText(0))>>:
+    public std::true_type
+    {};
+
+#if defined(__cpp_concepts)
+template<typename Access> concept DbBackend = IsDbBackend<Access>::value;
+#endif
+
+/// Use this in a function that is templated on the access type to get a
+/// short error if the type is not a backend.
+#define DB_CHECK_BACKEND(Access) static_assert(IsDbBackend<Access>::value, \
+    "The type must be a database access type such as SqliteAccess")
+
+#if(DB_USE_SQLITE)
+static_assert(IsDbBackend<SqliteAccess>::value, "SqliteAccess is not a backend");
+#endif
+#if(DB_USE_MYSQL)
+static_assert(IsDbBackend<MysqlAccess>::value, "MysqlAccess is not a backend");
+#endif
+
+// Some backend functions return a native error code, and some return a
+// DbResult. These convert to a DbResult.
+inline DbResult toDbResult(DbResult const &result)
+    { return result; }
+#if(DB_USE_SQLITE)
+inline DbResult toDbResult(int sqliteErr)
+    { return DbSqlite::DbStatement::getDbResult(sqliteErr); }
+#endif
+
+class DbAnyStatement;
+
+/// Refers to an access object of any backend. The access object must exist
+/// as long as this does.
+class DbAnyAccess
+    {
+    public:
+        template<typename Access> explicit DbAnyAccess(Access &db):
+            mImpl(new AccessModel<Access>(db))
+            {
+            DB_CHECK_BACKEND(Access);
+            }
+        /// Returns DB_SQLITE or DB_MYSQL.
+        int getDatabase() const
+            { return mImpl->getDatabase(); }
+        DbResult getErrorInfo() const
+            { return mImpl->getErrorInfo(); }
+
+    private:
+        friend class DbAnyStatement;
+        friend class DbAnyTransaction;
+        struct StatementConcept
+            {
+            virtual ~StatementConcept()
+                {}
+            virtual DbResult set(char const *query) = 0;
+            virtual DbResult execute() = 0;
+            virtual DbResult reset() = 0;
+            virtual DbResult testRow(bool &gotRow) = 0;
+            virtual DbResult getRow() = 0;
+            virtual void bindNull(int ordinal) = 0;
+            virtual void bindInt(int ordinal, int val) = 0;
+            virtual void bindInt64(int ordinal, int64_t val) = 0;
+            virtual void bindDouble(int ordinal, double val) = 0;
+            virtual void bindText(int ordinal, char const *val) = 0;
+            virtual int getColumnInt(int columnIndex) const = 0;
+            virtual int64_t getColumnInt64(int columnIndex) const = 0;
+            virtual double getColumnDouble(int columnIndex) const = 0;
+            virtual char const *getColumnText(int columnIndex) const = 0;
+            };
+        // This only exists so that the transaction can be destroyed.
+        struct TransactionConcept
+            {
+            virtual ~TransactionConcept()
+                {}
+            };
+        struct AccessConcept
+            {
+            virtual ~AccessConcept()
+                {}
+            virtual int getDatabase() const = 0;
+            virtual DbResult getErrorInfo() const = 0;
+            virtual StatementConcept *newStatement() = 0;
+            virtual TransactionConcept *newTransaction() = 0;
+            };
+
+        template<typename Access> struct StatementModel:public StatementConcept
+            {
+            explicit StatementModel(Access &db):
+                mStmt(db)
+                {}
+            DbResult set(char const *query) override
+                { return toDbResult(mStmt.set(query)); }
+            DbResult execute() override
+                { return toDbResult(mStmt.execute()); }
+            DbResult reset() override
+                { return toDbResult(mStmt.reset()); }
+            DbResult testRow(bool &gotRow) override
+                { return toDbResult(mStmt.testRow(gotRow)); }
+            DbResult getRow() override
+                { return toDbResult(mStmt.getRow()); }
+            void bindNull(int ordinal) override
+                { mStmt.bindNull(ordinal); }
+            void bindInt(int ordinal, int val) override
+                { mStmt.bindInt(ordinal, val); }
+            void bindInt64(int ordinal, int64_t val) override
+                { mStmt.bindInt64(ordinal, val); }
+            void bindDouble(int ordinal, double val) override
+                { mStmt.bindDouble(ordinal, val); }
+            void bindText(int ordinal, char const *val) override
+                { mStmt.bindText(ordinal, val); }
+            int getColumnInt(int columnIndex) const override
+                { return mStmt.getColumnInt(columnIndex); }
+            int64_t getColumnInt64(int columnIndex) const override
+                { return mStmt.getColumnInt64(columnIndex); }
+            double getColumnDouble(int columnIndex) const override
+                { return mStmt.getColumnDouble(columnIndex); }
+            char const *getColumnText(int columnIndex) const override
+                { return mStmt.getColumnText(columnIndex); }
+
+            typename Access::Statement mStmt;
+            };
+        template<typename Access> struct TransactionModel:public TransactionConcept
+            {
+            explicit TransactionModel(Access &db):
+                mTransaction(db)
+                {}
+            typename Access::Transaction mTransaction;
+            };
+        template<typename Access> struct AccessModel:public AccessConcept
+            {
+            explicit AccessModel(Access &db):
+                mDb(db)
+                {}
+            int getDatabase() const override
+                { return Access::Database; }
+            DbResult getErrorInfo() const override
+                { return mDb.getErrorInfo(); }
+            StatementConcept *newStatement() override
+                { return new StatementModel<Access>(mDb); }
+            TransactionConcept *newTransaction() override
+                { return new TransactionModel<Access>(mDb); }
+
+            Access &mDb;
+            };
+
+        std::unique_ptr<AccessConcept> mImpl;
+    };
+
+/// A statement for the backend of a DbAnyAccess. The functions are the same
+/// as the functions of the backend statements.
+class DbAnyStatement
+    {
+    public:
+        explicit DbAnyStatement(DbAnyAccess &db):
+            mImpl(db.mImpl->newStatement())
+            {}
+        DbAnyStatement(DbAnyAccess &db, char const *query):
+            mImpl(db.mImpl->newStatement())
+            { set(query); }
+
+        DbResult set(char const *query)
+            { return mImpl->set(query); }
+        DbResult execute()
+            { return mImpl->execute(); }
+        DbResult reset()
+            { return mImpl->reset(); }
+        DbResult testRow(bool &gotRow)
+            { return mImpl->testRow(gotRow); }
+        DbResult getRow()
+            { return mImpl->getRow(); }
+
+        // ordinal is base 1.
+        void bindNull(int ordinal)
+            { mImpl->bindNull(ordinal); }
+        void bindInt(int ordinal, int val)
+            { mImpl->bindInt(ordinal, val); }
+        void bindInt64(int ordinal, int64_t val)
+            { mImpl->bindInt64(ordinal, val); }
+        void bindDouble(int ordinal, double val)
+            { mImpl->bindDouble(ordinal, val); }
+        void bindText(int ordinal, char const *val)
+            { mImpl->bindText(ordinal, val); }
+
+        // columnIndex is base 0.
+        int getColumnInt(int columnIndex) const
+            { return mImpl->getColumnInt(columnIndex); }
+        int64_t getColumnInt64(int columnIndex) const
+            { return mImpl->getColumnInt64(columnIndex); }
+        double getColumnDouble(int columnIndex) const
+            { return mImpl->getColumnDouble(columnIndex); }
+        char const *getColumnText(int columnIndex) const
+            { return mImpl->getColumnText(columnIndex); }
+
+    private:
+        std::unique_ptr<DbAnyAccess::StatementConcept> mImpl;
+    };
+
+/// Defines a transaction so that the transaction ends on destruction.
+class DbAnyTransaction
+    {
+    public:
+        explicit DbAnyTransaction(DbAnyAccess &db):
+            mImpl(db.mImpl->newTransaction())
+            {}
+
+    private:
+        std::unique_ptr<DbAnyAccess::TransactionConcept> mImpl;
+    };
+
+#endif
@@ -0,0 +1,902 @@
+/*
+* DbBench.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Benchmarks for the database access layer.
+// Run from the directory where the benchmark database can be created.
+//
+// Usage: DbBench [--json] [--rows=10000,100000] [--data-size=16,1024]
+//      [--filter=lookup]
+//  --json          Print the results as JSON instead of a table.
+//  --rows          The number of rows in the table for each run.
+//  --data-size     The number of bytes in the data column for each run.
+//  --filter        Only run the benchmarks whose names contain the text.
+// Each combination of row count and data size runs with a new database.
+// The random keys use a fixed seed, so each run does the same operations.
+
+#include "DbAccess.h"
+#include "DbBackend.h"
+#include "DbString.h"
+#include "DbTable.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static char const * const BenchDbName = "DbBench.db";
+// Each single insert is a transaction that waits for the disk, which is much
+// slower than the other operations, so this limits the number of inserts.
+static int const MaxSingleInserts = 100;
+// The number of rows for each range scan, and the number of ids for each
+// array lookup.
+static int const RangeScanRows = 100;
+
+class BenchTimer
+    {
+    public:
+        BenchTimer():
+            mStart(std::chrono::steady_clock::now())
+            {}
+        double getSeconds() const
+            {
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - mStart;
+            return elapsed.count();
+            }
+
+    private:
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+struct BenchConfig
+    {
+    BenchConfig():
+        mJson(false)
+        {}
+    std::vector<int> mRowCounts;
+    std::vector<int> mDataSizes;
+    std::string mFilter;
+    bool mJson;
+    };
+
+/// The results of one benchmark with one row count and data size.
+struct BenchResult
+    {
+    BenchResult():
+        mNumRows(0), mDataSize(0), mNumOps(0), mSeconds(0)
+        {}
+    double getOpsPerSec() const
+        { return (mSeconds > 0) ? mNumOps / mSeconds : 0; }
+    /// @param percent From 0 to 100.
+    double getLatencyNs(double percent) const;
+
+    std::string mName;
+    int mNumRows;
+    int mDataSize;
+    size_t mNumOps;
+    double mSeconds;
+    // The sorted latency of each operation in nanoseconds.
+    std::vector<double> mLatencies;
+    // Text that shows that the benchmark did the expected work.
+    std::string mCheck;
+    };
+
+double BenchResult::getLatencyNs(double percent) const
+    {
+    double latency = 0;
+    if(mLatencies.size() > 0)
+        {
+        size_t index = static_cast<size_t>(percent / 100 * mLatencies.size());
+        latency = mLatencies[std::min(index, mLatencies.size() - 1)];
+        }
+    return latency;
+    }
+
+/// Runs the benchmarks for one row count and data size, and keeps the
+/// results of all runs.
+class BenchRunner
+    {
+    public:
+        explicit BenchRunner(BenchConfig const &config):
+            mConfig(config), mNumRows(0), mDataSize(0)
+            {}
+        void setRun(int numRows, int dataSize)
+            {
+            mNumRows = numRows;
+            mDataSize = dataSize;
+            }
+        int getNumRows() const
+            { return mNumRows; }
+        int getDataSize() const
+            { return mDataSize; }
+        bool isEnabled(char const *name) const
+            { return mConfig.mFilter.empty() || strstr(name, mConfig.mFilter.c_str()); }
+
+        /// Calls op(i) numOps times and records the time of each call. Fast
+        /// operations should set opsPerSample so that the timer does not
+        /// change the result. The op returns a DbResult, and the benchmark
+        /// stops on an error.
+        template<typename Op> DbResult run(char const *name, size_t numOps,
+            Op op, size_t opsPerSample=1);
+        /// Sets the check text of the last result.
+        void setCheck(std::string const &check)
+            {
+            if(mResults.size() > 0)
+                {
+                mResults.back().mCheck = check;
+                }
+            }
+
+        void printText() const;
+        void printJson() const;
+
+    private:
+        BenchConfig const &mConfig;
+        int mNumRows;
+        int mDataSize;
+        std::vector<BenchResult> mResults;
+    };
+
+template<typename Op> DbResult BenchRunner::run(char const *name, size_t numOps,
+    Op op, size_t opsPerSample)
+    {
+    DbResult result;
+    BenchResult benchResult;
+    benchResult.mName = name;
+    benchResult.mNumRows = mNumRows;
+    benchResult.mDataSize = mDataSize;
+    benchResult.mLatencies.reserve(numOps / opsPerSample + 1);
+    BenchTimer timer;
+    size_t opIndex = 0;
+    while(opIndex < numOps && result.isOk())
+        {
+        size_t endIndex = std::min(opIndex + opsPerSample, numOps);
+        size_t sampleOps = endIndex - opIndex;
+        BenchTimer sampleTimer;
+        for(; opIndex < endIndex && result.isOk(); opIndex++)
+            {
+            result = op(opIndex);
+            }
+        benchResult.mLatencies.push_back(sampleTimer.getSeconds() * 1e9 / sampleOps);
+        }
+    benchResult.mSeconds = timer.getSeconds();
+    benchResult.mNumOps = opIndex;
+    std::sort(benchResult.mLatencies.begin(), benchResult.mLatencies.end());
+    if(result.isOk())
+        {
+        mResults.push_back(benchResult);
+        }
+    else
+        {
+        result.insertContext(name);
+        }
+    return result;
+    }
+
+void BenchRunner::printText() const
+    {
+    printf("%-24s %8s %6s %10s %9s %9s %9s  %s\n", "Benchmark", "Rows", "Bytes",
+        "Ops/sec", "p50 ns", "p99 ns", "p99.9 ns", "Check");
+    for(auto const &res : mResults)
+        {
+        printf("%-24s %8d %6d %10.0f %9.0f %9.0f %9.0f  %s\n", res.mName.c_str(),
+            res.mNumRows, res.mDataSize, res.getOpsPerSec(), res.getLatencyNs(50),
+            res.getLatencyNs(99), res.getLatencyNs(99.9), res.mCheck.c_str());
+        }
+    }
+
+void BenchRunner::printJson() const
+    {
+    printf("{\n  \"database\": \"%s\",\n  \"benchmarks\": [\n",
+        (DATABASE == DB_SQLITE) ? "sqlite" : "mysql");
+    for(size_t i=0; i<mResults.size(); i++)
+        {
+        BenchResult const &res = mResults[i];
+        printf("    {\"name\": \"%s\", \"rows\": %d, \"dataSize\": %d, "
+            "\"ops\": %zu, \"seconds\": %.6f, \"opsPerSec\": %.1f, "
+            "\"latencyNs\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+            "\"p999\": %.1f, \"max\": %.1f}, \"check\": \"%s\"}%s\n",
+            res.mName.c_str(), res.mNumRows, res.mDataSize, res.mNumOps,
+            res.mSeconds, res.getOpsPerSec(), res.getLatencyNs(50),
+            res.getLatencyNs(90), res.getLatencyNs(99), res.getLatencyNs(99.9),
+            res.getLatencyNs(100), res.mCheck.c_str(),
+            (i + 1 < mResults.size()) ? "," : "");
+        }
+    printf("  ]\n}\n");
+    }
+
+template<typename Access> static DbResult executeQuery(Access &db, DbString &query)
+    {
+    DB_CHECK_BACKEND(Access);
+    DbStatementOf<Access> stmt(db);
+    DbResult result = stmt.set(query.getDbStr().c_str());
+    if(result.isOk())
+        {
+        result = stmt.execute();
+        }
+    return result;
+    }
+
+static DbResult getMaxId(DbAccess &db, int64_t &maxId)
+    {
+    DbStatement stmt(db);
+    DbString query;
+    query.SELECT("MAX(id)").FROM("Item");
+    DbResult result = stmt.set(query.getDbStr().c_str());
+    if(result.isOk())
+        {
+        result = stmt.getRow();
+        }
+    if(result.isOk())
+        {
+        maxId = stmt.getColumnInt64(0);
+        }
+    return result;
+    }
+
+static std::string sumCheck(int64_t sum)
+    {
+    return "sum: " + std::to_string(sum);
+    }
+
+static DbResult createTable(DbAccess &db, char const *tableName)
+    {
+    DbString query;
+    query.CREATE_TABLE(tableName).COLUMN_DEFS("id INTEGER PRIMARY KEY, "
+        "name TEXT UNIQUE NOT NULL, count INTEGER, data TEXT");
+    return executeQuery(db, query);
+    }
+
+// Inserts rows with one statement execution for each row, and no
+// transaction around the rows.
+static DbResult benchInsertSingle(DbAccess &db, BenchRunner &runner)
+    {
+    DbResult result = createTable(db, "SingleItem");
+    std::string data(static_cast<size_t>(runner.getDataSize()), 'x');
+    DbStatement stmt(db);
+    if(result.isOk())
+        {
+        DbString query;
+        query.INSERT_INTO("SingleItem").COLUMNS("name, count, data").VALUES(THREE_PARAMS);
+        result = stmt.set(query.getDbStr().c_str());
+        }
+    if(result.isOk())
+        {
+        result = runner.run("insert single",
+            static_cast<size_t>(std::min(runner.getNumRows(), MaxSingleInserts)),
+            [&](size_t i)
+            {
+            std::string name = "item" + std::to_string(i);
+            stmt.bindText(1, name.c_str());
+            stmt.bindInt(2, static_cast<int>(i));
+            stmt.bindText(3, data.c_str());
+            DbResult execResult = stmt.execute();
+            stmt.reset();
+            return execResult;
+            });
+        }
+    return result;
+    }
+
+// Fills the Item table that is used by the other benchmarks.
+static DbResult benchInsertBatch(DbAccess &db, BenchRunner &runner)
+    {
+    DbString query;
+    DbResult result = createTable(db, "Item");
+    if(result.isOk())
+        {
+        query.clear();
+        query.CREATE_INDEX("ItemCount", "Item", "count");
+        result = executeQuery(db, query);
+        }
+    if(result.isOk())
+        {
+        std::string data(static_cast<size_t>(runner.getDataSize()), 'x');
+        DbTransaction transaction(db);
+        DbBatchInsert batch(db);
+        query.INSERT_INTO("Item").COLUMNS("name, count, data").VALUES(THREE_PARAMS);
+        result = batch.set(query.getDbStr().c_str());
+        if(result.isOk())
+            {
+            result = runner.run("insert batch", static_cast<size_t>(runner.getNumRows()),
+                [&](size_t i)
+                {
+                std::string name = "item" + std::to_string(i);
+                batch.bindText(1, name.c_str());
+                batch.bindInt(2, static_cast<int>(i));
+                batch.bindText(3, data.c_str());
+                DbResult addResult = batch.addRow();
+                if(addResult.isOk() && i + 1 == static_cast<size_t>(runner.getNumRows()))
+                    {
+                    addResult = batch.flush();
+                    }
+                return addResult;
+                });
+            }
+        if(result.isOk())
+            {
+            char check[50];
+            snprintf(check, sizeof(check), "rows/round trip: %.1f",
+                batch.getRowsPerRoundTrip());
+            runner.setCheck(check);
+            }
+        }
+    return result;
+    }
+
+// Returns ids in a random order that is the same for each run.
+static std::vector<int64_t> getRandomIds(int numRows)
+    {
+    std::vector<int64_t> ids;
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int64_t> distribution(1, numRows);
+    for(int i=0; i<numRows; i++)
+        {
+        ids.push_back(distribution(generator));
+        }
+    return ids;
+    }
+
+// Reads rows by primary key using one statement per row, then reads them
+// using one statement for each array of ids.
+static DbResult benchLookupIds(DbAccess &db, BenchRunner &runner)
+    {
+    std::vector<int64_t> ids = getRandomIds(runner.getNumRows());
+    DbResult result;
+    DbString query;
+    if(runner.isEnabled("lookup primary key"))
+        {
+        int64_t sum = 0;
+        DbStatement stmt(db);
+        query.SELECT("count, data").FROM("Item").WHERE("id", "=", ONE_PARAM);
+        result = stmt.set(query.getDbStr().c_str());
+        if(result.isOk())
+            {
+            result = runner.run("lookup primary key", ids.size(), [&](size_t i)
+                {
+                stmt.reset();
+                stmt.bindInt64(1, ids[i]);
+                DbResult rowResult = stmt.getRow();
+                if(rowResult.isOk())
+                    {
+                    sum += stmt.getColumnInt64(0);
+                    }
+                return rowResult;
+                });
+            }
+        runner.setCheck(sumCheck(sum));
+        }
+    if(result.isOk() && runner.isEnabled("lookup WHERE_IN_ARRAY"))
+        {
+        int64_t sum = 0;
+        DbStatement stmt(db);
+        query.SELECT("count, data").FROM("Item").WHERE_IN_ARRAY("id");
+        result = stmt.set(query.getDbStr().c_str());
+        size_t numLookups = std::max(ids.size() / RangeScanRows, size_t(1));
+        if(result.isOk())
+            {
+            result = runner.run("lookup WHERE_IN_ARRAY", numLookups, [&](size_t i)
+                {
+                size_t first = std::min(i * RangeScanRows, ids.size());
+                size_t count = std::min(static_cast<size_t>(RangeScanRows),
+                    ids.size() - first);
+                stmt.reset();
+                DbResult rowResult = stmt.bindArray(1,
+                    DbArrayView<int64_t>(ids.data() + first, count));
+                bool gotRow = true;
+                while(rowResult.isOk() && gotRow)
+                    {
+                    rowResult = stmt.testRow(gotRow);
+                    if(rowResult.isOk() && gotRow)
+                        {
+                        sum += stmt.getColumnInt64(0);
+                        }
+                    }
+                return rowResult;
+                });
+            }
+        // Duplicate ids in an array only return one row.
+        runner.setCheck(sumCheck(sum));
+        }
+    return result;
+    }
+
+// The rows of the Item table as a struct.
+struct Item
+    {
+    int64_t id;
+    std::string name;
+    int64_t count;
+    std::string data;
+    };
+DB_TABLE(Item, id, name, count, data);
+
+// Reads rows by primary key into a struct, to compare the cost of the
+// mapping with the hand written lookup.
+static DbResult benchTableLookup(DbAccess &db, BenchRunner &runner)
+    {
+    std::vector<int64_t> ids = getRandomIds(runner.getNumRows());
+    int64_t sum = 0;
+    DbTable<Item> items(db);
+    Item item;
+    DbResult result = runner.run("lookup DbTable", ids.size(), [&](size_t i)
+        {
+        DbResult rowResult = items.loadByKey(ids[i], item);
+        if(rowResult.isOk())
+            {
+            sum += item.count;
+            }
+        return rowResult;
+        });
+    runner.setCheck(sumCheck(sum));
+    return result;
+    }
+
+// Reads rows by primary key through the type-erased statement, to show the
+// cost of the virtual calls.
+static DbResult benchAnyLookup(DbAccess &db, BenchRunner &runner)
+    {
+    std::vector<int64_t> ids = getRandomIds(runner.getNumRows());
+    int64_t sum = 0;
+    DbAnyAccess anyDb(db);
+    DbAnyStatement stmt(anyDb);
+    DbString query;
+    query.SELECT("count").FROM("Item").WHERE("id", "=", ONE_PARAM);
+    DbResult result = stmt.set(query.getDbStr().c_str());
+    if(result.isOk())
+        {
+        result = runner.run("lookup DbAnyStatement", ids.size(), [&](size_t i)
+            {
+            stmt.reset();
+            stmt.bindInt64(1, ids[i]);
+            DbResult rowResult = stmt.getRow();
+            if(rowResult.isOk())
+                {
+                sum += stmt.getColumnInt64(0);
+                }
+            return rowResult;
+            });
+        }
+    runner.setCheck(sumCheck(sum));
+    return result;
+    }
+
+// Reads ranges of rows by primary key.
+static DbResult benchRangeScan(DbAccess &db, BenchRunner &runner)
+    {
+    int numRows = runner.getNumRows();
+    size_t numScans = static_cast<size_t>(std::max(numRows / RangeScanRows, 1));
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> distribution(1, std::max(numRows -
+        RangeScanRows + 1, 1));
+    int64_t numRead = 0;
+    DbStatement stmt(db);
+    DbString query;
+    query.SELECT("id, name, count, data").FROM("Item").WHERE("id", ">=", ONE_PARAM).
+        AND("id", "<", ONE_PARAM);
+    DbResult result = stmt.set(query.getDbStr().c_str());
+    if(result.isOk())
+        {
+        result = runner.run("range scan", numScans, [&](size_t)
+            {
+            int firstId = distribution(generator);
+            stmt.reset();
+            stmt.bindInt(1, firstId);
+            stmt.bindInt(2, firstId + RangeScanRows);
+            DbResult rowResult;
+            bool gotRow = true;
+            while(rowResult.isOk() && gotRow)
+                {
+                rowResult = stmt.testRow(gotRow);
+                if(rowResult.isOk() && gotRow)
+                    {
+                    numRead++;
+                    }
+                }
+            return rowResult;
+            });
+        }
+    runner.setCheck("rows read: " + std::to_string(numRead));
+    return result;
+    }
+
+// Binds a parameter by ordinal and by name without executing, to show the
+// cost of finding the parameter.
+static DbResult benchBind(DbAccess &db, BenchRunner &runner)
+    {
+    size_t numBinds = static_cast<size_t>(runner.getNumRows()) * 10;
+    DbResult result;
+    DbString query;
+    if(runner.isEnabled("bind ordinal"))
+        {
+        DbStatement stmt(db);
+        query.SELECT("count").FROM("Item").WHERE("id", "=", ONE_PARAM).
+            AND("name", "=", ONE_PARAM);
+        result = stmt.set(query.getDbStr().c_str());
+        if(result.isOk())
+            {
+            result = runner.run("bind ordinal", numBinds, [&](size_t i)
+                {
+                stmt.bindInt(1, static_cast<int>(i));
+                stmt.bindText(2, "item");
+                return DbResult();
+                }, 100);
+            }
+        }
+    if(result.isOk() && runner.isEnabled("bind named"))
+        {
+        DbStatement stmt(db);
+        query.SELECT("count").FROM("Item").WHERE("id", "=", ":id").
+            AND("name", "=", ":name");
+        result = stmt.set(query.getDbStr().c_str());
+        if(result.isOk())
+            {
+            result = runner.run("bind named", numBinds, [&](size_t i)
+                {
+                stmt.bindInt(":id", static_cast<int>(i));
+                stmt.bindText(":name", "item");
+                return DbResult();
+                }, 100);
+            }
+        }
+    return result;
+    }
+
+// Builds a typical query with DbString.
+static DbResult benchDbString(BenchRunner &runner)
+    {
+    size_t length = 0;
+    DbResult result = runner.run("DbString build",
+        static_cast<size_t>(runner.getNumRows()) * 10, [&](size_t)
+        {
+        DbString query;
+        query.SELECT("id, name, count").FROM("Item").WHERE("count", ">", ONE_PARAM).
+            AND("name", "=", ONE_PARAM).ORDER_BY("id");
+        length += query.getDbStr().length();
+        return DbResult();
+        }, 100);
+    runner.setCheck("chars: " + std::to_string(length));
+    return result;
+    }
+
+// Sets errors the way that the access layer does for expected errors, and
+// then formats some of them the way that the caller does for reporting.
+static DbResult benchDbResultErrors(BenchRunner &runner)
+    {
+    size_t numOps = static_cast<size_t>(runner.getNumRows()) * 10;
+    size_t numErrors = 0;
+    DbResult result = runner.run("DbResult error", numOps, [&](size_t i)
+        {
+        DbResult error;
+        error.setNativeError(DEC_NotFound, static_cast<int>(i), "Unable to get row");
+        error.insertStaticContext("Unable to read item");
+        if(!error.isOk())
+            {
+            numErrors++;
+            }
+        return DbResult();
+        }, 100);
+    if(result.isOk())
+        {
+        runner.setCheck("errors: " + std::to_string(numErrors));
+        size_t length = 0;
+        result = runner.run("DbResult error string", numOps / 10, [&](size_t i)
+            {
+            DbResult error;
+            error.setNativeError(DEC_NotFound, static_cast<int>(i), "Unable to get row");
+            error.insertContext("Unable to read item " + std::to_string(i));
+            length += getDbResultString(error).length();
+            return DbResult();
+            }, 10);
+        runner.setCheck("chars: " + std::to_string(length));
+        }
+    return result;
+    }
+
+#if(DATABASE == DB_SQLITE)
+// Runs the same aggregate query many times, such as for a dashboard, without
+// and then with the result cache.
+static DbResult benchResultCache(DbAccess &db, BenchRunner &runner)
+    {
+    size_t const numQueries = 1000;
+    DbString query;
+    query.SELECT("COUNT(*), SUM(count)").FROM("Item").WHERE("count", ">=", ONE_PARAM);
+    DbResult result;
+    for(int pass=0; pass<2 && result.isOk(); pass++)
+        {
+        char const *name = pass ? "result cache on" : "result cache off";
+        if(pass == 1)
+            {
+            result = db.enableResultCache(1 << 20);
+            }
+        int64_t sum = 0;
+        DbStatement stmt(db);
+        if(result.isOk())
+            {
+            result = stmt.set(query.getDbStr().c_str());
+            }
+        if(result.isOk())
+            {
+            result = runner.run(name, numQueries, [&](size_t i)
+                {
+                stmt.reset();
+                stmt.bindInt(1, static_cast<int>(i % 4));
+                // The result is only cached when it is read to the end.
+                DbResult rowResult;
+                bool gotRow = true;
+                while(rowResult.isOk() && gotRow)
+                    {
+                    rowResult = stmt.testRow(gotRow);
+                    if(rowResult.isOk() && gotRow)
+                        {
+                        sum += stmt.getColumnInt64(1);
+                        }
+                    }
+                return rowResult;
+                });
+            }
+        std::string check = sumCheck(sum);
+        if(pass == 1)
+            {
+            char ratio[50];
+            snprintf(ratio, sizeof(ratio), "  hit ratio: %.3f",
+                db.getResultCacheStats().getHitRatio());
+            check += ratio;
+            }
+        runner.setCheck(check);
+        }
+    db.disableResultCache();
+    return result;
+    }
+
+// Binds the data as text with a copy by SQLite, and then without a copy.
+static DbResult benchBindText(DbAccess &db, BenchRunner &runner)
+    {
+    std::string data(static_cast<size_t>(runner.getDataSize()), 'x');
+    DbResult result;
+    for(int pass=0; pass<2 && result.isOk(); pass++)
+        {
+        SQLiteBindModes mode = pass ? SBM_Static : SBM_Copy;
+        int64_t sum = 0;
+        DbStatement stmt(db);
+        result = stmt.set("SELECT ? IS NOT NULL");
+        if(result.isOk())
+            {
+            result = runner.run(pass ? "bind text static" : "bind text copy",
+                static_cast<size_t>(runner.getNumRows()), [&](size_t /*i*/)
+                {
+                stmt.bindTextView(1, data, mode);
+                DbResult rowResult = stmt.getRow();
+                if(rowResult.isOk())
+                    {
+                    sum += stmt.getColumnInt64(0);
+                    }
+                stmt.reset();
+                return rowResult;
+                });
+            }
+        runner.setCheck(sumCheck(sum));
+        }
+    return result;
+    }
+#endif
+
+// Writes every row once with the query. The query must have two parameters,
+// the name and the count.
+static DbResult benchWriteAll(DbAccess &db, BenchRunner &runner,
+    char const *benchName, DbString &query, int count)
+    {
+    int64_t startMaxId = 0;
+    int64_t endMaxId = 0;
+    DbResult result = getMaxId(db, startMaxId);
+    if(result.isOk())
+        {
+        DbTransaction transaction(db);
+        DbStatement stmt(db);
+        result = stmt.set(query.getDbStr().c_str());
+        if(result.isOk())
+            {
+            result = runner.run(benchName, static_cast<size_t>(runner.getNumRows()),
+                [&](size_t i)
+                {
+                std::string name = "item" + std::to_string(i);
+                stmt.bindText(1, name.c_str());
+                stmt.bindInt(2, count);
+                DbResult execResult = stmt.execute();
+                stmt.reset();
+                return execResult;
+                });
+            }
+        }
+    if(result.isOk())
+        {
+        result = getMaxId(db, endMaxId);
+        }
+    runner.setCheck("new ids: " + std::to_string(endMaxId - startMaxId));
+    return result;
+    }
+
+static DbResult benchWrites(DbAccess &db, BenchRunner &runner)
+    {
+    DbResult result;
+    if(runner.isEnabled("INSERT OR REPLACE"))
+        {
+        DbString query;
+        query.INSERT_OR_REPLACE_INTO("Item").COLUMNS("name, count").VALUES(TWO_PARAMS);
+        result = benchWriteAll(db, runner, "INSERT OR REPLACE", query, 1);
+        }
+    if(result.isOk() && runner.isEnabled("ON CONFLICT DO UPDATE"))
+        {
+        DbString query;
+        query.INSERT_INTO("Item").COLUMNS("name, count").VALUES(TWO_PARAMS).
+            ON_CONFLICT("name").DO_UPDATE_SET_EXCLUDED("count");
+        result = benchWriteAll(db, runner, "ON CONFLICT DO UPDATE", query, 2);
+        }
+    if(result.isOk() && runner.isEnabled("ON CONFLICT DO NOTHING"))
+        {
+        DbString query;
+        query.INSERT_INTO("Item").COLUMNS("name, count").VALUES(TWO_PARAMS).
+            ON_CONFLICT("name").DO_NOTHING();
+        result = benchWriteAll(db, runner, "ON CONFLICT DO NOTHING", query, 3);
+        }
+    return result;
+    }
+
+// Runs all benchmarks with a new database. The batch insert fills the table
+// for the benchmarks that read, so it always runs.
+static DbResult runBenchmarks(BenchRunner &runner)
+    {
+    DbAccess db;
+    remove(BenchDbName);
+    DbResult result = db.open(BenchDbName);
+    if(result.isOk() && runner.isEnabled("insert single"))
+        {
+        result = benchInsertSingle(db, runner);
+        }
+    if(result.isOk())
+        {
+        result = benchInsertBatch(db, runner);
+        }
+    if(result.isOk())
+        {
+        result = benchLookupIds(db, runner);
+        }
+    if(result.isOk() && runner.isEnabled("lookup DbTable"))
+        {
+        result = benchTableLookup(db, runner);
+        }
+    if(result.isOk() && runner.isEnabled("lookup DbAnyStatement"))
+        {
+        result = benchAnyLookup(db, runner);
+        }
+    if(result.isOk() && runner.isEnabled("range scan"))
+        {
+        result = benchRangeScan(db, runner);
+        }
+    if(result.isOk())
+        {
+        result = benchBind(db, runner);
+        }
+    if(result.isOk() && runner.isEnabled("DbString build"))
+        {
+        result = benchDbString(runner);
+        }
+    if(result.isOk() && runner.isEnabled("DbResult error"))
+        {
+        result = benchDbResultErrors(runner);
+        }
+#if(DATABASE == DB_SQLITE)
+    if(result.isOk() && runner.isEnabled("result cache"))
+        {
+        result = benchResultCache(db, runner);
+        }
+    if(result.isOk() && runner.isEnabled("bind text"))
+        {
+        result = benchBindText(db, runner);
+        }
+#endif
+    if(result.isOk())
+        {
+        result = benchWrites(db, runner);
+        }
+    return result;
+    }
+
+static std::vector<int> parseIntList(char const *str)
+    {
+    std::vector<int> values;
+    while(*str)
+        {
+        char *end;
+        long value = strtol(str, &end, 10);
+        if(end == str)
+            {
+            break;
+            }
+        if(value > 0)
+            {
+            values.push_back(static_cast<int>(value));
+            }
+        str = (*end == ',') ? end + 1 : end;
+        }
+    return values;
+    }
+
+static bool parseArgs(int argc, char *argv[], BenchConfig &config)
+    {
+    bool ok = true;
+    for(int i=1; i<argc && ok; i++)
+        {
+        char const *arg = argv[i];
+        if(strcmp(arg, "--json") == 0)
+            {
+            config.mJson = true;
+            }
+        else if(strncmp(arg, "--rows=", 7) == 0)
+            {
+            config.mRowCounts = parseIntList(arg + 7);
+            }
+        else if(strncmp(arg, "--data-size=", 12) == 0)
+            {
+            config.mDataSizes = parseIntList(arg + 12);
+            }
+        else if(strncmp(arg, "--filter=", 9) == 0)
+            {
+            config.mFilter = arg + 9;
+            }
+        else
+            {
+            ok = false;
+            }
+        }
+    if(config.mRowCounts.empty())
+        {
+        config.mRowCounts.push_back(10000);
+        }
+    if(config.mDataSizes.empty())
+        {
+        config.mDataSizes.push_back(16);
+        }
+    return ok;
+    }
+
+int main(int argc, char *argv[])
+    {
+    BenchConfig config;
+    if(!parseArgs(argc, argv, config))
+        {
+        printf("Usage: DbBench [--json] [--rows=10000,...] [--data-size=16,...] "
+            "[--filter=name]\n");
+        return 2;
+        }
+    BenchRunner runner(config);
+    DbResult result;
+    for(size_t rowIndex=0; rowIndex<config.mRowCounts.size() && result.isOk(); rowIndex++)
+        {
+        for(size_t sizeIndex=0; sizeIndex<config.mDataSizes.size() && result.isOk();
+            sizeIndex++)
+            {
+            runner.setRun(config.mRowCounts[rowIndex], config.mDataSizes[sizeIndex]);
+            result = runBenchmarks(runner);
+            }
+        }
+    if(config.mJson)
+        {
+        runner.printJson();
+        }
+    else
+        {
+        runner.printText();
+        }
+    if(!result.isOk())
+        {
+        fprintf(stderr, "%s\n", getDbResultString(result).c_str());
+        }
+    remove(BenchDbName);
+    return result.isOk() ? 0 : 1;
+    }
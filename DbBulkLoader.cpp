@@ -0,0 +1,166 @@
+/*
+* DbBulkLoader.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbBulkLoader.h"
+
+#if(DB_USE_MYSQL)
+#include "errmsg.h"         // For CR_ client error numbers
+#include <stdio.h>          // For snprintf
+#include <string.h>         // For memcpy
+#include <algorithm>        // For std::min
+#include <charconv>         // For std::to_chars
+#include <cmath>            // For std::isfinite
+
+void DbBulkRow::startField()
+    {
+    if(!mFirstField)
+        {
+        *mBuffer += '\t';
+        }
+    mFirstField = false;
+    }
+
+void DbBulkRow::addNull()
+    {
+    startField();
+    *mBuffer += "\\N";
+    }
+
+void DbBulkRow::addInt(int64_t val)
+    {
+    startField();
+    char buf[24];
+    char *end = std::to_chars(buf, buf + sizeof(buf), val).ptr;
+    mBuffer->append(buf, end);
+    }
+
+void DbBulkRow::addDouble(double val)
+    {
+    if(std::isfinite(val))
+        {
+        startField();
+        char buf[32];
+        int len = snprintf(buf, sizeof(buf), "%.17g", val);
+        mBuffer->append(buf, len);
+        }
+    else
+        {
+        addNull();
+        }
+    }
+
+void DbBulkRow::addText(char const *val, size_t len)
+    {
+    startField();
+    for(size_t i=0; i<len; i++)
+        {
+        char c = val[i];
+        switch(c)
+            {
+            case '\t':  *mBuffer += "\\t";      break;
+            case '\n':  *mBuffer += "\\n";      break;
+            case '\r':  *mBuffer += "\\r";      break;
+            case '\\':  *mBuffer += "\\\\";     break;
+            case '\0':  *mBuffer += "\\0";      break;
+            default:    *mBuffer += c;          break;
+            }
+        }
+    }
+
+// Rows are only encoded when the client library asks for more data, so the
+// buffer holds about one read of data plus one row.
+int DbBulkLoader::readData(char *buf, unsigned int len)
+    {
+    mBuffer.erase(0, mReadPos);
+    mReadPos = 0;
+    while(!mProducerDone && mBuffer.length() < len)
+        {
+        size_t rowStart = mBuffer.length();
+        DbBulkRow row(mBuffer);
+        if((*mProducer)(row))
+            {
+            mBuffer += '\n';
+            mNumRows++;
+            }
+        else
+            {
+            mBuffer.resize(rowStart);
+            mProducerDone = true;
+            }
+        }
+    size_t numBytes = std::min(static_cast<size_t>(len), mBuffer.length());
+    memcpy(buf, mBuffer.data(), numBytes);
+    mReadPos = numBytes;
+    mNumBytes += numBytes;
+    return static_cast<int>(numBytes);
+    }
+
+int DbBulkLoader::infileInit(void **ptr, char const * /*fileName*/, void *userData)
+    {
+    *ptr = userData;
+    return 0;
+    }
+
+int DbBulkLoader::infileRead(void *ptr, char *buf, unsigned int len)
+    {
+    return static_cast<DbBulkLoader*>(ptr)->readData(buf, len);
+    }
+
+void DbBulkLoader::infileEnd(void * /*ptr*/)
+    {
+    }
+
+int DbBulkLoader::infileError(void * /*ptr*/, char *errorMsg,
+    unsigned int errorMsgLen)
+    {
+    snprintf(errorMsg, errorMsgLen, "Bulk load data error");
+    return CR_UNKNOWN_ERROR;
+    }
+
+DbResult DbBulkLoader::load(char const *table, char const *columns,
+    DbBulkProducer const &producer)
+    {
+    DbResult result;
+    MYSQL *conn = mDb.getConnection();
+    mProducer = &producer;
+    mBuffer.clear();
+    mReadPos = 0;
+    mProducerDone = false;
+    mNumRows = 0;
+    mNumBytes = 0;
+    std::string query = "LOAD DATA LOCAL INFILE 'DbBulkLoader' INTO TABLE ";
+    query += table;
+    query += " CHARACTER SET utf8mb4 FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\'"
+        " LINES TERMINATED BY '\\n' (";
+    query += columns;
+    query += ')';
+
+    if(!(mDb.getConnectOptions() & DCO_LocalInfile))
+        {
+        result.setNativeError(DEC_Misuse, CR_UNKNOWN_ERROR,
+            "The connection must be opened with DCO_LocalInfile");
+        }
+    if(result.isOk())
+        {
+        mDb.finishUnfinishedResults(nullptr);
+        // The handler ignores the file name, so only these rows are sent.
+        mysql_set_local_infile_handler(conn, infileInit, infileRead, infileEnd,
+            infileError, this);
+        if(mysql_real_query(conn, query.data(),
+            static_cast<unsigned long>(query.length())) != 0)
+            {
+            result = DbMysql::DbAccess::getResult(mysql_errno(conn), mysql_error(conn),
+                "Unable to load data");
+            }
+        mDb.refuseLocalFiles();
+        }
+    mProducer = nullptr;
+    mBuffer.clear();
+    mBuffer.shrink_to_fit();
+    return result;
+    }
+
+#endif
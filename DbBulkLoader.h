@@ -0,0 +1,108 @@
+/*
+* DbBulkLoader.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Loads rows into a MySQL table using LOAD DATA LOCAL INFILE. The rows are
+// read from a producer function while the data is sent, so no file is
+// written, and only about one network buffer of rows is in memory.
+// This is much faster than INSERT statements for large initial loads.
+//
+// The server must allow local_infile, and the connection must be opened
+// with DCO_LocalInfile. Requests from the server for files are refused
+// except while a load runs, and then only these rows are sent, so the
+// server cannot read other files.
+//
+// Example:
+//    db.open("localhost/dbname", DCO_LocalInfile);
+//    DbBulkLoader loader(db);
+//    int i = 0;
+//    DbResult result = loader.load("Cat", "catId, catName",
+//        [&](DbBulkRow &row)
+//            {
+//            if(i == numCats)
+//                { return false; }
+//            row.addInt(i);
+//            row.addText(names[i++].c_str());
+//            return true;
+//            });
+
+#ifndef DB_BULK_LOADER_H
+#define DB_BULK_LOADER_H
+
+#include "DbAccess.h"
+
+#if(DB_USE_MYSQL)
+#include <functional>
+#include <string>
+
+/// Encodes the fields of one row in the LOAD DATA text format. The fields
+/// must be added in the same order as the columns.
+class DbBulkRow
+    {
+    public:
+        void addNull();
+        void addInt(int64_t val);
+        /// The server cannot parse infinity or NaN, so they are added as NULL.
+        /// This matches RETURN_DOUBLE_NULL_AS_NAN.
+        void addDouble(double val);
+        /// Tabs, newlines, backslashes and zero characters are escaped.
+        void addText(char const *val, size_t len);
+        void addText(char const *val)
+            { addText(val, strlen(val)); }
+
+    private:
+        friend class DbBulkLoader;
+        std::string *mBuffer;
+        bool mFirstField;
+
+        DbBulkRow(std::string &buffer):
+            mBuffer(&buffer), mFirstField(true)
+            {}
+        void startField();
+    };
+
+/// Return false when there are no more rows. The fields must only be added
+/// to the row when returning true.
+typedef std::function<bool(DbBulkRow &row)> DbBulkProducer;
+
+class DbBulkLoader
+    {
+    public:
+        explicit DbBulkLoader(DbMysql::DbAccess &db):
+            mDb(db), mProducer(nullptr), mReadPos(0), mProducerDone(false),
+            mNumRows(0), mNumBytes(0)
+            {}
+
+        /// @param table The table to load.
+        /// @param columns Comma separated column names in the order of the
+        ///     fields added to each row.
+        DbResult load(char const *table, char const *columns,
+            DbBulkProducer const &producer);
+
+        /// The number of rows read from the producer by the last load.
+        uint64_t getNumRows() const
+            { return mNumRows; }
+        uint64_t getNumBytes() const
+            { return mNumBytes; }
+
+    private:
+        DbMysql::DbAccess &mDb;
+        DbBulkProducer const *mProducer;
+        // The rows that are encoded but not yet sent start at mReadPos.
+        std::string mBuffer;
+        size_t mReadPos;
+        bool mProducerDone;
+        uint64_t mNumRows;
+        uint64_t mNumBytes;
+
+        int readData(char *buf, unsigned int len);
+        static int infileInit(void **ptr, char const *fileName, void *userData);
+        static int infileRead(void *ptr, char *buf, unsigned int len);
+        static void infileEnd(void *ptr);
+        static int infileError(void *ptr, char *errorMsg, unsigned int errorMsgLen);
+    };
+
+#endif
+#endif
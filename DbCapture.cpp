@@ -0,0 +1,345 @@
+/*
+* DbCapture.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbCapture.h"
+#include <string.h>
+
+static char const CaptureMagic[] = "DBCAP";
+static uint64_t const CaptureVersion = 1;
+
+enum CaptureRecordTypes { RT_Sql=1, RT_Exec=2 };
+
+static void putVarint(std::string &buf, uint64_t val)
+    {
+    while(val >= 0x80)
+        {
+        buf += static_cast<char>((val & 0x7F) | 0x80);
+        val >>= 7;
+        }
+    buf += static_cast<char>(val);
+    }
+
+// Small negative values are also short.
+static void putSignedVarint(std::string &buf, int64_t val)
+    {
+    putVarint(buf, (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63));
+    }
+
+static void putBytes(std::string &buf, std::string const &bytes)
+    {
+    putVarint(buf, bytes.length());
+    buf += bytes;
+    }
+
+DbResult DbCaptureLog::open(char const *fileName)
+    {
+    DbResult result;
+    close();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFile = fopen(fileName, "wb");
+    if(mFile)
+        {
+        // A large buffer keeps the writes from slowing the statements.
+        setvbuf(mFile, nullptr, _IOFBF, 1 << 16);
+        std::string header(CaptureMagic, sizeof(CaptureMagic) - 1);
+        putVarint(header, CaptureVersion);
+        fwrite(header.data(), 1, header.length(), mFile);
+        mStartTime = Clock::now();
+        mSqlIds.clear();
+        mThreadIndices.clear();
+        }
+    else
+        {
+        result.setError(std::string("Unable to open capture file ") + fileName);
+        }
+    return result;
+    }
+
+void DbCaptureLog::close()
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(mFile)
+        {
+        fclose(mFile);
+        mFile = nullptr;
+        }
+    }
+
+uint64_t DbCaptureLog::getNs(Clock::time_point time) const
+    {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        time - mStartTime).count());
+    }
+
+uint32_t DbCaptureLog::getSqlId(char const *sql)
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint32_t sqlId;
+    auto iter = mSqlIds.find(sql);
+    if(iter != mSqlIds.end())
+        {
+        sqlId = iter->second;
+        }
+    else
+        {
+        sqlId = static_cast<uint32_t>(mSqlIds.size());
+        mSqlIds.emplace(sql, sqlId);
+        if(mFile)
+            {
+            mRecord.clear();
+            putVarint(mRecord, RT_Sql);
+            putVarint(mRecord, sqlId);
+            putBytes(mRecord, sql);
+            fwrite(mRecord.data(), 1, mRecord.length(), mFile);
+            }
+        }
+    return sqlId;
+    }
+
+void DbCaptureLog::writeExecution(DbCapturedExecution &exec)
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto iter = mThreadIndices.emplace(std::this_thread::get_id(),
+        static_cast<uint32_t>(mThreadIndices.size())).first;
+    exec.mThreadIndex = iter->second;
+    if(mFile)
+        {
+        mRecord.clear();
+        putVarint(mRecord, RT_Exec);
+        putVarint(mRecord, exec.mSqlId);
+        putVarint(mRecord, exec.mThreadIndex);
+        putVarint(mRecord, exec.mStartNs);
+        putVarint(mRecord, exec.mDurationNs);
+        putVarint(mRecord, exec.mNumRows);
+        putSignedVarint(mRecord, exec.mNativeCode);
+        putVarint(mRecord, exec.mBinds.size());
+        for(size_t i=0; i<exec.mBinds.size(); i++)
+            {
+            DbCapturedValue const &value = exec.mBinds[i];
+            putVarint(mRecord, i + 1);
+            putVarint(mRecord, value.mType);
+            switch(value.mType)
+                {
+                case DCV_Int:
+                    putSignedVarint(mRecord, value.mInt);
+                    break;
+
+                case DCV_Double:
+                    {
+                    char bytes[sizeof(double)];
+                    memcpy(bytes, &value.mDouble, sizeof(bytes));
+                    mRecord.append(bytes, sizeof(bytes));
+                    }
+                    break;
+
+                case DCV_Text:
+                case DCV_Blob:
+                    putBytes(mRecord, value.mText);
+                    break;
+
+                case DCV_None:
+                case DCV_Null:
+                    break;
+                }
+            }
+        fwrite(mRecord.data(), 1, mRecord.length(), mFile);
+        }
+    }
+
+/// Reads the values of a capture file. The file is read into memory.
+class CaptureParser
+    {
+    public:
+        CaptureParser(std::string const &data):
+            mData(data), mPos(0), mOk(true)
+            {}
+        bool isOk() const
+            { return mOk; }
+        bool atEnd() const
+            { return mPos >= mData.length(); }
+        uint64_t getVarint()
+            {
+            uint64_t val = 0;
+            int shift = 0;
+            bool more = true;
+            while(more && mOk)
+                {
+                if(mPos < mData.length() && shift < 64)
+                    {
+                    unsigned char byte = static_cast<unsigned char>(mData[mPos++]);
+                    val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    shift += 7;
+                    more = (byte & 0x80) != 0;
+                    }
+                else
+                    {
+                    mOk = false;
+                    }
+                }
+            return val;
+            }
+        int64_t getSignedVarint()
+            {
+            uint64_t val = getVarint();
+            return static_cast<int64_t>((val >> 1) ^ (~(val & 1) + 1));
+            }
+        std::string getBytes(size_t len)
+            {
+            std::string bytes;
+            // mPos is never past the end, and a corrupt length can be large
+            // enough that mPos + len overflows.
+            if(len <= mData.length() - mPos)
+                {
+                bytes = mData.substr(mPos, len);
+                mPos += len;
+                }
+            else
+                {
+                mOk = false;
+                }
+            return bytes;
+            }
+
+    private:
+        std::string const &mData;
+        size_t mPos;
+        bool mOk;
+    };
+
+DbResult DbCaptureReader::read(char const *fileName)
+    {
+    DbResult result;
+    mSql.clear();
+    mExecutions.clear();
+    std::string data;
+    FILE *file = fopen(fileName, "rb");
+    if(file)
+        {
+        char buf[1 << 16];
+        size_t numBytes;
+        while((numBytes = fread(buf, 1, sizeof(buf), file)) > 0)
+            {
+            data.append(buf, numBytes);
+            }
+        fclose(file);
+        }
+    else
+        {
+        result.setError(std::string("Unable to open capture file ") + fileName);
+        }
+    CaptureParser parser(data);
+    if(result.isOk())
+        {
+        if(parser.getBytes(sizeof(CaptureMagic) - 1) != CaptureMagic ||
+            parser.getVarint() != CaptureVersion)
+            {
+            result.setError(std::string("Not a capture file ") + fileName);
+            }
+        }
+    while(result.isOk() && parser.isOk() && !parser.atEnd())
+        {
+        uint64_t type = parser.getVarint();
+        if(type == RT_Sql)
+            {
+            size_t sqlId = parser.getVarint();
+            std::string sql = parser.getBytes(parser.getVarint());
+            if(parser.isOk())
+                {
+                // The log numbers each new query with the next id, so a
+                // larger id is corrupt, and would allocate a large table.
+                if(sqlId < mSql.size())
+                    {
+                    mSql[sqlId] = sql;
+                    }
+                else if(sqlId == mSql.size())
+                    {
+                    mSql.push_back(sql);
+                    }
+                else
+                    {
+                    result.setError("Capture SQL id is out of order");
+                    }
+                }
+            }
+        else if(type == RT_Exec)
+            {
+            DbCapturedExecution exec;
+            exec.mSqlId = static_cast<uint32_t>(parser.getVarint());
+            exec.mThreadIndex = static_cast<uint32_t>(parser.getVarint());
+            exec.mStartNs = parser.getVarint();
+            exec.mDurationNs = parser.getVarint();
+            exec.mNumRows = static_cast<uint32_t>(parser.getVarint());
+            exec.mNativeCode = static_cast<int>(parser.getSignedVarint());
+            size_t numBinds = parser.getVarint();
+            for(size_t i=0; i<numBinds && parser.isOk() && result.isOk(); i++)
+                {
+                size_t ordinal = parser.getVarint();
+                DbCapturedValue value;
+                value.mType = static_cast<DbCaptureValueTypes>(parser.getVarint());
+                switch(value.mType)
+                    {
+                    case DCV_Int:
+                        value.mInt = parser.getSignedVarint();
+                        break;
+
+                    case DCV_Double:
+                        {
+                        std::string bytes = parser.getBytes(sizeof(double));
+                        if(parser.isOk())
+                            {
+                            memcpy(&value.mDouble, bytes.data(), sizeof(double));
+                            }
+                        }
+                        break;
+
+                    case DCV_Text:
+                    case DCV_Blob:
+                        value.mText = parser.getBytes(parser.getVarint());
+                        break;
+
+                    case DCV_None:
+                    case DCV_Null:
+                        break;
+
+                    default:
+                        // The size of the value is not known, so the rest of
+                        // the file cannot be read.
+                        result.setError("Unknown capture value type");
+                        break;
+                    }
+                // The log writes the ordinals in order starting at 1, so
+                // another ordinal is corrupt, and could allocate a large
+                // vector.
+                if(result.isOk())
+                    {
+                    if(ordinal == exec.mBinds.size() + 1)
+                        {
+                        exec.mBinds.push_back(value);
+                        }
+                    else
+                        {
+                        result.setError("Capture bind ordinal is out of order");
+                        }
+                    }
+                }
+            if(result.isOk() && parser.isOk())
+                {
+                if(exec.mSqlId >= mSql.size())
+                    {
+                    result.setError("Capture execution refers to unknown SQL");
+                    }
+                mExecutions.push_back(exec);
+                }
+            }
+        else
+            {
+            result.setError("Unknown capture record type");
+            }
+        }
+    // The last record may be cut off if the application ended without
+    // closing the log, so that record is ignored.
+    return result;
+    }
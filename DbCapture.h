@@ -0,0 +1,129 @@
+/*
+* DbCapture.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Records the statements that are executed, so that a workload can be
+// replayed later with DbReplay. Each execution is recorded with the SQL,
+// the bound values, the thread, the start time relative to the start of the
+// capture, and the time that it took. The SQL text of each statement is
+// only written once.
+//
+// Example:
+//    DbCaptureLog capture;
+//    DbResult result = capture.open("workload.dbcap");
+//    db.setCaptureLog(&capture);
+//    ... run the application ...
+//    db.setCaptureLog(nullptr);
+//    capture.close();
+// Then run "DbReplay workload.dbcap copy.db" with a copy of the database
+// as it was when the capture started.
+//
+// The file contains a header, then records. Integers are written as
+// variable length values with 7 bits in each byte.
+//   Header:        "DBCAP" version
+//   SQL record:    RT_Sql sqlId length text
+//   Exec record:   RT_Exec sqlId threadIndex startNs durationNs numRows
+//                  nativeCode numBinds [ordinal type value]...
+
+#ifndef DB_CAPTURE_H
+#define DB_CAPTURE_H
+
+#include "DbResult.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum DbCaptureValueTypes { DCV_None, DCV_Null, DCV_Int, DCV_Double, DCV_Text, DCV_Blob };
+
+/// A bound value. Text and blobs are copied.
+struct DbCapturedValue
+    {
+    DbCapturedValue():
+        mType(DCV_None), mInt(0), mDouble(0)
+        {}
+    DbCaptureValueTypes mType;
+    int64_t mInt;
+    double mDouble;
+    std::string mText;
+    };
+
+/// One execution of a statement, from the first step until the statement
+/// is done, reset, or set again.
+struct DbCapturedExecution
+    {
+    DbCapturedExecution():
+        mSqlId(0), mThreadIndex(0), mStartNs(0), mDurationNs(0), mNumRows(0),
+        mNativeCode(0)
+        {}
+    uint32_t mSqlId;
+    // Threads are numbered in the order that they first execute a statement.
+    uint32_t mThreadIndex;
+    uint64_t mStartNs;
+    uint64_t mDurationNs;
+    uint32_t mNumRows;
+    // The native error code, or 0 if there was no error.
+    int mNativeCode;
+    // The index is the ordinal - 1. Unbound parameters have type DCV_None.
+    std::vector<DbCapturedValue> mBinds;
+    };
+
+/// Writes a capture file. This is thread safe, so one log can be used by
+/// the statements of many threads and connections.
+class DbCaptureLog
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        DbCaptureLog():
+            mFile(nullptr)
+            {}
+        ~DbCaptureLog()
+            { close(); }
+        /// The times of the executions are relative to the time of this call.
+        DbResult open(char const *fileName);
+        void close();
+        bool isOpen() const
+            { return mFile != nullptr; }
+
+        /// Returns the id of the SQL text. The text is written to the file
+        /// the first time.
+        uint32_t getSqlId(char const *sql);
+        uint64_t getNs(Clock::time_point time) const;
+        /// The thread index is set by this function.
+        void writeExecution(DbCapturedExecution &exec);
+
+    private:
+        FILE *mFile;
+        std::mutex mMutex;
+        Clock::time_point mStartTime;
+        std::unordered_map<std::string, uint32_t> mSqlIds;
+        std::unordered_map<std::thread::id, uint32_t> mThreadIndices;
+        // This is only used inside the lock.
+        std::string mRecord;
+    };
+
+/// Reads all records of a capture file.
+class DbCaptureReader
+    {
+    public:
+        DbResult read(char const *fileName);
+        /// The SQL text of each sqlId.
+        std::vector<std::string> const &getSql() const
+            { return mSql; }
+        /// The executions in the order that they ended.
+        std::vector<DbCapturedExecution> const &getExecutions() const
+            { return mExecutions; }
+
+    private:
+        std::vector<std::string> mSql;
+        std::vector<DbCapturedExecution> mExecutions;
+    };
+
+#endif
@@ -0,0 +1,74 @@
+/*
+* DbColumnMap.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbColumnMap.h"
+
+DbColumnMap::DbColumnMap(DbColumnMap const &other):
+    mBuilt(false), mNames(other.mNames)
+    {
+    if(other.mBuilt)
+        {
+        setBuilt();
+        }
+    }
+
+DbColumnMap &DbColumnMap::operator=(DbColumnMap const &other)
+    {
+    if(this != &other)
+        {
+        clear();
+        mNames = other.mNames;
+        if(other.mBuilt)
+            {
+            setBuilt();
+            }
+        }
+    return *this;
+    }
+
+void DbColumnMap::clear()
+    {
+    mBuilt = false;
+    mIndices.clear();
+    mNames.clear();
+    }
+
+void DbColumnMap::addColumnName(char const *name)
+    {
+    mNames.push_back(name ? name : "");
+    }
+
+void DbColumnMap::setBuilt()
+    {
+    // The map is built after all names are added so that the string views
+    // are not invalidated by the vector growing.
+    mIndices.clear();
+    mIndices.reserve(mNames.size());
+    for(size_t i=0; i<mNames.size(); i++)
+        {
+        mIndices.emplace(mNames[i], static_cast<int>(i));
+        }
+    mBuilt = true;
+    }
+
+DbColumn DbColumnMap::findColumn(std::string_view name) const
+    {
+    DbColumn column;
+    auto iter = mIndices.find(name);
+    if(iter == mIndices.end())
+        {
+        size_t dotPos = name.rfind('.');
+        if(dotPos != std::string_view::npos)
+            {
+            iter = mIndices.find(name.substr(dotPos+1));
+            }
+        }
+    if(iter != mIndices.end())
+        {
+        column = DbColumn(iter->second);
+        }
+    return column;
+    }
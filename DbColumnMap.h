@@ -0,0 +1,74 @@
+/*
+* DbColumnMap.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Provides fast lookup of result column indices by name. The names are read
+// once from the metadata of a prepared statement, so looking up columns by name
+// in row loops does not search the query string.
+
+#ifndef DB_COLUMN_MAP_H
+#define DB_COLUMN_MAP_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// A result column that has been resolved from a name. This can be kept
+/// while the statement query is not changed.
+class DbColumn
+    {
+    public:
+        DbColumn():
+            mIndex(-1)
+            {}
+        explicit DbColumn(int index):
+            mIndex(index)
+            {}
+        /// The column index is base 0.
+        int getIndex() const
+            { return mIndex; }
+        bool isValid() const
+            { return mIndex >= 0; }
+
+    private:
+        int mIndex;
+    };
+
+/// Maps column names from statement metadata to column indices.
+/// If multiple columns have the same name, the first column is found.
+class DbColumnMap
+    {
+    public:
+        DbColumnMap():
+            mBuilt(false)
+            {}
+        /// The copy rebuilds the map, since the keys refer to the names that
+        /// are owned by each map. Moves also use these.
+        DbColumnMap(DbColumnMap const &other);
+        DbColumnMap &operator=(DbColumnMap const &other);
+        /// This must be called when the query of the statement changes.
+        void clear();
+
+        /// Add the names in column order, then call setBuilt().
+        void addColumnName(char const *name);
+        void setBuilt();
+        bool isBuilt() const
+            { return mBuilt; }
+        size_t getColumnCount() const
+            { return mNames.size(); }
+
+        /// Returns an invalid column if the name is not found. A name such as
+        /// "Person.id" will also find a column named "id".
+        DbColumn findColumn(std::string_view name) const;
+
+    private:
+        bool mBuilt;
+        std::vector<std::string> mNames;
+        // The keys refer to the strings in mNames.
+        std::unordered_map<std::string_view, int> mIndices;
+    };
+
+#endif
@@ -0,0 +1,200 @@
+/*
+* DbConnectionPool.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbConnectionPool.h"
+
+#if(DB_USE_MYSQL)
+#include "errmsg.h"         // For CR_ client error numbers
+
+DbPooledConnection &DbPooledConnection::operator=(DbPooledConnection &&other)
+    {
+    if(this != &other)
+        {
+        release();
+        mPool = other.mPool;
+        mIndex = other.mIndex;
+        other.mPool = nullptr;
+        }
+    return *this;
+    }
+
+DbMysql::DbAccess &DbPooledConnection::getDb()
+    {
+    std::lock_guard<std::mutex> lock(mPool->mMutex);
+    return *mPool->mEntries[mIndex].mDb;
+    }
+
+void DbPooledConnection::release()
+    {
+    if(mPool)
+        {
+        mPool->releaseEntry(mIndex);
+        mPool = nullptr;
+        }
+    }
+
+size_t DbConnectionPool::reserveEntry()
+    {
+    size_t index = 0;
+    while(index < mEntries.size() && mEntries[index].mLeased)
+        {
+        index++;
+        }
+    if(index == mEntries.size() && mEntries.size() < mConfig.mMaxConnections)
+        {
+        PoolEntry entry;
+        entry.mDb.reset(new DbMysql::DbAccess());
+        entry.mOpen = false;
+        entry.mLeased = false;
+        mEntries.push_back(std::move(entry));
+        }
+    if(index < mEntries.size())
+        {
+        mEntries[index].mLeased = true;
+        }
+    return index;
+    }
+
+// This is called without the lock, since the entry is marked as leased and
+// the checks may wait for the server. The entry is a copy, and the caller
+// stores the times back into the pool.
+DbResult DbConnectionPool::checkEntry(PoolEntry &entry, bool &reconnected)
+    {
+    DbResult result;
+    Clock::time_point now = Clock::now();
+    reconnected = false;
+    if(!entry.mOpen)
+        {
+        result = entry.mDb->open(mDbName.c_str(), mConfig.mConnectOptions);
+        entry.mOpenTime = now;
+        }
+    else if(now - entry.mOpenTime > std::chrono::seconds(mConfig.mMaxLifetimeSeconds))
+        {
+        result = entry.mDb->reconnect();
+        entry.mOpenTime = now;
+        reconnected = true;
+        }
+    else if(now - entry.mLastUse > std::chrono::seconds(mConfig.mIdlePingSeconds))
+        {
+        if(!entry.mDb->ping().isOk())
+            {
+            result = entry.mDb->reconnect();
+            entry.mOpenTime = now;
+            reconnected = true;
+            }
+        }
+    entry.mOpen = result.isOk();
+    if(!result.isOk())
+        {
+        // Open again on the next lease.
+        entry.mDb->close();
+        }
+    return result;
+    }
+
+DbResult DbConnectionPool::lease(DbPooledConnection &conn)
+    {
+    conn.release();
+    DbResult result;
+    Clock::time_point startTime = Clock::now();
+    Clock::time_point endTime = startTime +
+        std::chrono::milliseconds(mConfig.mLeaseTimeoutMs);
+    size_t index;
+    bool waited = false;
+    std::unique_lock<std::mutex> lock(mMutex);
+    while((index = reserveEntry()) == mEntries.size())
+        {
+        waited = true;
+        if(mAvailable.wait_until(lock, endTime) == std::cv_status::timeout)
+            {
+            index = reserveEntry();
+            if(index == mEntries.size())
+                {
+                result.setNativeError(DEC_Busy, CR_CONN_HOST_ERROR,
+                    "Timed out waiting for pooled connection");
+                break;
+                }
+            }
+        }
+    if(result.isOk())
+        {
+        std::chrono::duration<double> waitTime = Clock::now() - startTime;
+        mStats.mNumLeases++;
+        if(waited)
+            {
+            mStats.mNumWaits++;
+            mStats.mTotalWaitSeconds += waitTime.count();
+            if(waitTime.count() > mStats.mMaxWaitSeconds)
+                {
+                mStats.mMaxWaitSeconds = waitTime.count();
+                }
+            }
+        // The vector may grow while unlocked, but the DbAccess does not move.
+        PoolEntry entry = mEntries[index];
+        lock.unlock();
+        bool reconnected;
+        result = checkEntry(entry, reconnected);
+        lock.lock();
+        mEntries[index].mOpenTime = entry.mOpenTime;
+        mEntries[index].mOpen = entry.mOpen;
+        if(reconnected)
+            {
+            mStats.mNumReconnects++;
+            }
+        if(result.isOk())
+            {
+            conn.mPool = this;
+            conn.mIndex = index;
+            }
+        else
+            {
+            mEntries[index].mLeased = false;
+            mAvailable.notify_one();
+            }
+        }
+    return result;
+    }
+
+// A transaction that the lease did not end is rolled back, so that it is
+// not continued by the next lease. This is done without the lock, since the
+// entry is still marked as leased. If the rollback fails, the connection is
+// closed and opened again on the next lease.
+void DbConnectionPool::releaseEntry(size_t index)
+    {
+    std::shared_ptr<DbMysql::DbAccess> db;
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        db = mEntries[index].mDb;
+        }
+    bool open = true;
+    if(db->isInTransaction() && !db->rollback().isOk())
+        {
+        db->close();
+        open = false;
+        }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries[index].mLastUse = Clock::now();
+    mEntries[index].mOpen = mEntries[index].mOpen && open;
+    mEntries[index].mLeased = false;
+    mAvailable.notify_one();
+    }
+
+DbPoolStats DbConnectionPool::getStats()
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    DbPoolStats stats = mStats;
+    stats.mNumOpenConnections = 0;
+    for(auto const &entry : mEntries)
+        {
+        if(entry.mOpen)
+            {
+            stats.mNumOpenConnections++;
+            }
+        }
+    return stats;
+    }
+
+#endif
@@ -0,0 +1,150 @@
+/*
+* DbConnectionPool.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Shares a set of MySQL connections between threads. A thread leases a
+// connection, uses it, then returns it to the pool when the lease is
+// destroyed. A connection must only be used by one thread at a time, so
+// the pool is the way to use the database from many threads.
+//
+// Example:
+//    DbConnectionPool pool("localhost/dbname");
+//    DbPooledConnection conn;
+//    DbResult result = pool.lease(conn);
+//    if(result.isOk())
+//        {
+//        DbStatement stmt(conn.getDb());
+//        ...
+//        }
+
+#ifndef DB_CONNECTION_POOL_H
+#define DB_CONNECTION_POOL_H
+
+#include "DbAccess.h"
+
+#if(DB_USE_MYSQL)
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct DbPoolConfig
+    {
+    DbPoolConfig():
+        mMaxConnections(8), mMaxLifetimeSeconds(3600), mIdlePingSeconds(30),
+        mLeaseTimeoutMs(5000), mConnectOptions(DCO_None)
+        {}
+    size_t mMaxConnections;
+    // A connection that is older than this is reopened when it is leased.
+    // This prevents the server wait_timeout from closing it.
+    int mMaxLifetimeSeconds;
+    // A connection that has not been used for this long is pinged when it
+    // is leased, and reconnected if the ping fails.
+    int mIdlePingSeconds;
+    // If all connections are in use for this long, lease returns DEC_Busy.
+    int mLeaseTimeoutMs;
+    // A combination of DbConnectOptions that is used to open each connection.
+    int mConnectOptions;
+    };
+
+struct DbPoolStats
+    {
+    DbPoolStats():
+        mNumLeases(0), mNumWaits(0), mTotalWaitSeconds(0), mMaxWaitSeconds(0),
+        mNumReconnects(0), mNumOpenConnections(0)
+        {}
+    size_t mNumLeases;
+    // The number of leases that had to wait for another thread to return
+    // a connection.
+    size_t mNumWaits;
+    double mTotalWaitSeconds;
+    double mMaxWaitSeconds;
+    size_t mNumReconnects;
+    size_t mNumOpenConnections;
+    };
+
+class DbConnectionPool;
+
+/// A leased connection. The connection is returned to the pool when this
+/// is destroyed or when release() is called. A transaction that was not
+/// ended is rolled back when the connection is returned. This can be moved,
+/// but not copied.
+class DbPooledConnection
+    {
+    public:
+        DbPooledConnection():
+            mPool(nullptr), mIndex(0)
+            {}
+        DbPooledConnection(DbPooledConnection &&other):
+            mPool(other.mPool), mIndex(other.mIndex)
+            { other.mPool = nullptr; }
+        DbPooledConnection &operator=(DbPooledConnection &&other);
+        DbPooledConnection(DbPooledConnection const &) = delete;
+        DbPooledConnection &operator=(DbPooledConnection const &) = delete;
+        ~DbPooledConnection()
+            { release(); }
+
+        bool isLeased() const
+            { return mPool != nullptr; }
+        /// This must only be called while the connection is leased. Any
+        /// statements must be destroyed before the lease is released.
+        DbMysql::DbAccess &getDb();
+        void release();
+
+    private:
+        friend class DbConnectionPool;
+        DbConnectionPool *mPool;
+        size_t mIndex;
+    };
+
+class DbConnectionPool
+    {
+    public:
+        /// @param dbName This is host/dbname as used by DbAccess::open().
+        explicit DbConnectionPool(char const *dbName,
+            DbPoolConfig const &config = DbPoolConfig()):
+            mDbName(dbName), mConfig(config)
+            {}
+        /// All leases must be released before the pool is destroyed.
+        ~DbConnectionPool()
+            {}
+
+        /// Leases a connection that is open and has been checked. A new
+        /// connection is opened if none are free and the maximum has not
+        /// been reached, otherwise this waits for a connection to be returned.
+        DbResult lease(DbPooledConnection &conn);
+        DbPoolStats getStats();
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+        struct PoolEntry
+            {
+            // This is shared so that a copy of the entry can be used while
+            // the pool is unlocked.
+            std::shared_ptr<DbMysql::DbAccess> mDb;
+            Clock::time_point mOpenTime;
+            Clock::time_point mLastUse;
+            bool mOpen;
+            bool mLeased;
+            };
+        friend class DbPooledConnection;
+        std::string mDbName;
+        DbPoolConfig mConfig;
+        std::mutex mMutex;
+        std::condition_variable mAvailable;
+        std::vector<PoolEntry> mEntries;
+        DbPoolStats mStats;
+
+        // Returns the index of a free entry that is marked as leased, or
+        // the number of entries if none are free.
+        size_t reserveEntry();
+        DbResult checkEntry(PoolEntry &entry, bool &reconnected);
+        void releaseEntry(size_t index);
+    };
+
+#endif
+#endif
@@ -0,0 +1,386 @@
+/*
+* DbConstString.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Allows defining SQL query strings at compile time. This has most of the
+// functions of DbString, but when the chain is assigned to a constexpr
+// variable, the whole query is built by the compiler. There are no run time
+// string appends or copies, and the number of bind parameters and a hash of
+// the query are also known at compile time.
+//
+// Examples:
+//    constexpr auto selectStr = DbConstSql().SELECT("id, name").FROM("Person").
+//        WHERE("id", "=", ":id");
+//    static_assert(selectStr.getNumBindParameters() == 1, "Bad bind count");
+//    DbStatement stmt(db, selectStr.getDbStr());
+//
+// The generated text is identical to DbString, so getDbStringHash() of a run
+// time DbString will match getHash() of the same DbConstString.
+
+#ifndef DB_CONST_STRING_H
+#define DB_CONST_STRING_H
+#include "DbString.h"       // For DATABASE and DbValueParamCounts
+#include "DbSqlScanner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Returns a 64 bit FNV-1a hash of the string. This can be used at compile
+/// time or at run time, and can be used as a key for caching statements.
+constexpr uint64_t getDbStringHash(char const *str, size_t len)
+    {
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i=0; i<len; i++)
+        {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 1099511628211ull;
+        }
+    return hash;
+    }
+
+/// The maximum capacity needed for the text of a DbValueParamCounts.
+/// For example FOUR_PARAMS is "?,?,?,?".
+const size_t DbConstParamsCapacity = FOUR_PARAMS * 2 - 1;
+
+// The capacity is the maximum number of characters that the query can contain
+// without the ending semicolon. Most functions append exactly the length of the
+// arguments, but functions with comma delimited lists may remove spaces.
+template<size_t Capacity> class DbConstString
+    {
+    template<size_t OtherCapacity> friend class DbConstString;
+    public:
+        constexpr DbConstString():
+            mStr{}, mLength(0)
+            {}
+
+        /// Returns the query string with an ending semicolon.
+        constexpr char const *getDbStr() const
+            { return mStr; }
+        /// Returns the length of the query string with the ending semicolon.
+        constexpr size_t length() const
+            { return mLength + 1; }
+        constexpr uint64_t getHash() const
+            { return getDbStringHash(mStr, length()); }
+
+        // This module expects that bind parameters start with a colon and have a
+        // name, or use a question mark. Quoted text and comments are skipped.
+        constexpr size_t getNumBindParameters() const
+            { return countDbSqlParameters(mStr, mLength); }
+
+        // Appends "CREATE table"
+        template<size_t N> constexpr DbConstString<13+N> CREATE_TABLE(
+            char const (&table)[N]) const
+            { return startStatement<13+N>("CREATE TABLE ", table); }
+
+        // Appends "SELECT column"
+        template<size_t N> constexpr DbConstString<7+N> SELECT(
+            char const (&column)[N]) const
+            { return startStatement<7+N>("SELECT ", column); }
+
+        /// Appends "INSERT INTO table"
+        template<size_t N> constexpr DbConstString<12+N> INSERT_INTO(
+            char const (&table)[N]) const
+            { return startStatement<12+N>("INSERT INTO ", table); }
+
+        /// See DbString::INSERT_OR_REPLACE_INTO.
+        template<size_t N> constexpr DbConstString<23+N> INSERT_OR_REPLACE_INTO(
+            char const (&table)[N]) const
+            {
+#if(DATABASE == DB_SQLITE)
+            return startStatement<23+N>("INSERT OR REPLACE INTO ", table);
+#else
+            return startStatement<23+N>("REPLACE ", table);
+#endif
+            }
+
+        /// See DbString::INSERT_OR_IGNORE.
+        template<size_t N> constexpr DbConstString<22+N> INSERT_OR_IGNORE(
+            char const (&table)[N]) const
+            {
+#if(DATABASE == DB_SQLITE)
+            return startStatement<22+N>("INSERT OR IGNORE INTO ", table);
+#else
+            return startStatement<22+N>("INSERT IGNORE INTO ", table);
+#endif
+            }
+
+        /// Appends "UPDATE table"
+        template<size_t N> constexpr DbConstString<7+N> UPDATE(
+            char const (&table)[N]) const
+            { return startStatement<7+N>("UPDATE ", table); }
+
+        /// Appends "DELETE FROM "
+        template<size_t N> constexpr DbConstString<12+N> DELETE_FROM(
+            char const (&table)[N]) const
+            { return startStatement<12+N>("DELETE FROM ", table); }
+
+        /// See DbString::DROP_INDEX.
+        template<size_t N> constexpr DbConstString<Capacity+21+N> DROP_INDEX(
+            char const (&index)[N]) const
+            { return append<21+N>("DROP INDEX IF EXISTS ", index); }
+
+        /// See DbString::CREATE_INDEX.
+        template<size_t N1, size_t N2, size_t N3>
+        constexpr DbConstString<Capacity+34+N1+N2+N3> CREATE_INDEX(
+            char const (&index)[N1], char const (&table)[N2],
+            char const (&column)[N3]) const
+            {
+            return append<34+N1+N2+N3>("CREATE INDEX IF NOT EXISTS ", index, " ON ",
+                table, "(", column, ")");
+            }
+
+        /// Appends " FROM "
+        template<size_t N> constexpr DbConstString<Capacity+6+N> FROM(
+            char const (&table)[N]) const
+            { return append<6+N>(" FROM ", table); }
+
+        /// Appends " ORDER BY "
+        template<size_t N> constexpr DbConstString<Capacity+10+N> ORDER_BY(
+            char const (&table)[N]) const
+            { return append<10+N>(" ORDER BY ", table); }
+
+        /// Appends " ORDER BY table DESC ". This is the same as
+        /// DbString::ORDER_BY with ascend set to false.
+        template<size_t N> constexpr DbConstString<Capacity+16+N> ORDER_BY_DESC(
+            char const (&table)[N]) const
+            { return append<16+N>(" ORDER BY ", table, " DESC "); }
+
+        /// Appends " JOIN "
+        template<size_t N> constexpr DbConstString<Capacity+6+N> JOIN(
+            char const (&table)[N]) const
+            { return append<6+N>(" JOIN ", table); }
+
+        /// Appends " ON "
+        template<size_t N> constexpr DbConstString<Capacity+4+N> ON(
+            char const (&condition)[N]) const
+            { return append<4+N>(" ON ", condition); }
+
+        /// Appends "(columnName1, columnName2)"
+        template<size_t N> constexpr DbConstString<Capacity+2+N> COLUMNS(
+            char const (&columnNames)[N]) const
+            { return append<2+N>("(", columnNames, ")"); }
+
+        /// Appends "(columnDef1, columnDef2)"
+        template<size_t N> constexpr DbConstString<Capacity+2+N> COLUMN_DEFS(
+            char const (&defs)[N]) const
+            { return append<2+N>("(", defs, ")"); }
+
+        /// Appends " VALUES (columnValue1, columnValue2)"
+        template<size_t N> constexpr DbConstString<Capacity+10+N> VALUES(
+            char const (&values)[N]) const
+            {
+            DbConstString<Capacity+10+N> str = append<10+N>(" VALUES (");
+            str.appendArgs(values, N-1, true);
+            str.appendChars(")", 1);
+            return str;
+            }
+        constexpr DbConstString<Capacity+10+DbConstParamsCapacity> VALUES(
+            DbValueParamCounts numBindParams) const
+            {
+            DbConstString<Capacity+10+DbConstParamsCapacity> str =
+                append<10+DbConstParamsCapacity>(" VALUES (");
+            str.appendParams(numBindParams);
+            str.appendChars(")", 1);
+            return str;
+            }
+
+        /// Appends " SET column1=value1,column2=value2"
+        /// The number of columns and values must match.
+        template<size_t N1, size_t N2> constexpr DbConstString<Capacity+5+N1+N2> SET(
+            char const (&columnNames)[N1], char const (&values)[N2]) const
+            {
+            DbConstString<Capacity+5+N1+N2> str = append<5+N1+N2>(" SET ");
+            str.appendColumnNamesAndValues(columnNames, N1-1, values, N2-1);
+            return str;
+            }
+
+        /// Appends " WHERE columnName operStr (colVal)"
+        template<size_t N1, size_t N2, size_t N3>
+        constexpr DbConstString<Capacity+9+N1+N2+N3> WHERE(char const (&columnName)[N1],
+            char const (&operStr)[N2], char const (&values)[N3]) const
+            { return appendCondition<9+N1+N2+N3>(" WHERE ", columnName, operStr, values); }
+        template<size_t N1, size_t N2>
+        constexpr DbConstString<Capacity+9+N1+N2+DbConstParamsCapacity> WHERE(
+            char const (&columnName)[N1], char const (&operStr)[N2],
+            DbValueParamCounts numBindParams) const
+            {
+            return appendCondition<9+N1+N2+DbConstParamsCapacity>(" WHERE ",
+                columnName, operStr, numBindParams);
+            }
+
+        /// Appends " AND columnName operStr (colVal)"
+        template<size_t N1, size_t N2, size_t N3>
+        constexpr DbConstString<Capacity+7+N1+N2+N3> AND(char const (&columnName)[N1],
+            char const (&operStr)[N2], char const (&values)[N3]) const
+            { return appendCondition<7+N1+N2+N3>(" AND ", columnName, operStr, values); }
+        template<size_t N1, size_t N2>
+        constexpr DbConstString<Capacity+7+N1+N2+DbConstParamsCapacity> AND(
+            char const (&columnName)[N1], char const (&operStr)[N2],
+            DbValueParamCounts numBindParams) const
+            {
+            return appendCondition<7+N1+N2+DbConstParamsCapacity>(" AND ",
+                columnName, operStr, numBindParams);
+            }
+
+    private:
+        // The extra characters are for the semicolon and the ending null.
+        char mStr[Capacity+2];
+        size_t mLength;
+
+        // Appends characters and keeps the semicolon at the end.
+        constexpr void appendChars(char const *str, size_t len)
+            {
+            for(size_t i=0; i<len; i++)
+                {
+                mStr[mLength++] = str[i];
+                }
+            mStr[mLength] = ';';
+            mStr[mLength+1] = '\0';
+            }
+
+        template<size_t N> constexpr void appendLiteral(char const (&str)[N])
+            { appendChars(str, N-1); }
+
+        // Returns a copy of this string with the literals appended.
+        template<size_t Added, typename ...Literals>
+        constexpr DbConstString<Capacity+Added> append(Literals const &...literals) const
+            {
+            DbConstString<Capacity+Added> str;
+            str.appendChars(mStr, mLength);
+            (str.appendLiteral(literals), ...);
+            return str;
+            }
+
+        // Returns a new string. Previous text is not kept, which is the
+        // same as DbString.
+        template<size_t Size, size_t N1, size_t N2>
+        static constexpr DbConstString<Size> startStatement(
+            char const (&statement)[N1], char const (&arg)[N2])
+            {
+            DbConstString<Size> str;
+            str.appendLiteral(statement);
+            str.appendLiteral(arg);
+            return str;
+            }
+
+        template<size_t Added, size_t N1, size_t N2, size_t N3>
+        constexpr DbConstString<Capacity+Added> appendCondition(char const (&conj)[N1],
+            char const (&columnName)[N2], char const (&operStr)[N3],
+            char const *values, size_t valuesLen) const
+            {
+            DbConstString<Capacity+Added> str = append<Added>(conj, columnName, operStr, "(");
+            str.appendArgs(values, valuesLen, true);
+            str.appendChars(")", 1);
+            return str;
+            }
+        template<size_t Added, size_t N1, size_t N2, size_t N3, size_t N4>
+        constexpr DbConstString<Capacity+Added> appendCondition(char const (&conj)[N1],
+            char const (&columnName)[N2], char const (&operStr)[N3],
+            char const (&values)[N4]) const
+            {
+            return appendCondition<Added>(conj, columnName, operStr, values, N4-1);
+            }
+        template<size_t Added, size_t N1, size_t N2, size_t N3>
+        constexpr DbConstString<Capacity+Added> appendCondition(char const (&conj)[N1],
+            char const (&columnName)[N2], char const (&operStr)[N3],
+            DbValueParamCounts numBindParams) const
+            {
+            DbConstString<Capacity+Added> str = append<Added>(conj, columnName, operStr, "(");
+            str.appendParams(numBindParams);
+            str.appendChars(")", 1);
+            return str;
+            }
+
+        // This is the same as the DbValues constructor.
+        constexpr void appendParams(DbValueParamCounts numBindParams)
+            {
+            for(size_t i=0; i<static_cast<size_t>(numBindParams); i++)
+                {
+                if(i != 0)
+                    { appendChars(",", 1); }
+                appendChars("?", 1);
+                }
+            }
+
+        // This is the same as findNextArg in DbString.cpp.
+        static constexpr size_t findNextArg(char const *args, size_t argsLen,
+            size_t &argIter, size_t &startArgPos)
+            {
+            size_t retArgLen = 0;
+            if(argIter != String::npos)
+                {
+                while(argIter < argsLen && args[argIter] == ' ')
+                    { argIter++; }
+                startArgPos = argIter;
+                argIter = String::npos;
+                for(size_t i=startArgPos; i<argsLen; i++)
+                    {
+                    if(args[i] == ',')
+                        {
+                        argIter = i;
+                        break;
+                        }
+                    }
+                if(argIter != String::npos)
+                    {
+                    retArgLen = argIter - startArgPos;
+                    argIter++;      // Add one for comma
+                    }
+                else
+                    {
+                    retArgLen = argsLen - startArgPos;
+                    }
+                }
+            return retArgLen;
+            }
+
+        // This is the same as appendArg in DbString.cpp.
+        constexpr bool appendArg(char const *args, size_t argsLen, size_t &argPos,
+            bool insertDelimiter)
+            {
+            size_t initialArgPos = argPos;
+            size_t startArgPos = 0;
+            size_t len = findNextArg(args, argsLen, argPos, startArgPos);
+            if(len > 0)
+                {
+                if(initialArgPos != 0 && insertDelimiter)
+                    {
+                    appendChars(",", 1);
+                    }
+                appendChars(&args[startArgPos], len);
+                }
+            return(len > 0);
+            }
+
+        constexpr void appendArgs(char const *args, size_t argsLen, bool insertDelimiter)
+            {
+            size_t startArgPos = 0;
+            while(startArgPos != String::npos)
+                {
+                appendArg(args, argsLen, startArgPos, insertDelimiter);
+                }
+            }
+
+        constexpr void appendColumnNamesAndValues(char const *columnNames,
+            size_t columnNamesLen, char const *values, size_t valuesLen)
+            {
+            size_t startColPos = 0;
+            size_t startValPos = 0;
+            while(startColPos != String::npos && startValPos != String::npos)
+                {
+                if(appendArg(columnNames, columnNamesLen, startColPos, true))
+                    {
+                    appendChars("=", 1);
+                    appendArg(values, valuesLen, startValPos, false);
+                    }
+                }
+            }
+    };
+
+/// This is the start of a compile time query.
+/// For example: constexpr auto str = DbConstSql().SELECT("id").FROM("Person");
+typedef DbConstString<0> DbConstSql;
+
+#endif
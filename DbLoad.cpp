@@ -0,0 +1,566 @@
+/*
+* DbLoad.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// A load generator that shows how the access layer behaves with several
+// threads. Reader threads look up rows and writer threads update rows, with
+// keys from a Zipfian distribution so that some rows are much hotter than
+// others.
+//
+// Usage: DbLoad [--readers=4] [--writers=1] [--seconds=2] [--rows=10000]
+//      [--theta=0.99] [--mode=shared|separate] [--wal] [--busy-timeout=1000]
+//      [--error-rate=0] [--json]
+//  --mode=shared   All threads use one DbAccess, and each operation is
+//                  serialized with an SQLiteMutexGuard. This is the default.
+//  --mode=separate Each thread opens its own DbAccess, so SQLite locks the
+//                  database file, and operations can return SQLITE_BUSY.
+//  --wal           Use write-ahead logging, so readers do not wait for writers.
+//  --busy-timeout  The milliseconds that each separate connection waits in
+//                  SQLite for a lock before it returns SQLITE_BUSY. Without
+//                  this, readers keep the file locked and writers starve
+//                  unless --wal is used. The wait is part of the latency.
+//  --theta         The Zipfian skew. 0 is uniform, and 0.99 is very skewed.
+//  --error-rate    The fraction of operations that also format an error
+//                  string, which uses the global DbResult mutex.
+// The time spent blocked is reported separately for the SQLite mutex, for
+// retries after SQLITE_BUSY, and for formatting errors. The number of
+// SQLITE_BUSY retries is also reported.
+
+#include "DbAccess.h"
+#include "DbString.h"
+#include <stdio.h>
+
+#if(DATABASE == DB_SQLITE)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static char const * const LoadDbName = "DbLoad.db";
+
+typedef std::chrono::steady_clock Clock;
+
+static double getNs(Clock::duration duration)
+    {
+    return static_cast<double>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(duration).count());
+    }
+
+struct LoadConfig
+    {
+    LoadConfig():
+        mNumReaders(4), mNumWriters(1), mSeconds(2), mNumRows(10000),
+        mTheta(0.99), mSeparate(false), mWal(false), mBusyTimeoutMs(1000),
+        mErrorRate(0), mJson(false)
+        {}
+    int mNumReaders;
+    int mNumWriters;
+    double mSeconds;
+    int mNumRows;
+    double mTheta;
+    bool mSeparate;
+    bool mWal;
+    int mBusyTimeoutMs;
+    double mErrorRate;
+    bool mJson;
+    };
+
+/// Generates values from 0 to numValues-1, where lower values are more
+/// likely. This is the method from "Quickly Generating Billion-Record
+/// Synthetic Databases" by Gray et al.
+class ZipfianGenerator
+    {
+    public:
+        ZipfianGenerator(int numValues, double theta, unsigned seed);
+        int next();
+
+    private:
+        std::mt19937 mGenerator;
+        std::uniform_real_distribution<double> mDistribution;
+        int mNumValues;
+        double mTheta;
+        double mAlpha;
+        double mZetaN;
+        double mEta;
+    };
+
+ZipfianGenerator::ZipfianGenerator(int numValues, double theta, unsigned seed):
+    mGenerator(seed), mDistribution(0, 1), mNumValues(numValues), mTheta(theta)
+    {
+    mZetaN = 0;
+    for(int i=1; i<=numValues; i++)
+        {
+        mZetaN += 1 / pow(i, theta);
+        }
+    double zeta2 = 1 + 1 / pow(2, theta);
+    mAlpha = 1 / (1 - theta);
+    mEta = (1 - pow(2.0 / numValues, 1 - theta)) / (1 - zeta2 / mZetaN);
+    }
+
+int ZipfianGenerator::next()
+    {
+    double u = mDistribution(mGenerator);
+    double uz = u * mZetaN;
+    int value;
+    if(uz < 1)
+        {
+        value = 0;
+        }
+    else if(uz < 1 + pow(0.5, mTheta))
+        {
+        value = 1;
+        }
+    else
+        {
+        value = static_cast<int>(mNumValues * pow(mEta * u - mEta + 1, mAlpha));
+        }
+    return std::min(value, mNumValues - 1);
+    }
+
+/// The measurements of one thread.
+struct ThreadStats
+    {
+    ThreadStats():
+        mNumOps(0), mNumBusy(0), mNumErrors(0), mLockNs(0), mBusyNs(0),
+        mErrorNs(0)
+        {}
+    std::vector<double> mLatencies;
+    uint64_t mNumOps;
+    // The number of retries after SQLITE_BUSY was returned. This does not
+    // include the waits within the busy timeout.
+    uint64_t mNumBusy;
+    uint64_t mNumErrors;
+    double mLockNs;
+    double mBusyNs;
+    double mErrorNs;
+    };
+
+/// The state that is shared by all threads.
+class LoadRun
+    {
+    public:
+        explicit LoadRun(LoadConfig const &config):
+            mConfig(config), mStop(false)
+            {}
+        DbResult open();
+        void runThread(bool writer, int threadIndex, ThreadStats &stats);
+        void stop()
+            { mStop = true; }
+        DbResult getCountSum(int64_t &sum);
+
+    private:
+        LoadConfig const &mConfig;
+        std::atomic<bool> mStop;
+        DbAccess mSharedDb;
+        std::unique_ptr<SQLiteMutex> mMutex;
+
+        DbResult openDb(DbAccess &db, int openFlags);
+        DbResult runOp(DbStatement &stmt, bool writer, ThreadStats &stats);
+    };
+
+static DbResult executeQuery(DbAccess &db, char const *query)
+    {
+    DbStatement stmt(db);
+    DbResult result = stmt.set(query);
+    if(result.isOk())
+        {
+        result = stmt.execute();
+        }
+    return result;
+    }
+
+DbResult LoadRun::openDb(DbAccess &db, int openFlags)
+    {
+    DbResult result = db.open(LoadDbName, openFlags);
+    if(result.isOk() && mConfig.mWal)
+        {
+        result = executeQuery(db, "PRAGMA journal_mode=WAL");
+        }
+    return result;
+    }
+
+static void removeDbFiles()
+    {
+    remove(LoadDbName);
+    remove((std::string(LoadDbName) + "-wal").c_str());
+    remove((std::string(LoadDbName) + "-shm").c_str());
+    }
+
+DbResult LoadRun::open()
+    {
+    removeDbFiles();
+    DbResult result = openDb(mSharedDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    if(result.isOk())
+        {
+        mMutex.reset(new SQLiteMutex(mSharedDb));
+        DbString query;
+        query.CREATE_TABLE("Item").COLUMN_DEFS("id INTEGER PRIMARY KEY, "
+            "count INTEGER, data TEXT");
+        result = executeQuery(mSharedDb, query.getDbStr().c_str());
+        }
+    if(result.isOk())
+        {
+        DbTransaction transaction(mSharedDb);
+        DbStatement stmt(mSharedDb);
+        DbString query;
+        query.INSERT_INTO("Item").COLUMNS("id, count, data").VALUES(THREE_PARAMS);
+        result = stmt.set(query.getDbStr().c_str());
+        for(int i=0; i<mConfig.mNumRows && result.isOk(); i++)
+            {
+            stmt.bindInt(1, i);
+            stmt.bindInt(2, 0);
+            stmt.bindText(3, "data");
+            result = stmt.execute();
+            stmt.reset();
+            }
+        }
+    return result;
+    }
+
+// Runs one statement until it is not busy. The statement must be bound.
+DbResult LoadRun::runOp(DbStatement &stmt, bool writer, ThreadStats &stats)
+    {
+    DbResult result;
+    Clock::time_point busyStart;
+    bool wasBusy = false;
+    bool busy;
+    do
+        {
+        stmt.reset();
+        if(writer)
+            {
+            result = stmt.execute();
+            }
+        else
+            {
+            result = stmt.getRow();
+            }
+        busy = (result.getCategory() == DEC_Busy);
+        if(busy)
+            {
+            if(!wasBusy)
+                {
+                busyStart = Clock::now();
+                wasBusy = true;
+                }
+            stats.mNumBusy++;
+            std::this_thread::yield();
+            }
+        } while(busy && !mStop);
+    if(wasBusy)
+        {
+        stats.mBusyNs += getNs(Clock::now() - busyStart);
+        }
+    return result;
+    }
+
+void LoadRun::runThread(bool writer, int threadIndex, ThreadStats &stats)
+    {
+    DbAccess separateDb;
+    DbResult result;
+    if(mConfig.mSeparate)
+        {
+        // Only this thread uses the connection, so SQLite does not need to
+        // lock it.
+        result = openDb(separateDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE |
+            SQLITE_OPEN_NOMUTEX);
+        if(result.isOk())
+            {
+            std::string query = "PRAGMA busy_timeout=" +
+                std::to_string(mConfig.mBusyTimeoutMs);
+            result = executeQuery(separateDb, query.c_str());
+            }
+        }
+    DbAccess &db = mConfig.mSeparate ? separateDb : mSharedDb;
+    ZipfianGenerator keys(mConfig.mNumRows, mConfig.mTheta,
+        static_cast<unsigned>(threadIndex + 1));
+    std::mt19937 errorGenerator(static_cast<unsigned>(threadIndex + 1));
+    std::uniform_real_distribution<double> errorDistribution(0, 1);
+    std::unique_ptr<DbStatement> stmt;
+    if(result.isOk())
+        {
+        SQLiteMutexGuard guard(*mMutex);
+        stmt.reset(new DbStatement(db));
+        // DbString::SET only sets columns to bound values.
+        DbString query(writer ? "UPDATE Item SET count = count + 1" : "");
+        if(writer)
+            {
+            query.WHERE("id", "=", ONE_PARAM);
+            }
+        else
+            {
+            query.SELECT("count, data").FROM("Item").WHERE("id", "=", ONE_PARAM);
+            }
+        result = stmt->set(query.getDbStr().c_str(), SQLITE_PREPARE_PERSISTENT);
+        }
+    while(result.isOk() && !mStop)
+        {
+        Clock::time_point start = Clock::now();
+        if(mConfig.mSeparate)
+            {
+            stmt->bindInt(1, keys.next());
+            result = runOp(*stmt, writer, stats);
+            }
+        else
+            {
+            mMutex->Enter();
+            Clock::time_point locked = Clock::now();
+            stats.mLockNs += getNs(locked - start);
+            stmt->bindInt(1, keys.next());
+            result = runOp(*stmt, writer, stats);
+            mMutex->Leave();
+            }
+        if(result.isOk() && mConfig.mErrorRate > 0 &&
+            errorDistribution(errorGenerator) < mConfig.mErrorRate)
+            {
+            // This is what an application does when it reports an error.
+            Clock::time_point errorStart = Clock::now();
+            DbResult error;
+            error.setNativeError(DEC_NotFound, SQLITE_DONE, "Unable to get row");
+            error.insertContext("Unable to load item");
+            stats.mNumErrors += getDbResultString(error).empty() ? 0 : 1;
+            stats.mErrorNs += getNs(Clock::now() - errorStart);
+            }
+        if(result.isOk() && !mStop)
+            {
+            stats.mLatencies.push_back(getNs(Clock::now() - start));
+            stats.mNumOps++;
+            }
+        }
+    if(!result.isOk() && !mStop)
+        {
+        fprintf(stderr, "%s\n", getDbResultString(result).c_str());
+        }
+    if(stmt)
+        {
+        SQLiteMutexGuard guard(*mMutex);
+        stmt.reset();
+        }
+    }
+
+DbResult LoadRun::getCountSum(int64_t &sum)
+    {
+    DbStatement stmt(mSharedDb);
+    DbResult result = stmt.set("SELECT SUM(count) FROM Item");
+    if(result.isOk())
+        {
+        result = stmt.getRow();
+        }
+    if(result.isOk())
+        {
+        sum = stmt.getColumnInt64(0);
+        }
+    return result;
+    }
+
+/// The combined measurements of the reader or writer threads.
+struct LoadSummary
+    {
+    LoadSummary(char const *name, std::vector<ThreadStats> const &threads,
+        double seconds);
+    double getLatencyNs(double percent) const;
+
+    char const *mName;
+    size_t mNumThreads;
+    double mSeconds;
+    ThreadStats mTotal;
+    };
+
+LoadSummary::LoadSummary(char const *name, std::vector<ThreadStats> const &threads,
+    double seconds):
+    mName(name), mNumThreads(threads.size()), mSeconds(seconds)
+    {
+    for(auto const &thread : threads)
+        {
+        mTotal.mLatencies.insert(mTotal.mLatencies.end(), thread.mLatencies.begin(),
+            thread.mLatencies.end());
+        mTotal.mNumOps += thread.mNumOps;
+        mTotal.mNumBusy += thread.mNumBusy;
+        mTotal.mNumErrors += thread.mNumErrors;
+        mTotal.mLockNs += thread.mLockNs;
+        mTotal.mBusyNs += thread.mBusyNs;
+        mTotal.mErrorNs += thread.mErrorNs;
+        }
+    std::sort(mTotal.mLatencies.begin(), mTotal.mLatencies.end());
+    }
+
+double LoadSummary::getLatencyNs(double percent) const
+    {
+    std::vector<double> const &latencies = mTotal.mLatencies;
+    double latency = 0;
+    if(latencies.size() > 0)
+        {
+        size_t index = static_cast<size_t>(percent / 100 * latencies.size());
+        latency = latencies[std::min(index, latencies.size() - 1)];
+        }
+    return latency;
+    }
+
+// The blocked times are the percent of the total thread time.
+static void printSummary(LoadSummary const &sum, bool json, bool last)
+    {
+    double threadNs = sum.mSeconds * 1e9 * static_cast<double>(sum.mNumThreads);
+    double lockPercent = threadNs > 0 ? sum.mTotal.mLockNs / threadNs * 100 : 0;
+    double busyPercent = threadNs > 0 ? sum.mTotal.mBusyNs / threadNs * 100 : 0;
+    double errorPercent = threadNs > 0 ? sum.mTotal.mErrorNs / threadNs * 100 : 0;
+    if(json)
+        {
+        printf("    \"%s\": {\"threads\": %zu, \"ops\": %llu, \"opsPerSec\": %.1f, "
+            "\"latencyNs\": {\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, "
+            "\"max\": %.1f}, \"lockPercent\": %.2f, \"busyPercent\": %.2f, "
+            "\"busyRetries\": %llu, \"errorPercent\": %.2f}%s\n", sum.mName,
+            sum.mNumThreads, static_cast<unsigned long long>(sum.mTotal.mNumOps),
+            sum.mTotal.mNumOps / sum.mSeconds, sum.getLatencyNs(50),
+            sum.getLatencyNs(99), sum.getLatencyNs(99.9), sum.getLatencyNs(100),
+            lockPercent, busyPercent,
+            static_cast<unsigned long long>(sum.mTotal.mNumBusy), errorPercent,
+            last ? "" : ",");
+        }
+    else
+        {
+        printf("%-8s %7zu %10.0f %9.0f %9.0f %9.0f %7.2f%% %7.2f%% %8llu %7.2f%%\n",
+            sum.mName, sum.mNumThreads, sum.mTotal.mNumOps / sum.mSeconds,
+            sum.getLatencyNs(50), sum.getLatencyNs(99), sum.getLatencyNs(99.9),
+            lockPercent, busyPercent,
+            static_cast<unsigned long long>(sum.mTotal.mNumBusy), errorPercent);
+        }
+    }
+
+static bool parseArgs(int argc, char *argv[], LoadConfig &config)
+    {
+    bool ok = true;
+    for(int i=1; i<argc && ok; i++)
+        {
+        char const *arg = argv[i];
+        char const *value = strchr(arg, '=');
+        value = value ? value + 1 : "";
+        if(strcmp(arg, "--json") == 0)
+            { config.mJson = true; }
+        else if(strcmp(arg, "--wal") == 0)
+            { config.mWal = true; }
+        else if(strncmp(arg, "--readers=", 10) == 0)
+            { config.mNumReaders = atoi(value); }
+        else if(strncmp(arg, "--writers=", 10) == 0)
+            { config.mNumWriters = atoi(value); }
+        else if(strncmp(arg, "--seconds=", 10) == 0)
+            { config.mSeconds = atof(value); }
+        else if(strncmp(arg, "--rows=", 7) == 0)
+            { config.mNumRows = atoi(value); }
+        else if(strncmp(arg, "--theta=", 8) == 0)
+            { config.mTheta = atof(value); }
+        else if(strncmp(arg, "--busy-timeout=", 15) == 0)
+            { config.mBusyTimeoutMs = atoi(value); }
+        else if(strncmp(arg, "--error-rate=", 13) == 0)
+            { config.mErrorRate = atof(value); }
+        else if(strcmp(arg, "--mode=shared") == 0)
+            { config.mSeparate = false; }
+        else if(strcmp(arg, "--mode=separate") == 0)
+            { config.mSeparate = true; }
+        else
+            { ok = false; }
+        }
+    // The Zipfian generator divides by 1-theta.
+    if(config.mNumRows < 2 || config.mTheta < 0 || config.mTheta >= 1 ||
+        config.mNumReaders < 0 || config.mNumWriters < 0 || config.mSeconds <= 0 ||
+        config.mBusyTimeoutMs < 0)
+        {
+        ok = false;
+        }
+    return ok;
+    }
+
+int main(int argc, char *argv[])
+    {
+    LoadConfig config;
+    if(!parseArgs(argc, argv, config))
+        {
+        printf("Usage: DbLoad [--readers=4] [--writers=1] [--seconds=2] "
+            "[--rows=10000] [--theta=0.99] [--mode=shared|separate] [--wal] "
+            "[--busy-timeout=1000] [--error-rate=0] [--json]\n");
+        return 2;
+        }
+    LoadRun run(config);
+    DbResult result = run.open();
+    std::vector<ThreadStats> readerStats(static_cast<size_t>(config.mNumReaders));
+    std::vector<ThreadStats> writerStats(static_cast<size_t>(config.mNumWriters));
+    double seconds = 0;
+    if(result.isOk())
+        {
+        std::vector<std::thread> threads;
+        Clock::time_point start = Clock::now();
+        for(int i=0; i<config.mNumReaders; i++)
+            {
+            threads.emplace_back(&LoadRun::runThread, &run, false, i,
+                std::ref(readerStats[i]));
+            }
+        for(int i=0; i<config.mNumWriters; i++)
+            {
+            threads.emplace_back(&LoadRun::runThread, &run, true,
+                config.mNumReaders + i, std::ref(writerStats[i]));
+            }
+        std::this_thread::sleep_for(std::chrono::duration<double>(config.mSeconds));
+        run.stop();
+        for(auto &thread : threads)
+            {
+            thread.join();
+            }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    int64_t countSum = 0;
+    if(result.isOk())
+        {
+        result = run.getCountSum(countSum);
+        }
+    if(result.isOk())
+        {
+        LoadSummary readers("readers", readerStats, seconds);
+        LoadSummary writers("writers", writerStats, seconds);
+        // Each update adds one, so the sum shows that no writes were lost.
+        char const *mode = config.mSeparate ? "separate" : "shared";
+        if(config.mJson)
+            {
+            printf("{\n  \"mode\": \"%s\", \"wal\": %s, \"rows\": %d, \"theta\": %.3f, "
+                "\"seconds\": %.3f, \"countSum\": %lld,\n  \"results\": {\n", mode,
+                config.mWal ? "true" : "false", config.mNumRows, config.mTheta,
+                seconds, static_cast<long long>(countSum));
+            printSummary(readers, true, false);
+            printSummary(writers, true, true);
+            printf("  }\n}\n");
+            }
+        else
+            {
+            printf("Mode: %s%s  rows: %d  theta: %.3f  seconds: %.3f  count sum: %lld\n",
+                mode, config.mWal ? " WAL" : "", config.mNumRows, config.mTheta,
+                seconds, static_cast<long long>(countSum));
+            printf("%-8s %7s %10s %9s %9s %9s %8s %8s %8s %8s\n", "Threads", "Count",
+                "Ops/sec", "p50 ns", "p99 ns", "p99.9 ns", "Lock", "Busy",
+                "Retries", "Errors");
+            printSummary(readers, false, false);
+            printSummary(writers, false, true);
+            }
+        }
+    else
+        {
+        fprintf(stderr, "%s\n", getDbResultString(result).c_str());
+        }
+    removeDbFiles();
+    return result.isOk() ? 0 : 1;
+    }
+
+#else
+
+int main()
+    {
+    printf("DbLoad only supports SQLite\n");
+    return 1;
+    }
+
+#endif
@@ -0,0 +1,467 @@
+/*
+* DbReplay.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Replays a workload that was recorded with DbCaptureLog, and reports how the
+// latency of each statement changed. This is normally run against a copy of
+// the database as it was when the capture started, since writes are replayed.
+//
+// Usage: DbReplay captureFile dbFile [--original-timing] [--json]
+//  --original-timing   Wait until the time that each statement started in
+//                      the capture. Otherwise the statements are run as fast
+//                      as possible.
+// The executions are replayed in the order that they started on a single
+// connection, so the results are repeatable, but concurrency between the
+// original threads is not reproduced. Since one connection cannot nest
+// transactions, a BEGIN from one thread while another thread's transaction
+// is open is skipped along with that thread's COMMIT or ROLLBACK, and the
+// thread's statements run in the open transaction. The number of skipped
+// executions is reported.
+
+#include "DbAccess.h"
+#include "DbCapture.h"
+#include <stdio.h>
+
+#if(DATABASE == DB_SQLITE)
+#include <algorithm>
+#include <chrono>
+#include <ctype.h>
+#include <memory>
+#include <set>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ReplayConfig
+    {
+    ReplayConfig():
+        mCaptureFile(nullptr), mDbFile(nullptr), mOriginalTiming(false),
+        mJson(false)
+        {}
+    char const *mCaptureFile;
+    char const *mDbFile;
+    bool mOriginalTiming;
+    bool mJson;
+    };
+
+/// The latencies of the executions of one SQL statement.
+struct ReplayStats
+    {
+    ReplayStats():
+        mSqlId(0), mNumErrors(0), mNumRowDiffs(0)
+        {}
+    static double getMean(std::vector<double> const &latencies);
+    static double getPercentile(std::vector<double> const &latencies,
+        double percent);
+    double getTotalOriginalNs() const
+        { return getMean(mOriginalNs) * static_cast<double>(mOriginalNs.size()); }
+
+    uint32_t mSqlId;
+    std::vector<double> mOriginalNs;
+    std::vector<double> mReplayNs;
+    // Executions that failed in the replay, but not in the capture.
+    uint64_t mNumErrors;
+    // Executions that returned a different number of rows.
+    uint64_t mNumRowDiffs;
+    };
+
+double ReplayStats::getMean(std::vector<double> const &latencies)
+    {
+    double sum = 0;
+    for(double latency : latencies)
+        {
+        sum += latency;
+        }
+    return latencies.size() > 0 ? sum / static_cast<double>(latencies.size()) : 0;
+    }
+
+// The latencies must be sorted.
+double ReplayStats::getPercentile(std::vector<double> const &latencies,
+    double percent)
+    {
+    double latency = 0;
+    if(latencies.size() > 0)
+        {
+        size_t index = static_cast<size_t>(percent / 100 * latencies.size());
+        latency = latencies[std::min(index, latencies.size() - 1)];
+        }
+    return latency;
+    }
+
+static DbResult bindCaptured(DbStatement &stmt, DbCapturedExecution const &exec)
+    {
+    DbResult result;
+    for(size_t i=0; i<exec.mBinds.size() && result.isOk(); i++)
+        {
+        DbCapturedValue const &value = exec.mBinds[i];
+        int ordinal = static_cast<int>(i + 1);
+        int retCode = SQLITE_OK;
+        switch(value.mType)
+            {
+            case DCV_Null:
+                retCode = stmt.bindNull(ordinal);
+                break;
+
+            case DCV_Int:
+                retCode = stmt.bindInt64(ordinal, value.mInt);
+                break;
+
+            case DCV_Double:
+                retCode = stmt.bindDouble(ordinal, value.mDouble);
+                break;
+
+            case DCV_Text:
+                retCode = stmt.bindTextCopy(ordinal, value.mText.data(),
+                    value.mText.length());
+                break;
+
+            case DCV_Blob:
+                retCode = stmt.bindBlobCopy(ordinal, value.mText.data(),
+                    value.mText.length());
+                break;
+
+            case DCV_None:
+                break;
+            }
+        result = DbStatement::getDbResult(retCode);
+        }
+    return result;
+    }
+
+enum ReplayTransactionControls { RTC_None, RTC_Begin, RTC_End };
+
+// Finds whether the SQL starts or ends a transaction. ROLLBACK TO only
+// rolls back to a savepoint, so it does not end the transaction.
+static ReplayTransactionControls getTransactionControl(std::string const &sql)
+    {
+    std::vector<std::string> words;
+    size_t pos = 0;
+    while(words.size() < 2 && pos < sql.length())
+        {
+        while(pos < sql.length() && !isalpha(static_cast<unsigned char>(sql[pos])))
+            {
+            pos++;
+            }
+        std::string word;
+        while(pos < sql.length() && isalpha(static_cast<unsigned char>(sql[pos])))
+            {
+            word += static_cast<char>(toupper(static_cast<unsigned char>(sql[pos++])));
+            }
+        if(!word.empty())
+            {
+            words.push_back(word);
+            }
+        }
+    ReplayTransactionControls control = RTC_None;
+    if(words.size() > 0)
+        {
+        if(words[0] == "BEGIN")
+            {
+            control = RTC_Begin;
+            }
+        else if(words[0] == "COMMIT" || words[0] == "END" ||
+            (words[0] == "ROLLBACK" && (words.size() < 2 || words[1] != "TO")))
+            {
+            control = RTC_End;
+            }
+        }
+    return control;
+    }
+
+/// Runs one execution, and returns the number of rows.
+static DbResult runCaptured(DbStatement &stmt, DbCapturedExecution const &exec,
+    uint32_t &numRows)
+    {
+    numRows = 0;
+    stmt.reset();
+    stmt.clearBindings();
+    DbResult result = bindCaptured(stmt, exec);
+    bool gotRow = true;
+    while(result.isOk() && gotRow)
+        {
+        result = stmt.testRow(gotRow);
+        if(gotRow)
+            {
+            numRows++;
+            }
+        }
+    return result;
+    }
+
+static DbResult replay(ReplayConfig const &config, DbCaptureReader const &reader,
+    std::vector<ReplayStats> &stats, size_t &numSkipped)
+    {
+    DbAccess db;
+    DbResult result = db.open(config.mDbFile);
+    std::vector<DbCapturedExecution const *> executions;
+    for(auto const &exec : reader.getExecutions())
+        {
+        executions.push_back(&exec);
+        }
+    std::stable_sort(executions.begin(), executions.end(),
+        [](DbCapturedExecution const *a, DbCapturedExecution const *b)
+        { return a->mStartNs < b->mStartNs; });
+    std::vector<std::unique_ptr<DbStatement>> statements(reader.getSql().size());
+    std::vector<ReplayTransactionControls> controls;
+    for(auto const &sql : reader.getSql())
+        {
+        controls.push_back(getTransactionControl(sql));
+        }
+    stats.resize(reader.getSql().size());
+    numSkipped = 0;
+    // The thread whose transaction is open on the connection.
+    bool inTransaction = false;
+    uint32_t transactionThread = 0;
+    // The threads whose BEGIN was skipped, so their end is also skipped.
+    std::set<uint32_t> skippedThreads;
+    Clock::time_point start = Clock::now();
+    for(size_t i=0; i<executions.size() && result.isOk(); i++)
+        {
+        DbCapturedExecution const &exec = *executions[i];
+        bool skip = false;
+        switch(controls[exec.mSqlId])
+            {
+            case RTC_Begin:
+                if(inTransaction && transactionThread != exec.mThreadIndex)
+                    {
+                    skippedThreads.insert(exec.mThreadIndex);
+                    skip = true;
+                    }
+                else
+                    {
+                    inTransaction = true;
+                    transactionThread = exec.mThreadIndex;
+                    }
+                break;
+
+            case RTC_End:
+                if(skippedThreads.erase(exec.mThreadIndex) > 0)
+                    {
+                    skip = true;
+                    }
+                else if(transactionThread == exec.mThreadIndex)
+                    {
+                    inTransaction = false;
+                    }
+                break;
+
+            case RTC_None:
+                break;
+            }
+        if(skip)
+            {
+            numSkipped++;
+            }
+        else
+            {
+            ReplayStats &sqlStats = stats[exec.mSqlId];
+            sqlStats.mSqlId = exec.mSqlId;
+            std::unique_ptr<DbStatement> &stmt = statements[exec.mSqlId];
+            if(!stmt)
+                {
+                stmt.reset(new DbStatement(db));
+                result = stmt->set(reader.getSql()[exec.mSqlId].c_str(),
+                    SQLITE_PREPARE_PERSISTENT);
+                if(!result.isOk())
+                    {
+                    result.insertContext(reader.getSql()[exec.mSqlId].c_str());
+                    }
+                }
+            if(result.isOk())
+                {
+                if(config.mOriginalTiming)
+                    {
+                    std::this_thread::sleep_until(start +
+                        std::chrono::nanoseconds(exec.mStartNs));
+                    }
+                uint32_t numRows;
+                Clock::time_point execStart = Clock::now();
+                DbResult execResult = runCaptured(*stmt, exec, numRows);
+                double replayNs = static_cast<double>(std::chrono::duration_cast<
+                    std::chrono::nanoseconds>(Clock::now() - execStart).count());
+                // Errors that also happened in the capture are expected.
+                if(!execResult.isOk() && exec.mNativeCode == 0)
+                    {
+                    sqlStats.mNumErrors++;
+                    }
+                else if(numRows != exec.mNumRows && exec.mNativeCode == 0)
+                    {
+                    sqlStats.mNumRowDiffs++;
+                    }
+                sqlStats.mOriginalNs.push_back(static_cast<double>(exec.mDurationNs));
+                sqlStats.mReplayNs.push_back(replayNs);
+                }
+            }
+        }
+    stats.erase(std::remove_if(stats.begin(), stats.end(),
+        [](ReplayStats const &sqlStats) { return sqlStats.mOriginalNs.empty(); }),
+        stats.end());
+    for(auto &sqlStats : stats)
+        {
+        std::sort(sqlStats.mOriginalNs.begin(), sqlStats.mOriginalNs.end());
+        std::sort(sqlStats.mReplayNs.begin(), sqlStats.mReplayNs.end());
+        }
+    // The statements that took the most time in the capture are first.
+    std::sort(stats.begin(), stats.end(),
+        [](ReplayStats const &a, ReplayStats const &b)
+        { return a.getTotalOriginalNs() > b.getTotalOriginalNs(); });
+    return result;
+    }
+
+static std::string getJsonString(std::string const &str)
+    {
+    std::string json = "\"";
+    for(char c : str)
+        {
+        if(c == '"' || c == '\\')
+            {
+            json += '\\';
+            json += c;
+            }
+        else if(static_cast<unsigned char>(c) < 0x20)
+            {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+            json += buf;
+            }
+        else
+            {
+            json += c;
+            }
+        }
+    return json + "\"";
+    }
+
+// The SQL is shortened and put on one line for the text output.
+static std::string getShortSql(std::string const &sql)
+    {
+    size_t const maxLength = 60;
+    std::string shortSql;
+    for(char c : sql)
+        {
+        shortSql += isspace(static_cast<unsigned char>(c)) ? ' ' : c;
+        }
+    if(shortSql.length() > maxLength)
+        {
+        shortSql = shortSql.substr(0, maxLength - 3) + "...";
+        }
+    return shortSql;
+    }
+
+static void printStats(ReplayStats const &sqlStats, std::string const &sql,
+    bool json, bool last)
+    {
+    double originalMean = ReplayStats::getMean(sqlStats.mOriginalNs);
+    double replayMean = ReplayStats::getMean(sqlStats.mReplayNs);
+    double diffPercent = originalMean > 0 ?
+        (replayMean - originalMean) / originalMean * 100 : 0;
+    if(json)
+        {
+        printf("    {\"sql\": %s, \"count\": %zu, \"errors\": %llu, \"rowDiffs\": %llu,\n"
+            "      \"originalNs\": {\"mean\": %.1f, \"p50\": %.1f, \"p99\": %.1f},\n"
+            "      \"replayNs\": {\"mean\": %.1f, \"p50\": %.1f, \"p99\": %.1f},\n"
+            "      \"diffPercent\": %.2f}%s\n", getJsonString(sql).c_str(),
+            sqlStats.mOriginalNs.size(),
+            static_cast<unsigned long long>(sqlStats.mNumErrors),
+            static_cast<unsigned long long>(sqlStats.mNumRowDiffs), originalMean,
+            ReplayStats::getPercentile(sqlStats.mOriginalNs, 50),
+            ReplayStats::getPercentile(sqlStats.mOriginalNs, 99), replayMean,
+            ReplayStats::getPercentile(sqlStats.mReplayNs, 50),
+            ReplayStats::getPercentile(sqlStats.mReplayNs, 99), diffPercent,
+            last ? "" : ",");
+        }
+    else
+        {
+        printf("%7zu %10.0f %10.0f %10.0f %10.0f %+8.1f%% %6llu %6llu  %s\n",
+            sqlStats.mOriginalNs.size(), originalMean,
+            ReplayStats::getPercentile(sqlStats.mOriginalNs, 99), replayMean,
+            ReplayStats::getPercentile(sqlStats.mReplayNs, 99), diffPercent,
+            static_cast<unsigned long long>(sqlStats.mNumErrors),
+            static_cast<unsigned long long>(sqlStats.mNumRowDiffs),
+            getShortSql(sql).c_str());
+        }
+    }
+
+static bool parseArgs(int argc, char *argv[], ReplayConfig &config)
+    {
+    bool ok = true;
+    for(int i=1; i<argc && ok; i++)
+        {
+        char const *arg = argv[i];
+        if(strcmp(arg, "--json") == 0)
+            { config.mJson = true; }
+        else if(strcmp(arg, "--original-timing") == 0)
+            { config.mOriginalTiming = true; }
+        else if(arg[0] != '-' && !config.mCaptureFile)
+            { config.mCaptureFile = arg; }
+        else if(arg[0] != '-' && !config.mDbFile)
+            { config.mDbFile = arg; }
+        else
+            { ok = false; }
+        }
+    return ok && config.mDbFile;
+    }
+
+int main(int argc, char *argv[])
+    {
+    ReplayConfig config;
+    if(!parseArgs(argc, argv, config))
+        {
+        printf("Usage: DbReplay captureFile dbFile [--original-timing] [--json]\n");
+        return 2;
+        }
+    DbCaptureReader reader;
+    DbResult result = reader.read(config.mCaptureFile);
+    std::vector<ReplayStats> stats;
+    size_t numSkipped = 0;
+    if(result.isOk())
+        {
+        result = replay(config, reader, stats, numSkipped);
+        }
+    if(result.isOk())
+        {
+        char const *timing = config.mOriginalTiming ? "original" : "fast";
+        if(config.mJson)
+            {
+            printf("{\n  \"timing\": \"%s\", \"executions\": %zu, \"skipped\": %zu,\n"
+                "  \"statements\": [\n", timing, reader.getExecutions().size(),
+                numSkipped);
+            for(size_t i=0; i<stats.size(); i++)
+                {
+                printStats(stats[i], reader.getSql()[stats[i].mSqlId], true,
+                    i == stats.size() - 1);
+                }
+            printf("  ]\n}\n");
+            }
+        else
+            {
+            printf("Timing: %s  executions: %zu  skipped: %zu\n", timing,
+                reader.getExecutions().size(), numSkipped);
+            printf("%7s %10s %10s %10s %10s %9s %6s %6s  %s\n", "Count", "Orig ns",
+                "Orig p99", "Replay ns", "Rep p99", "Diff", "Errors", "Rows", "SQL");
+            for(auto const &sqlStats : stats)
+                {
+                printStats(sqlStats, reader.getSql()[sqlStats.mSqlId], false, false);
+                }
+            }
+        }
+    else
+        {
+        fprintf(stderr, "%s\n", getDbResultString(result).c_str());
+        }
+    return result.isOk() ? 0 : 1;
+    }
+
+#else
+
+int main()
+    {
+    printf("DbReplay only supports SQLite\n");
+    return 1;
+    }
+
+#endif
@@ -40,7 +40,7 @@ class DbResultContext
             std::lock_guard<std::mutex> lock(mMutex);
             mErrorStrings[mResultIndex] = errStr;
             // Increment with rollover.
-            mResultIndex = (mResultIndex & DbResult::RES_CODEMASK) + 1;
+            mResultIndex = (mResultIndex + 1) & DbResult::RES_CODEMASK;
             return resultId;
             }
 
@@ -65,6 +65,12 @@ class DbResultContext
                 }
             return(errStr);
             };
+
+        void eraseErrorString(int resultId)
+            {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mErrorStrings.erase(resultId & DbResult::RES_CODEMASK);
+            }
 /*
         std::string const getAllErrors()
             {
@@ -89,20 +95,52 @@ class DbResultContext
 
 DbResultContext gDbResultContext;
 
+// Stores the string in the central storage. If a string is already stored,
+// the new string is inserted before it.
+void DbResult::storeString(std::string const &errStr)
+    {
+    if(isStored())
+        {
+        gDbResultContext.insertContext(mResultId, errStr);
+        }
+    else
+        {
+        mResultId = (mResultId & (RES_ERROR | RES_WARNING)) |
+            gDbResultContext.setErrorOrWarning(errStr) | RES_STORED;
+        }
+    }
+
+// Moves the static context to the central storage so that the order of
+// multiple contexts is kept.
+void DbResult::storeStaticContext()
+    {
+    if(mStaticContext)
+        {
+        std::string contextStr = mStaticContext;
+        mStaticContext = nullptr;
+        storeString(contextStr);
+        }
+    }
+
 void DbResult::setError(std::string const &errStr)
     {
     if(!(mResultId & RES_ERROR))
         {
-        // This should probably remove the warning string since the warning
-        // is being overwritten. See comments for getMrError().
-        mResultId = gDbResultContext.setErrorOrWarning(errStr);
+        // A warning is overwritten by an error.
+        clear();
+        storeString(errStr);
         mResultId |= RES_ERROR;
         }
+    else if(!isStored() && !mStaticMessage)
+        {
+        // A native error was set without a message.
+        storeString(errStr);
+        }
     else
         {
         std::string addedErrStr = "Multiple errors: ";
         addedErrStr += errStr;
-        gDbResultContext.insertContext(mResultId, addedErrStr);
+        storeString(addedErrStr);
         }
     }
 
@@ -111,7 +149,8 @@ void DbResult::setWarning(std::string const &errStr)
     // Don't overwrite error codes.
     if(!(mResultId & RES_ERROR))
         {
-        mResultId = gDbResultContext.setErrorOrWarning(errStr);
+        clear();
+        storeString(errStr);
         mResultId |= RES_WARNING;
         }
     }
@@ -122,11 +161,117 @@ void DbResult::insertContext(std::string const &errStr)
         {
         setError("Setting context before error");
         }
-    gDbResultContext.insertContext(mResultId, errStr);
+    storeStaticContext();
+    storeString(errStr);
     }
 
-std::string const getDbResultString(DbResult const &result)
+void DbResult::setNativeError(DbErrorCategory category, int nativeCode,
+    char const *staticMsg)
+    {
+    if(!(mResultId & RES_ERROR))
+        {
+        clear();
+        mResultId |= RES_ERROR;
+        mCategory = category;
+        mNativeCode = nativeCode;
+        mStaticMessage = staticMsg;
+        }
+    else
+        {
+        if(mCategory == DEC_None)
+            {
+            mCategory = category;
+            mNativeCode = nativeCode;
+            }
+        if(staticMsg)
+            {
+            if(!mStaticMessage)
+                {
+                mStaticMessage = staticMsg;
+                }
+            else
+                {
+                std::string addedErrStr = "Multiple errors: ";
+                addedErrStr += staticMsg;
+                storeString(addedErrStr);
+                }
+            }
+        }
+    }
+
+void DbResult::insertStaticContext(char const *staticStr)
+    {
+    if(!(mResultId & RES_ERROR))
+        {
+        setError("Setting context before error");
+        }
+    storeStaticContext();
+    mStaticContext = staticStr;
+    }
+
+void DbResult::clear()
     {
-    return gDbResultContext.getErrorString(result.getResultId());
+    if(isStored())
+        {
+        gDbResultContext.eraseErrorString(mResultId);
+        }
+    mResultId = RES_START;
+    mNativeCode = 0;
+    mCategory = DEC_None;
+    mStaticContext = nullptr;
+    mStaticMessage = nullptr;
     }
 
+char const *getDbErrorCategoryName(DbErrorCategory category)
+    {
+    switch(category)
+        {
+        case DEC_None:          return "none";
+        case DEC_Busy:          return "busy";
+        case DEC_Constraint:    return "constraint";
+        case DEC_NotFound:      return "not found";
+        case DEC_Connection:    return "connection";
+        case DEC_Io:            return "io";
+        case DEC_Misuse:        return "misuse";
+        default:                return "other";
+        }
+    }
+
+static void appendLine(std::string &str, char const *line)
+    {
+    if(str.length() > 0)
+        {
+        str += "\n";
+        }
+    str += line;
+    }
+
+std::string const getDbResultString(DbResult const &result)
+    {
+    std::string errStr;
+    if(result.mStaticContext)
+        {
+        errStr = result.mStaticContext;
+        }
+    if(result.isStored())
+        {
+        appendLine(errStr, gDbResultContext.getErrorString(result.getResultId()).c_str());
+        }
+    if(result.mStaticMessage)
+        {
+        appendLine(errStr, result.mStaticMessage);
+        }
+    if(result.mCategory != DEC_None)
+        {
+        if(errStr.length() > 0)
+            {
+            errStr += ' ';
+            }
+        errStr += '[';
+        errStr += getDbErrorCategoryName(result.mCategory);
+        errStr += ' ';
+        errStr += std::to_string(result.mNativeCode);
+        errStr += ']';
+        }
+    return errStr;
+    }
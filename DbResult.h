@@ -10,8 +10,27 @@
 
 #include <string>
 
-// This error class is meant to be as small and fast as a simple integer or boolean in
+/// The general type of an error. This allows callers to branch on errors such
+/// as a busy database or a duplicate row without parsing strings. The native
+/// code from the database is also kept in the DbResult.
+enum DbErrorCategory
+    {
+    DEC_None,           // No category was set. This is used for string errors.
+    DEC_Busy,           // The database or table is busy or locked by another user.
+    DEC_Constraint,     // A row already exists or another constraint failed.
+    DEC_NotFound,       // A row or item was not found.
+    DEC_Connection,     // The library or connection could not be opened or was lost.
+    DEC_Io,             // Disk or network errors.
+    DEC_Misuse,         // Incorrect use of the interface such as a bad bind count.
+    DEC_Other
+    };
+
+// This error class is meant to be as small and fast as a few integers in
 // the case that there are no errors. When there are errors, it will be slower.
+// Errors set with setNativeError() and insertStaticContext() do not build any
+// strings. They are only formatted when getDbResultString() is called, so
+// expected errors (such as a row that already exists) are cheap to test for
+// with getCategory() or getNativeCode().
 // This class is thread safe as long as billions of errors are not created.
 // Errors from all threads get registered to a single set of memory, that can
 // be accessed by the error ID in each thread. The error ID's are incremented
@@ -28,6 +47,11 @@
 //      Displays the following:
 //          "Unable to save results. File sharing violation."
 //
+// - Allows detecting the type of error without strings.
+//      DbResult result = stmt.execute();
+//      if(result.getCategory() == DEC_Constraint)
+//          { result.clear(); }     // The row already exists.
+//
 // - Prevents uninitialized results.
 //      int func1()
 //          { int errCode; return errCode; }    // Returned error is uninitialized.
@@ -55,9 +79,11 @@
 class DbResult
     {
     friend class DbResultContext;
+    friend std::string const getDbResultString(DbResult const &result);
     public:
         DbResult():
-            mResultId(RES_START)
+            mResultId(RES_START), mNativeCode(0), mCategory(DEC_None),
+            mStaticContext(nullptr), mStaticMessage(nullptr)
             {}
 
         /// Returns ok even if a warning was set.
@@ -75,9 +101,32 @@ class DbResult
         void insertContext(std::string const &errStr);
         void setWarning(std::string const &errStr);
 
+        /// Sets an error without building any strings.
+        /// @param nativeCode The error code from the database library, such as
+        ///     an SQLite result code or a MySQL error number.
+        /// @param staticMsg This must be a string literal or other static
+        ///     storage since it is only read when the result string is requested.
+        ///     This may be nullptr.
+        void setNativeError(DbErrorCategory category, int nativeCode,
+            char const *staticMsg);
+
+        /// This is the same as insertContext, except that the string is not
+        /// copied. Only one static context is kept without building strings.
+        /// @param staticStr This must be a string literal or other static storage.
+        void insertStaticContext(char const *staticStr);
+
+        /// Removes any error or warning, and any stored strings. This is
+        /// useful after handling expected errors.
+        void clear();
+
         /// This code is not useful for detecting the type of error.
         int getResultId() const
             { return mResultId; }
+        /// Returns zero if no native code was set.
+        int getNativeCode() const
+            { return mNativeCode; }
+        DbErrorCategory getCategory() const
+            { return mCategory; }
 
     private:
         /// This stores the result code. Only one code is supported in each DbResult class.
@@ -86,18 +135,40 @@ class DbResult
         /// In each DbResult
         ///      - Once an error is set, a warning will not be registered.
         ///      - If a warning is set, an error will overwrite it.
+        /// RES_STORED indicates that strings exist in the central storage.
         int mResultId;
+        int mNativeCode;
+        DbErrorCategory mCategory;
+        char const *mStaticContext;
+        char const *mStaticMessage;
         static const int RES_START = 0;
         static const int RES_ERROR = 0x80000000;
         static const int RES_WARNING = 0x40000000;
-        static const int RES_FLAG_MASK = RES_ERROR | RES_WARNING;
+        static const int RES_STORED = 0x20000000;
+        static const int RES_FLAG_MASK = RES_ERROR | RES_WARNING | RES_STORED;
         static const int RES_CODEMASK = ~RES_FLAG_MASK;
+
+        bool isStored() const
+            { return((mResultId & RES_STORED) > 0); }
+        void storeString(std::string const &errStr);
+        void storeStaticContext();
     };
 
+/// Errors in these categories happen during normal operation, so the database
+/// interfaces do not build strings for them.
+inline bool isDbErrorExpected(DbErrorCategory category)
+    {
+    return(category == DEC_Busy || category == DEC_Constraint ||
+        category == DEC_NotFound);
+    }
+
+/// Returns a short name such as "constraint" for the category.
+char const *getDbErrorCategoryName(DbErrorCategory category);
+
 /// Returns error or warning strings.
+/// The static context is first, then stored strings, then the static message
+/// and the native code.
 /// This clears the error from the central storage of errors.
-/// This has a flaw where if a warning was overwritten with an error, this
-/// will clear the error, but not the warning string. See SetError for comments.
 std::string const getDbResultString(DbResult const &result);
 
 #endif
@@ -0,0 +1,194 @@
+/*
+* DbResultCache.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbResultCache.h"
+#include <stdlib.h>     // For strtod
+
+void DbCachedRows::addColumnName(char const *name)
+    {
+    mColumnNames.push_back(name ? name : "");
+    mNameBytes += sizeof(std::string) + mColumnNames.back().capacity();
+    }
+
+void DbCachedRows::addNull()
+    {
+    CachedValue value;
+    value.mType = CVT_Null;
+    value.mInt = 0;
+    mValues.push_back(value);
+    }
+
+void DbCachedRows::addInt(int64_t val)
+    {
+    CachedValue value;
+    value.mType = CVT_Int;
+    value.mInt = val;
+    mValues.push_back(value);
+    }
+
+void DbCachedRows::addDouble(double val)
+    {
+    CachedValue value;
+    value.mType = CVT_Double;
+    value.mDouble = val;
+    mValues.push_back(value);
+    }
+
+void DbCachedRows::addBytes(char const *val, size_t len, ValueTypes type)
+    {
+    CachedValue value;
+    value.mType = type;
+    value.mText.mOffset = static_cast<uint32_t>(mText.length());
+    value.mText.mLength = static_cast<uint32_t>(len);
+    mText.append(val, len);
+    mText += '\0';
+    mValues.push_back(value);
+    }
+
+int64_t DbCachedRows::getInt(size_t row, int column) const
+    {
+    CachedValue const &value = getValue(row, column);
+    int64_t val = 0;
+    switch(value.mType)
+        {
+        case CVT_Int:       val = value.mInt;                               break;
+        case CVT_Double:    val = static_cast<int64_t>(value.mDouble);      break;
+        case CVT_Text:
+        case CVT_Blob:      val = strtoll(getText(row, column), nullptr, 10); break;
+        case CVT_Null:      break;
+        }
+    return val;
+    }
+
+double DbCachedRows::getDouble(size_t row, int column) const
+    {
+    CachedValue const &value = getValue(row, column);
+    double val = 0;
+    switch(value.mType)
+        {
+        case CVT_Int:       val = static_cast<double>(value.mInt);  break;
+        case CVT_Double:    val = value.mDouble;                    break;
+        case CVT_Text:
+        case CVT_Blob:      val = strtod(getText(row, column), nullptr); break;
+        case CVT_Null:      break;
+        }
+    return val;
+    }
+
+char const *DbCachedRows::getText(size_t row, int column) const
+    {
+    CachedValue const &value = getValue(row, column);
+    return hasBytes(value) ? mText.data() + value.mText.mOffset : nullptr;
+    }
+
+std::string_view DbCachedRows::getBytes(size_t row, int column) const
+    {
+    CachedValue const &value = getValue(row, column);
+    return hasBytes(value) ? std::string_view(mText.data() +
+        value.mText.mOffset, value.mText.mLength) : std::string_view();
+    }
+
+DbResultCache::DbResultCache(size_t maxMemoryBytes)
+    {
+    mStats.mMaxMemoryBytes = maxMemoryBytes;
+    }
+
+std::shared_ptr<DbCachedRows const> DbResultCache::find(std::string const &key)
+    {
+    std::shared_ptr<DbCachedRows const> rows;
+    auto iter = mKeys.find(key);
+    if(iter != mKeys.end())
+        {
+        mEntries.splice(mEntries.begin(), mEntries, iter->second);
+        rows = iter->second->mRows;
+        mStats.mNumHits++;
+        }
+    else
+        {
+        mStats.mNumMisses++;
+        }
+    return rows;
+    }
+
+void DbResultCache::erase(std::list<CacheEntry>::iterator iter)
+    {
+    for(auto const &table : iter->mTables)
+        {
+        auto tableIter = mTableKeys.find(table);
+        if(tableIter != mTableKeys.end())
+            {
+            tableIter->second.erase(iter->mKey);
+            if(tableIter->second.empty())
+                {
+                mTableKeys.erase(tableIter);
+                }
+            }
+        }
+    mStats.mMemoryBytes -= iter->mMemoryBytes;
+    mKeys.erase(iter->mKey);
+    mEntries.erase(iter);
+    mStats.mNumEntries = mEntries.size();
+    }
+
+void DbResultCache::insert(std::string const &key, std::vector<std::string> const &tables,
+    std::shared_ptr<DbCachedRows const> const &rows)
+    {
+    auto iter = mKeys.find(key);
+    if(iter != mKeys.end())
+        {
+        erase(iter->second);
+        }
+    // The key is stored in the entry, the key map and the table sets.
+    size_t memoryBytes = rows->getMemoryBytes() + sizeof(CacheEntry) +
+        key.length() * (2 + tables.size());
+    if(memoryBytes <= mStats.mMaxMemoryBytes)
+        {
+        while(mStats.mMemoryBytes + memoryBytes > mStats.mMaxMemoryBytes)
+            {
+            erase(std::prev(mEntries.end()));
+            mStats.mNumEvictions++;
+            }
+        mEntries.push_front(CacheEntry{key, tables, rows, memoryBytes});
+        mKeys[key] = mEntries.begin();
+        for(auto const &table : tables)
+            {
+            mTableKeys[table].insert(key);
+            }
+        mStats.mMemoryBytes += memoryBytes;
+        mStats.mNumEntries = mEntries.size();
+        mStats.mNumInserts++;
+        }
+    }
+
+void DbResultCache::invalidateTable(std::string const &table)
+    {
+    auto tableIter = mTableKeys.find(table);
+    if(tableIter != mTableKeys.end())
+        {
+        // The set is changed by erase, so the keys are copied.
+        std::vector<std::string> keys(tableIter->second.begin(),
+            tableIter->second.end());
+        for(auto const &key : keys)
+            {
+            auto iter = mKeys.find(key);
+            if(iter != mKeys.end())
+                {
+                erase(iter->second);
+                mStats.mNumInvalidations++;
+                }
+            }
+        }
+    }
+
+void DbResultCache::clear()
+    {
+    mStats.mNumInvalidations += mEntries.size();
+    mEntries.clear();
+    mKeys.clear();
+    mTableKeys.clear();
+    mStats.mMemoryBytes = 0;
+    mStats.mNumEntries = 0;
+    }
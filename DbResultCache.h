@@ -0,0 +1,161 @@
+/*
+* DbResultCache.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Keeps the rows of recent queries in memory, so that a repeated query with
+// the same bound values does not run again. Each result is stored with the
+// tables that the query read, and is removed when one of those tables is
+// written. The least recently used results are removed when the memory
+// limit is reached. This does not depend on a database backend. See
+// DbAccess::enableResultCache() for the SQLite use.
+
+#ifndef DB_RESULT_CACHE_H
+#define DB_RESULT_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// The rows of a query result. The values of all rows are in one table, and
+/// all text is in one buffer.
+class DbCachedRows
+    {
+    public:
+        enum ValueTypes { CVT_Null, CVT_Int, CVT_Double, CVT_Text, CVT_Blob };
+
+        explicit DbCachedRows(int numColumns):
+            mNumColumns(numColumns), mNameBytes(0)
+            {}
+
+        /// Add the column names in order before the rows, so that the
+        /// names are known when the rows are read from the cache.
+        void addColumnName(char const *name);
+        // Add the values of a row in order.
+        void addNull();
+        void addInt(int64_t val);
+        void addDouble(double val);
+        /// A null character is added after the text.
+        void addText(char const *val, size_t len)
+            { addBytes(val, len, CVT_Text); }
+        void addBlob(void const *bytes, size_t len)
+            { addBytes(static_cast<char const *>(bytes), len, CVT_Blob); }
+
+        int getNumColumns() const
+            { return mNumColumns; }
+        char const *getColumnName(int column) const
+            { return mColumnNames[static_cast<size_t>(column)].c_str(); }
+        size_t getNumRows() const
+            { return mNumColumns ? mValues.size() / mNumColumns : 0; }
+        ValueTypes getType(size_t row, int column) const
+            { return getValue(row, column).mType; }
+        int64_t getInt(size_t row, int column) const;
+        double getDouble(size_t row, int column) const;
+        /// Returns nullptr for a NULL or a number. Blobs are returned as
+        /// text in the same way as SQLite.
+        char const *getText(size_t row, int column) const;
+        std::string_view getBytes(size_t row, int column) const;
+        size_t getMemoryBytes() const
+            {
+            return sizeof(*this) + mValues.capacity() * sizeof(CachedValue) +
+                mText.capacity() + mNameBytes;
+            }
+        /// Frees memory that was reserved while the rows were added.
+        void shrink()
+            { mValues.shrink_to_fit(); mText.shrink_to_fit(); }
+
+    private:
+        struct CachedValue
+            {
+            ValueTypes mType;
+            union
+                {
+                int64_t mInt;
+                double mDouble;
+                struct
+                    {
+                    uint32_t mOffset;
+                    uint32_t mLength;
+                    } mText;
+                };
+            };
+        int mNumColumns;
+        std::vector<std::string> mColumnNames;
+        size_t mNameBytes;
+        std::vector<CachedValue> mValues;
+        std::string mText;
+
+        CachedValue const &getValue(size_t row, int column) const
+            { return mValues[row * mNumColumns + column]; }
+        bool hasBytes(CachedValue const &value) const
+            { return value.mType == CVT_Text || value.mType == CVT_Blob; }
+        void addBytes(char const *val, size_t len, ValueTypes type);
+    };
+
+struct DbResultCacheStats
+    {
+    DbResultCacheStats():
+        mNumHits(0), mNumMisses(0), mNumInserts(0), mNumEvictions(0),
+        mNumInvalidations(0), mNumEntries(0), mMemoryBytes(0), mMaxMemoryBytes(0)
+        {}
+    double getHitRatio() const
+        {
+        uint64_t lookups = mNumHits + mNumMisses;
+        return lookups ? static_cast<double>(mNumHits) / lookups : 0;
+        }
+    uint64_t mNumHits;
+    uint64_t mNumMisses;
+    uint64_t mNumInserts;
+    // Results that were removed to stay under the memory limit.
+    uint64_t mNumEvictions;
+    // Results that were removed because a table was written.
+    uint64_t mNumInvalidations;
+    size_t mNumEntries;
+    size_t mMemoryBytes;
+    size_t mMaxMemoryBytes;
+    };
+
+class DbResultCache
+    {
+    public:
+        explicit DbResultCache(size_t maxMemoryBytes);
+
+        /// The key is the query text with the bound values. Returns nullptr
+        /// if the result is not cached. The returned rows stay valid even if
+        /// they are removed from the cache.
+        std::shared_ptr<DbCachedRows const> find(std::string const &key);
+        /// @param tables The tables that the query read.
+        void insert(std::string const &key, std::vector<std::string> const &tables,
+            std::shared_ptr<DbCachedRows const> const &rows);
+        /// Removes the results of all queries that read the table.
+        void invalidateTable(std::string const &table);
+        void clear();
+        DbResultCacheStats const &getStats() const
+            { return mStats; }
+
+    private:
+        struct CacheEntry
+            {
+            std::string mKey;
+            std::vector<std::string> mTables;
+            std::shared_ptr<DbCachedRows const> mRows;
+            size_t mMemoryBytes;
+            };
+        // The most recently used entry is at the front.
+        std::list<CacheEntry> mEntries;
+        std::unordered_map<std::string, std::list<CacheEntry>::iterator> mKeys;
+        // The keys of the entries that read each table.
+        std::unordered_map<std::string, std::unordered_set<std::string>> mTableKeys;
+        DbResultCacheStats mStats;
+
+        void erase(std::list<CacheEntry>::iterator iter);
+    };
+
+#endif
@@ -0,0 +1,155 @@
+/*
+* DbRowBuffer.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbRowBuffer.h"
+#include <algorithm>    // For std::max
+#include <charconv>
+#include <string.h>     // For memcpy
+
+// This is enough for any int64_t or double.
+static size_t const MaxNumberTextSize = 32;
+
+void DbRowBuffer::startRow(size_t numFields)
+    {
+    if(mFields.size() < numFields)
+        {
+        mFields.resize(numFields);
+        }
+    mNumFields = numFields;
+    mUsed = 0;
+    }
+
+char *DbRowBuffer::setFieldSpace(size_t index, size_t len)
+    {
+    size_t needed = mUsed + len + 1;
+    if(mBuffer.size() < needed)
+        {
+        // Grow by doubling so that the buffer soon fits the largest row.
+        mBuffer.resize(std::max(needed, mBuffer.size() * 2));
+        }
+    FieldView &field = mFields[index];
+    field.mOffset = mUsed;
+    field.mLength = len;
+    field.mIsNull = false;
+    field.mType = FT_Text;
+    field.mTextReady = true;
+    mBuffer[mUsed + len] = '\0';
+    mUsed = needed;
+    return mBuffer.data() + field.mOffset;
+    }
+
+void DbRowBuffer::setFieldLength(size_t index, size_t len)
+    {
+    FieldView &field = mFields[index];
+    if(len < field.mLength)
+        {
+        field.mLength = len;
+        mBuffer[field.mOffset + len] = '\0';
+        }
+    }
+
+void DbRowBuffer::setField(size_t index, char const *data, size_t len)
+    {
+    if(data)
+        {
+        memcpy(setFieldSpace(index, len), data, len);
+        }
+    else
+        {
+        setFieldSpace(index, 0);
+        mFields[index].mIsNull = true;
+        }
+    }
+
+void DbRowBuffer::setFieldInt64(size_t index, int64_t val)
+    {
+    setFieldSpace(index, MaxNumberTextSize);
+    FieldView &field = mFields[index];
+    field.mType = FT_Int;
+    field.mTextReady = false;
+    field.mInt = val;
+    }
+
+void DbRowBuffer::setFieldDouble(size_t index, double val)
+    {
+    setFieldSpace(index, MaxNumberTextSize);
+    FieldView &field = mFields[index];
+    field.mType = FT_Double;
+    field.mTextReady = false;
+    field.mDouble = val;
+    }
+
+void DbRowBuffer::formatNumber(size_t index) const
+    {
+    FieldView &field = mFields[index];
+    char *text = mBuffer.data() + field.mOffset;
+    size_t len;
+    // The shortest text that reads back as the same double is used, which
+    // matches the text that the server returns for a text query.
+    if(field.mType == FT_Int)
+        {
+        len = static_cast<size_t>(std::to_chars(text, text + MaxNumberTextSize,
+            field.mInt).ptr - text);
+        }
+    else
+        {
+        len = static_cast<size_t>(std::to_chars(text, text + MaxNumberTextSize,
+            field.mDouble).ptr - text);
+        }
+    text[len] = '\0';
+    field.mLength = len;
+    field.mTextReady = true;
+    }
+
+template<typename T> static T parseField(std::string_view field)
+    {
+    T val = 0;
+    std::from_chars(field.data(), field.data() + field.length(), val);
+    return val;
+    }
+
+int DbRowBuffer::getFieldInt(size_t index) const
+    {
+    return static_cast<int>(getFieldInt64(index));
+    }
+
+int64_t DbRowBuffer::getFieldInt64(size_t index) const
+    {
+    FieldView const &field = mFields[index];
+    int64_t val;
+    if(field.mType == FT_Int)
+        {
+        val = field.mInt;
+        }
+    else if(field.mType == FT_Double)
+        {
+        val = static_cast<int64_t>(field.mDouble);
+        }
+    else
+        {
+        val = parseField<int64_t>(getField(index));
+        }
+    return val;
+    }
+
+double DbRowBuffer::getFieldDouble(size_t index) const
+    {
+    FieldView const &field = mFields[index];
+    double val;
+    if(field.mType == FT_Double)
+        {
+        val = field.mDouble;
+        }
+    else if(field.mType == FT_Int)
+        {
+        val = static_cast<double>(field.mInt);
+        }
+    else
+        {
+        val = parseField<double>(getField(index));
+        }
+    return val;
+    }
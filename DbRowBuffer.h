@@ -0,0 +1,100 @@
+/*
+* DbRowBuffer.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Stores the fields of a result row as text in a single buffer. The buffer
+// and the field table are reused for every row, so once they are large
+// enough, reading rows does not allocate memory. Numbers are only parsed
+// when a field is read. Numbers that are fetched with a native type are
+// stored without text, and are only formatted if the text is read.
+
+#ifndef DB_ROW_BUFFER_H
+#define DB_ROW_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+class DbRowBuffer
+    {
+    public:
+        DbRowBuffer():
+            mNumFields(0), mUsed(0)
+            {}
+
+        /// Removes all fields. The memory is kept for the next row.
+        void clear()
+            { mNumFields = 0; mUsed = 0; }
+        /// Starts a row. The fields must then be added in order.
+        void startRow(size_t numFields);
+        /// Copies the field. The data is nullptr for a NULL field.
+        void setField(size_t index, char const *data, size_t len);
+        /// Returns space for the field to be written into. The pointer is only
+        /// valid until the next field is set.
+        char *setFieldSpace(size_t index, size_t len);
+        /// Shortens the field after less than the space was written.
+        void setFieldLength(size_t index, size_t len);
+        /// Stores a native number.
+        void setFieldInt64(size_t index, int64_t val);
+        void setFieldDouble(size_t index, double val);
+
+        size_t getNumFields() const
+            { return mNumFields; }
+        bool isNull(size_t index) const
+            { return mFields[index].mIsNull; }
+        /// A NULL field is returned as an empty string.
+        std::string_view getField(size_t index) const
+            {
+            FieldView const &field = getTextField(index);
+            return std::string_view(mBuffer.data() + field.mOffset, field.mLength);
+            }
+        /// Returns null terminated text. A NULL field is returned as an empty
+        /// string.
+        char const *getFieldText(size_t index) const
+            { return mBuffer.data() + getTextField(index).mOffset; }
+
+        /// These return zero if the field is not a number.
+        int getFieldInt(size_t index) const;
+        int64_t getFieldInt64(size_t index) const;
+        double getFieldDouble(size_t index) const;
+
+    private:
+        enum FieldTypes { FT_Text, FT_Int, FT_Double };
+        struct FieldView
+            {
+            size_t mOffset;
+            size_t mLength;
+            bool mIsNull;
+            // For numbers, space is reserved in the buffer, and the text is
+            // only written when it is read.
+            FieldTypes mType;
+            bool mTextReady;
+            union
+                {
+                int64_t mInt;
+                double mDouble;
+                };
+            };
+        // Each field is followed by a null character. These are mutable
+        // since numbers are formatted when the text is read.
+        mutable std::vector<char> mBuffer;
+        mutable std::vector<FieldView> mFields;
+        size_t mNumFields;
+        size_t mUsed;
+
+        FieldView const &getTextField(size_t index) const
+            {
+            FieldView const &field = mFields[index];
+            if(!field.mTextReady)
+                {
+                formatNumber(index);
+                }
+            return field;
+            }
+        void formatNumber(size_t index) const;
+    };
+
+#endif
@@ -0,0 +1,271 @@
+/*
+* DbSqlScanner.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbSqlScanner.h"
+#include <string.h>     // For memchr
+
+// DB_SQL_SCAN_SSE2
+//      0 = Test one character at a time for special characters.
+//      1 = Test 16 characters at a time for special characters. This is
+//          only available on processors with SSE2, which includes all x64.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DB_SQL_SCAN_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define DB_SQL_SCAN_SSE2 0
+#endif
+
+// These are the characters that can start quoted text, comments or parameters.
+static char const sSpecialChars[] = "'\"`-/?:@$%";
+
+class DbSqlSpecialCharTable
+    {
+    public:
+        DbSqlSpecialCharTable():
+            mIsSpecial{}
+            {
+            for(char const *c = sSpecialChars; *c != '\0'; c++)
+                {
+                mIsSpecial[static_cast<unsigned char>(*c)] = true;
+                }
+            }
+        bool isSpecial(char c) const
+            { return mIsSpecial[static_cast<unsigned char>(c)]; }
+
+    private:
+        bool mIsSpecial[256];
+    };
+
+static DbSqlSpecialCharTable const sSpecialCharTable;
+
+static inline bool isIdentifierStart(char c)
+    {
+    return((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_');
+    }
+
+static inline bool isIdentifierChar(char c)
+    {
+    return(isIdentifierStart(c) || (c >= '0' && c <= '9'));
+    }
+
+#if(DB_SQL_SCAN_SSE2)
+static inline int getLowestBitIndex(unsigned int mask)
+    {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+    }
+#endif
+
+// Returns the position of the next special character, or len if there are
+// no more special characters.
+static size_t skipOrdinaryChars(char const *sql, size_t pos, size_t len)
+    {
+#if(DB_SQL_SCAN_SSE2)
+    const size_t numSpecialChars = sizeof(sSpecialChars) - 1;
+    __m128i specials[numSpecialChars];
+    for(size_t i=0; i<numSpecialChars; i++)
+        {
+        specials[i] = _mm_set1_epi8(sSpecialChars[i]);
+        }
+    while(pos + 16 <= len)
+        {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(sql + pos));
+        __m128i matches = _mm_cmpeq_epi8(chunk, specials[0]);
+        for(size_t i=1; i<numSpecialChars; i++)
+            {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, specials[i]));
+            }
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(matches));
+        if(mask != 0)
+            {
+            return pos + getLowestBitIndex(mask);
+            }
+        pos += 16;
+        }
+#endif
+    while(pos < len && !sSpecialCharTable.isSpecial(sql[pos]))
+        {
+        pos++;
+        }
+    return pos;
+    }
+
+// Returns the position after the ending quote.
+static size_t skipQuotedText(char const *sql, size_t pos, size_t len,
+    bool backslashEscapes)
+    {
+    char quote = sql[pos];
+    pos++;
+    if(backslashEscapes)
+        {
+        while(pos < len && sql[pos] != quote)
+            {
+            if(sql[pos] == '\\')
+                {
+                pos++;
+                }
+            pos++;
+            }
+        }
+    else
+        {
+        void const *end = memchr(sql + pos, quote, len - pos);
+        pos = end ? static_cast<size_t>(static_cast<char const *>(end) - sql) : len;
+        }
+    return (pos < len) ? pos + 1 : len;
+    }
+
+// Returns the position after the end of the comment, or the position after the
+// character if this is not a comment.
+static size_t skipComment(char const *sql, size_t pos, size_t len)
+    {
+    char c = sql[pos];
+    if(pos+1 < len && c == '-' && sql[pos+1] == '-')
+        {
+        void const *end = memchr(sql + pos, '\n', len - pos);
+        pos = end ? static_cast<size_t>(static_cast<char const *>(end) - sql) : len;
+        }
+    else if(pos+1 < len && c == '/' && sql[pos+1] == '*')
+        {
+        pos += 2;
+        while(pos < len)
+            {
+            void const *star = memchr(sql + pos, '*', len - pos);
+            if(!star)
+                {
+                pos = len;
+                }
+            else
+                {
+                pos = static_cast<size_t>(static_cast<char const *>(star) - sql) + 1;
+                if(pos < len && sql[pos] == '/')
+                    {
+                    pos++;
+                    break;
+                    }
+                }
+            }
+        }
+    else
+        {
+        pos++;
+        }
+    return pos;
+    }
+
+// Returns the length of the parameter at pos, or zero if this is not a parameter.
+static size_t getParameterLength(char const *sql, size_t pos, size_t len,
+    bool percentParams)
+    {
+    size_t paramLen = 0;
+    char c = sql[pos];
+    char next = (pos+1 < len) ? sql[pos+1] : '\0';
+    if(c == '?')
+        {
+        paramLen = 1;
+        while(pos + paramLen < len && sql[pos + paramLen] >= '0' &&
+            sql[pos + paramLen] <= '9')
+            {
+            paramLen++;
+            }
+        }
+    else if((c == ':' || c == '@' || c == '$') && isIdentifierStart(next))
+        {
+        paramLen = 2;
+        while(pos + paramLen < len && isIdentifierChar(sql[pos + paramLen]))
+            {
+            paramLen++;
+            }
+        }
+    else if(c == '%' && next == 's' && percentParams)
+        {
+        paramLen = 2;
+        }
+    return paramLen;
+    }
+
+void DbSqlScanner::scan(char const *sql, size_t len, int flags)
+    {
+    bool keepParameters = (flags & DSF_Parameters) != 0;
+    bool rewrite = (flags & DSF_Rewrite) != 0;
+    bool percentParams = (flags & DSF_PercentParams) != 0;
+    bool backslashEscapes = (flags & DSF_BackslashEscapes) != 0;
+
+    mNumParameters = 0;
+    mParameters.clear();
+    mText.clear();
+    mRewrittenText.clear();
+    if(keepParameters)
+        {
+        mText.assign(sql, len);
+        }
+    if(rewrite)
+        {
+        mRewrittenText.reserve(len);
+        }
+    size_t copyPos = 0;
+    size_t pos = 0;
+    while(pos < len)
+        {
+        pos = skipOrdinaryChars(sql, pos, len);
+        if(pos < len)
+            {
+            char c = sql[pos];
+            if(c == '\'' || c == '\"' || c == '`')
+                {
+                pos = skipQuotedText(sql, pos, len, backslashEscapes);
+                }
+            else if(c == '-' || c == '/')
+                {
+                pos = skipComment(sql, pos, len);
+                }
+            else
+                {
+                size_t paramLen = getParameterLength(sql, pos, len, percentParams);
+                if(paramLen > 0)
+                    {
+                    DbSqlParameter param = { pos, paramLen, 0 };
+                    if(rewrite)
+                        {
+                        mRewrittenText.append(sql + copyPos, pos - copyPos);
+                        param.mRewrittenPos = mRewrittenText.length();
+                        mRewrittenText.append(1, '?');
+                        copyPos = pos + paramLen;
+                        }
+                    if(keepParameters)
+                        {
+                        mParameters.push_back(param);
+                        }
+                    mNumParameters++;
+                    pos += paramLen;
+                    }
+                else
+                    {
+                    pos++;
+                    }
+                }
+            }
+        }
+    if(rewrite)
+        {
+        mRewrittenText.append(sql + copyPos, len - copyPos);
+        }
+    }
+
+size_t DbSqlScanner::countParameters(char const *sql, size_t len)
+    {
+    DbSqlScanner scanner;
+    scanner.scan(sql, len, DSF_CountOnly);
+    return scanner.getNumParameters();
+    }
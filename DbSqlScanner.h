@@ -0,0 +1,137 @@
+/*
+* DbSqlScanner.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Scans SQL text a single time to find bind parameters. Quoted text and
+// comments are skipped, so colons or question marks in string literals are
+// not counted. The same scan can also build text where every bind parameter
+// is replaced with a question mark, which is needed for MySQL.
+//
+// Bind parameters are:
+//      ?   ?1      - Ordinal parameters.
+//      :name  @name  $name - Named parameters.
+//      %s          - Only if DSF_PercentParams is used.
+
+#ifndef DB_SQL_SCANNER_H
+#define DB_SQL_SCANNER_H
+
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum DbSqlScanFlags
+    {
+    DSF_CountOnly = 0,
+    DSF_Parameters = 0x1,           // Keep a table of the parameters.
+    DSF_Rewrite = 0x2,              // Build text with all parameters as "?".
+    DSF_PercentParams = 0x4,        // Treat "%s" as a parameter.
+    DSF_BackslashEscapes = 0x8      // Quoted text can contain \' (MySQL).
+    };
+
+/// A bind parameter that was found in the SQL text.
+struct DbSqlParameter
+    {
+    size_t mPos;            // Position in the scanned text.
+    size_t mLength;         // Length in the scanned text, such as 5 for ":name".
+    size_t mRewrittenPos;   // Position of the "?" in the rewritten text.
+    };
+
+/// Scans SQL text in a single pass. The time is linear with the length of
+/// the text, so this can be used for large generated statements.
+class DbSqlScanner
+    {
+    public:
+        DbSqlScanner():
+            mNumParameters(0)
+            {}
+
+        /// Scans the text. The results of any previous scan are replaced.
+        /// @param flags A combination of DbSqlScanFlags.
+        void scan(char const *sql, size_t len, int flags);
+        void scan(std::string const &sql, int flags)
+            { scan(sql.data(), sql.length(), flags); }
+
+        /// Returns the number of parameters without keeping a table.
+        static size_t countParameters(char const *sql, size_t len);
+
+        size_t getNumParameters() const
+            { return mNumParameters; }
+        /// The parameter table is only available with DSF_Parameters.
+        DbSqlParameter const &getParameter(size_t index) const
+            { return mParameters[index]; }
+        /// Returns the text of the parameter such as ":name" or "?".
+        /// This is only available with DSF_Parameters.
+        std::string_view getParameterName(size_t index) const
+            {
+            return std::string_view(mText.data() + mParameters[index].mPos,
+                mParameters[index].mLength);
+            }
+        /// This is only available with DSF_Rewrite.
+        std::string const &getRewrittenText() const
+            { return mRewrittenText; }
+
+    private:
+        size_t mNumParameters;
+        std::vector<DbSqlParameter> mParameters;
+        std::string mText;
+        std::string mRewrittenText;
+    };
+
+/// This uses the same rules as DbSqlScanner without any flags, but can be
+/// used at compile time.
+constexpr size_t countDbSqlParameters(char const *sql, size_t len)
+    {
+    size_t count = 0;
+    size_t i = 0;
+    while(i < len)
+        {
+        char c = sql[i];
+        char next = (i+1 < len) ? sql[i+1] : '\0';
+        if(c == '\'' || c == '\"' || c == '`')
+            {
+            i++;
+            while(i < len && sql[i] != c)
+                { i++; }
+            i++;
+            }
+        else if(c == '-' && next == '-')
+            {
+            while(i < len && sql[i] != '\n')
+                { i++; }
+            }
+        else if(c == '/' && next == '*')
+            {
+            i += 2;
+            while(i+1 < len && !(sql[i] == '*' && sql[i+1] == '/'))
+                { i++; }
+            i += 2;
+            }
+        else if(c == '?')
+            {
+            count++;
+            i++;
+            while(i < len && sql[i] >= '0' && sql[i] <= '9')
+                { i++; }
+            }
+        else if((c == ':' || c == '@' || c == '$') &&
+            ((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z') || next == '_'))
+            {
+            count++;
+            i++;
+            while(i < len && ((sql[i] >= 'a' && sql[i] <= 'z') ||
+                (sql[i] >= 'A' && sql[i] <= 'Z') ||
+                (sql[i] >= '0' && sql[i] <= '9') || sql[i] == '_'))
+                { i++; }
+            }
+        else
+            {
+            i++;
+            }
+        }
+    return count;
+    }
+
+#endif
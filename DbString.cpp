@@ -5,6 +5,7 @@
 *  \copyright 2016 DCBlaha.  Distributed under the Mozilla Public License 2.0.
 */
 #include "DbString.h"
+#include "DbSqlScanner.h"
 #include <ctype.h>
 
 /*
@@ -55,7 +56,8 @@ static size_t findNextArg(StringRef args, size_t &argIter, size_t &startArgPos)
 
 // Appends argument to a string.
 // Updates startArgPos to point to next starting argument.
-static void appendArg(String &targetString, StringRef args, size_t &argPos, bool insertDelimiter)
+// Returns true if an argument was appended.
+static bool appendArg(String &targetString, StringRef args, size_t &argPos, bool insertDelimiter)
     {
     size_t initialArgPos = argPos;
     size_t startArgPos;
@@ -68,6 +70,7 @@ static void appendArg(String &targetString, StringRef args, size_t &argPos, bool
             }
         targetString.append(&args[startArgPos], len);
         }
+    return(len > 0);
     }
 
 DbResult DbString::getColumnIndex(std::string const &queryStr,
@@ -103,9 +106,9 @@ DbResult DbString::getOptionalColumnIndex(std::string const &queryStr,
     return result;
     }
 
-static inline void appendColumnName(String &targetString, StringRef columns, size_t &startColumnPos)
+static inline bool appendColumnName(String &targetString, StringRef columns, size_t &startColumnPos)
     {
-    appendArg(targetString, columns, startColumnPos, true);
+    return appendArg(targetString, columns, startColumnPos, true);
     }
 
 static void appendColumnNames(String &targetString, StringRef colNames)
@@ -139,8 +142,7 @@ static void appendColumnNamesAndValues(String &targetString, StringRef columnNam
     size_t startValPos = 0;
     while(startColPos != String::npos && startValPos != String::npos)
         {
-        appendColumnName(targetString, columnNames, startColPos);
-        if(startColPos != String::npos)
+        if(appendColumnName(targetString, columnNames, startColPos))
             {
             targetString.append("=");
             appendValue(targetString, values, startValPos, false);
@@ -158,9 +160,35 @@ DbValues::DbValues(DbValueParamCounts numBindParams)
         }
     }
 
+// Appends "column1=prefix column1 suffix,column2=prefix column2 suffix"
+static void appendColumnAssignments(String &targetString, StringRef columnNames,
+    char const *prefix, char const *suffix)
+    {
+    size_t argPos = 0;
+    while(argPos != String::npos)
+        {
+        size_t startArgPos;
+        size_t initialArgPos = argPos;
+        size_t len = findNextArg(columnNames, argPos, startArgPos);
+        if(len > 0)
+            {
+            if(initialArgPos != 0)
+                {
+                targetString.append(",");
+                }
+            targetString.append(&columnNames[startArgPos], len);
+            targetString.append("=");
+            targetString.append(prefix);
+            targetString.append(&columnNames[startArgPos], len);
+            targetString.append(suffix);
+            }
+        }
+    }
+
 void DbString::startStatement(StringRef statement, StringRef arg)
     {
     clear();
+    mConflictColumns.clear();
     append(statement);
     append(arg);
     }
@@ -226,6 +254,108 @@ DbString &DbString::AND(StringRef columnName, StringRef operStr, DbValues const
     return *this;
     }
 
+void DbString::appendInArray(char const *clause, StringRef columnName,
+    DbArrayTypes type, DbValues const &value)
+    {
+    append(clause);
+    append(columnName);
+#if(DATABASE == DB_SQLITE)
+    // json_each returns each value with its own type.
+    (void)type;
+    append(" IN (SELECT value FROM json_each(");
+    append(value);
+    append("))");
+#else
+    append(" IN (SELECT value FROM JSON_TABLE(");
+    append(value);
+    append(", '$[*]' COLUMNS(value ");
+    append(type == DAT_Integer ? "BIGINT" : "LONGTEXT");
+    append(" PATH '$')) AS DbArray)");
+#endif
+    }
+
+DbString &DbString::WHERE_IN_ARRAY(StringRef columnName, DbArrayTypes type,
+    DbValues const &value)
+    {
+    appendInArray(" WHERE ", columnName, type, value);
+    return *this;
+    }
+
+DbString &DbString::AND_IN_ARRAY(StringRef columnName, DbArrayTypes type,
+    DbValues const &value)
+    {
+    appendInArray(" AND ", columnName, type, value);
+    return *this;
+    }
+
+DbString &DbString::ON_CONFLICT(StringRef columnNames)
+    {
+    mConflictColumns = columnNames;
+#if(DATABASE == DB_SQLITE)
+    append(" ON CONFLICT(");
+    append(columnNames);
+    append(")");
+#endif
+    return *this;
+    }
+
+DbString &DbString::DO_UPDATE_SET(StringRef columnNames, DbValues const &values)
+    {
+#if(DATABASE == DB_SQLITE)
+    append(" DO UPDATE SET ");
+#else
+    append(" ON DUPLICATE KEY UPDATE ");
+#endif
+    appendColumnNamesAndValues(*this, columnNames, values);
+    return *this;
+    }
+
+DbString &DbString::DO_UPDATE_SET_EXCLUDED(StringRef columnNames)
+    {
+#if(DATABASE == DB_SQLITE)
+    append(" DO UPDATE SET ");
+    appendColumnAssignments(*this, columnNames, "excluded.", "");
+#else
+    append(" ON DUPLICATE KEY UPDATE ");
+    appendColumnAssignments(*this, columnNames, "VALUES(", ")");
+#endif
+    return *this;
+    }
+
+DbString &DbString::DO_NOTHING()
+    {
+#if(DATABASE == DB_SQLITE)
+    if(mConflictColumns.empty())
+        {
+        // The conflict target can be left out of the last ON CONFLICT.
+        append(" ON CONFLICT");
+        }
+    append(" DO NOTHING");
+#else
+    if(mConflictColumns.empty())
+        {
+        // There is no column to set to itself, so ignore any duplicate key.
+        static char const insertStr[] = "INSERT INTO ";
+        if(compare(0, sizeof(insertStr) - 1, insertStr) == 0)
+            {
+            insert(sizeof("INSERT ") - 1, "IGNORE ");
+            }
+        }
+    else
+        {
+        size_t argPos = 0;
+        size_t startArgPos;
+        size_t len = findNextArg(mConflictColumns, argPos, startArgPos);
+        String firstColumn = mConflictColumns.substr(startArgPos, len);
+        append(" ON DUPLICATE KEY UPDATE ");
+        append(firstColumn);
+        append("=");
+        append(firstColumn);
+        }
+#endif
+    return *this;
+    }
+
 DbString &DbString::COLUMNS(StringRef columnNames)
     {
     append("(");
@@ -250,6 +380,11 @@ DbString &DbString::COLUMN_DEFS(DbColumnDefinitions const &defs)
     return *this;
     }
 
+size_t DbString::getNumBindParameters() const
+    {
+    return DbSqlScanner::countParameters(data(), length());
+    }
+
 String DbString::getDbStr()
     {
     size_t len = length();
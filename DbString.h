@@ -16,6 +16,7 @@
 #include <vector>
 #include <algorithm>
 #include "DbResult.h"
+#include "DbArray.h"
 
 typedef std::string const &StringRef;
 typedef std::string String;
@@ -84,8 +85,13 @@ class DbJoinString:public String
 //    dbStr.INSERT_INTO("Cat").COLUMNS("catId, catName").VALUES(TWO_PARAMS);
 //    dbStr.INSERT_INTO("Cat").COLUMNS("catId, catName").VALUES(":id, :name");
 //
+//    dbStr.SELECT("catName").FROM("Cat").WHERE_IN_ARRAY("catId");
+//
 //    dbStr.UPDATE("Cat").SET("catId, catName", TWO_PARAMS);
 //    dbStr.DELETE_FROM("Cat");
+//
+//    dbStr.INSERT_INTO("Cat").COLUMNS("catName, age").VALUES(TWO_PARAMS).
+//        ON_CONFLICT("catName").DO_UPDATE_SET_EXCLUDED("age");
 class DbString:private String
     {
     public:
@@ -119,7 +125,7 @@ class DbString:private String
             }
 
         /// This is not an UPSERT for sqlite, but will replace all values
-        /// including the primary id.
+        /// including the primary id. Use INSERT_INTO with ON_CONFLICT for an UPSERT.
         /// http://stackoverflow.com/questions/3634984/insert-if-not-exists-else-update
         /// Appends "INSERT OR REPLACE INTO table"
         /// This might work with CREATE TABLE UNIQUE ON CONFLICT IGNORE, but if this is not
@@ -215,12 +221,42 @@ class DbString:private String
         /// The number of columns and values must match.
         DbString &SET(StringRef columnNames, DbValues const &values);
 
+        /// Appends " ON CONFLICT(columnNames)" for SQLite. Use this after VALUES,
+        /// then use DO_UPDATE_SET or DO_NOTHING. This is an UPSERT that updates
+        /// the existing row in place, so the primary id does not change and
+        /// the row is not deleted and inserted again.
+        /// For MySQL, nothing is appended since ON DUPLICATE KEY UPDATE uses
+        /// any unique key, but the columns are used by DO_NOTHING.
+        DbString &ON_CONFLICT(StringRef columnNames);
+        /// Appends " DO UPDATE SET column1=value1,column2=value2" for SQLite or
+        /// " ON DUPLICATE KEY UPDATE column1=value1,column2=value2" for MySQL.
+        DbString &DO_UPDATE_SET(StringRef columnNames, DbValues const &values);
+        /// Sets the columns to the values that were going to be inserted.
+        /// Appends " DO UPDATE SET column1=excluded.column1" for SQLite or
+        /// " ON DUPLICATE KEY UPDATE column1=VALUES(column1)" for MySQL.
+        DbString &DO_UPDATE_SET_EXCLUDED(StringRef columnNames);
+        /// Appends " DO NOTHING" for SQLite. For MySQL, this sets the first
+        /// conflict column to itself, which does not change the row.
+        /// Without ON_CONFLICT, this appends " ON CONFLICT DO NOTHING" for
+        /// SQLite, and changes INSERT INTO to INSERT IGNORE INTO for MySQL.
+        DbString &DO_NOTHING();
+
         /// Appends " WHERE columnName operStr colVal"
         DbString &WHERE(StringRef columnName, StringRef operStr,
             DbValues const &values);
         /// Appends " AND columnName operStr colVal"
         DbString &AND(StringRef columnName, StringRef operStr,
             DbValues const &values);
+        /// Appends " WHERE columnName IN (SELECT value FROM json_each(?))" for
+        /// SQLite, or the same using JSON_TABLE for MySQL. Bind all of the
+        /// values to the single parameter using DbStatement::bindArray().
+        /// This allows one prepared statement for any number of values.
+        /// The type must match the values that are bound.
+        DbString &WHERE_IN_ARRAY(StringRef columnName,
+            DbArrayTypes type=DAT_Integer, DbValues const &value=ONE_PARAM);
+        /// Appends " AND columnName IN (...)". See WHERE_IN_ARRAY.
+        DbString &AND_IN_ARRAY(StringRef columnName,
+            DbArrayTypes type=DAT_Integer, DbValues const &value=ONE_PARAM);
 
         /// Special to allow adding a bunch of joins.
         DbString &addJoins(std::string const &joinStr)
@@ -232,6 +268,8 @@ class DbString:private String
         /// Find the index of the field from the select query statement.
         /// Go through the query string and find the field from the select part of the query,
         /// then count back for the number of commas to get the index of the field.
+        /// DbStatement::getColumn() is faster and uses the names from the
+        /// prepared statement, so it works with functions and substrings.
         static DbResult getColumnIndex(std::string const &queryStr,
             const char *fieldName, int &index);
         static DbResult getOptionalColumnIndex(std::string const &queryStr,
@@ -240,20 +278,22 @@ class DbString:private String
         // This module expects that bind parameters start with a colon and have a
         // name, or use a question mark.
         // It is up to the DB interface to alter if its interface is different.
-        size_t getNumBindParameters() const
-            {
-            return std::count(begin(), end(), ':') +
-                std::count(begin(), end(), '?') + std::count(begin(), end(), '@');
-            }
+        // Quoted text and comments are skipped. See DbSqlScanner.
+        size_t getNumBindParameters() const;
 
         void clear()
-            { String::clear(); }
+            { String::clear(); mConflictColumns.clear(); }
 
 
     private:
+        // This is only needed for the MySQL DO_NOTHING.
+        String mConflictColumns;
+
         // Prevent usage. Use getDbStr instead. This is undefined.
         char const *c_str();
         void startStatement(StringRef statement, StringRef arg);
+        void appendInArray(char const *clause, StringRef columnName,
+            DbArrayTypes type, DbValues const &value);
     };
 
 #endif
@@ -0,0 +1,523 @@
+/*
+* DbTable.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Maps the members of a struct to the columns of a table. DB_TABLE lists the
+// members, and the SQL to create, insert, upsert and select rows is built by
+// the compiler from the member names and types. The table name is the name
+// of the struct, and the first member is the primary key.
+//
+// Rows are bound and read with the member pointers, which are known at
+// compile time, so each row only costs the bind and get calls of the
+// statement. DbTable keeps the prepared statements, so they are only
+// prepared once.
+//
+// Example:
+//    struct Person
+//        {
+//        int64_t id;
+//        std::string name;
+//        double height;
+//        };
+//    DB_TABLE(Person, id, name, height);
+//
+//    DbTable<Person> people(db);
+//    DbResult result = people.createTable();
+//    result = people.insert(Person{1, "Fred", 1.8});
+//    Person person;
+//    result = people.loadByKey(1, person);
+//
+// The member types can be int, int64_t, bool, float, double, std::string or
+// std::vector<byte>. Other types will not compile. With MySQL, a key that is
+// a string or blob is limited to 255 characters or bytes. DB_TABLE must be
+// used outside of any namespace, and can list up to 16 members.
+
+#ifndef DB_TABLE_H
+#define DB_TABLE_H
+
+#include "DbAccess.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// DB_TABLE defines this for each struct that is mapped.
+template<typename Struct> struct DbTableDef;
+
+// Selects the column type for the backend.
+#if(DATABASE == DB_SQLITE)
+#define DB_TABLE_SQL_TYPE(sqliteType, mysqlType) sqliteType
+#else
+#define DB_TABLE_SQL_TYPE(sqliteType, mysqlType) mysqlType
+#endif
+
+/// Binds and gets the values of one member type. The values are bound with
+/// ordinals that are base one, and read with column indices that are base
+/// zero. KeySqlType is used when the member is the primary key, since MySQL
+/// cannot use TEXT or BLOB columns as keys.
+template<typename Field> struct DbFieldTraits;
+
+template<> struct DbFieldTraits<int>
+    {
+    static constexpr char const SqlType[] = "INTEGER";
+    static constexpr char const KeySqlType[] = "INTEGER";
+    static void bind(DbStatement &stmt, int ordinal, int val)
+        { stmt.bindInt(ordinal, val); }
+    static void get(DbStatement &stmt, int columnIndex, int &val)
+        { val = stmt.getColumnInt(columnIndex); }
+    };
+
+template<> struct DbFieldTraits<int64_t>
+    {
+    static constexpr char const SqlType[] = DB_TABLE_SQL_TYPE("INTEGER", "BIGINT");
+    static constexpr char const KeySqlType[] = DB_TABLE_SQL_TYPE("INTEGER", "BIGINT");
+    static void bind(DbStatement &stmt, int ordinal, int64_t val)
+        { stmt.bindInt64(ordinal, val); }
+    static void get(DbStatement &stmt, int columnIndex, int64_t &val)
+        { val = stmt.getColumnInt64(columnIndex); }
+    };
+
+template<> struct DbFieldTraits<bool>
+    {
+    static constexpr char const SqlType[] = DB_TABLE_SQL_TYPE("INTEGER", "BOOLEAN");
+    static constexpr char const KeySqlType[] = DB_TABLE_SQL_TYPE("INTEGER", "BOOLEAN");
+    static void bind(DbStatement &stmt, int ordinal, bool val)
+        { stmt.bindInt(ordinal, val ? 1 : 0); }
+    static void get(DbStatement &stmt, int columnIndex, bool &val)
+        { val = stmt.getColumnBool(columnIndex); }
+    };
+
+template<> struct DbFieldTraits<float>
+    {
+    static constexpr char const SqlType[] = DB_TABLE_SQL_TYPE("REAL", "FLOAT");
+    static constexpr char const KeySqlType[] = DB_TABLE_SQL_TYPE("REAL", "FLOAT");
+    static void bind(DbStatement &stmt, int ordinal, float val)
+        { stmt.bindFloat(ordinal, val); }
+    static void get(DbStatement &stmt, int columnIndex, float &val)
+        { val = static_cast<float>(stmt.getColumnDouble(columnIndex)); }
+    };
+
+template<> struct DbFieldTraits<double>
+    {
+    static constexpr char const SqlType[] = DB_TABLE_SQL_TYPE("REAL", "DOUBLE");
+    static constexpr char const KeySqlType[] = DB_TABLE_SQL_TYPE("REAL", "DOUBLE");
+    static void bind(DbStatement &stmt, int ordinal, double val)
+        { stmt.bindDouble(ordinal, val); }
+    static void get(DbStatement &stmt, int columnIndex, double &val)
+        { val = stmt.getColumnDouble(columnIndex); }
+    };
+
+// For SQLite, the text is not copied, since DbTable binds every parameter
+// again before each execute.
+template<> struct DbFieldTraits<std::string>
+    {
+    static constexpr char const SqlType[] = DB_TABLE_SQL_TYPE("TEXT", "LONGTEXT");
+    static constexpr char const KeySqlType[] = DB_TABLE_SQL_TYPE("TEXT", "VARCHAR(255)");
+    static void bind(DbStatement &stmt, int ordinal, std::string const &val)
+        {
+#if(DATABASE == DB_SQLITE)
+        stmt.bindTextView(ordinal, val, SBM_Static);
+#else
+        stmt.bindText(ordinal, val.c_str());
+#endif
+        }
+    static void get(DbStatement &stmt, int columnIndex, std::string &val)
+        {
+        char const *text = stmt.getColumnText(columnIndex);
+        if(text)
+            {
+            val = text;
+            }
+        else
+            {
+            val.clear();
+            }
+        }
+    };
+
+template<> struct DbFieldTraits<std::vector<byte>>
+    {
+    static constexpr char const SqlType[] = DB_TABLE_SQL_TYPE("BLOB", "LONGBLOB");
+    static constexpr char const KeySqlType[] = DB_TABLE_SQL_TYPE("BLOB", "VARBINARY(255)");
+    static void bind(DbStatement &stmt, int ordinal, std::vector<byte> const &val)
+        {
+#if(DATABASE == DB_SQLITE)
+        stmt.bindBlobView(ordinal, val.data(), val.size(), SBM_Static);
+#else
+        stmt.bindBlob(ordinal, val.data(), static_cast<int>(val.size()));
+#endif
+        }
+    static void get(DbStatement &stmt, int columnIndex, std::vector<byte> &val)
+        { stmt.getColumnBlob(columnIndex, val); }
+    };
+
+/// The type of a member from a member pointer type.
+template<typename MemberPtr> struct DbMemberType;
+template<typename Struct, typename Field> struct DbMemberType<Field Struct::*>
+    {
+    typedef Field type;
+    };
+
+/// Counts the characters of a statement, so that the capacity of the
+/// DbTableSqlText can be found at compile time.
+class DbTableSqlLength
+    {
+    public:
+        constexpr DbTableSqlLength():
+            mLength(0)
+            {}
+        constexpr void append(char const *str)
+            {
+            while(*str++)
+                {
+                mLength++;
+                }
+            }
+        constexpr size_t length() const
+            { return mLength; }
+
+    private:
+        size_t mLength;
+    };
+
+/// The text of a statement that is built at compile time. The statements
+/// end with a semicolon in the same way as DbString and DbConstString.
+template<size_t Capacity> class DbTableSqlText
+    {
+    public:
+        constexpr DbTableSqlText():
+            mStr{}, mLength(0)
+            {}
+        constexpr void append(char const *str)
+            {
+            while(*str)
+                {
+                mStr[mLength++] = *str++;
+                }
+            mStr[mLength] = '\0';
+            }
+        constexpr char const *getDbStr() const
+            { return mStr; }
+        constexpr size_t length() const
+            { return mLength; }
+
+    private:
+        char mStr[Capacity+1];
+        size_t mLength;
+    };
+
+/// The SQL of the statements for a struct. These are all built at compile
+/// time.
+template<typename Struct> class DbTableSql
+    {
+    public:
+        typedef DbTableDef<Struct> Def;
+        typedef typename std::remove_const<decltype(Def::Members)>::type Members;
+        static constexpr size_t NumColumns = std::tuple_size<Members>::value;
+        template<size_t Index> using FieldType = typename DbMemberType<
+            typename std::tuple_element<Index, Members>::type>::type;
+        typedef FieldType<0> KeyType;
+
+    // The functions that build the statements must be defined before the
+    // statements.
+    private:
+        template<size_t ...Indices> static constexpr std::array<char const *, NumColumns>
+            getSqlTypes(std::index_sequence<Indices...>)
+            { return {{ DbFieldTraits<FieldType<Indices>>::SqlType... }}; }
+
+        template<typename Text> static constexpr void appendColumnNames(Text &text)
+            {
+            for(size_t i=0; i<NumColumns; i++)
+                {
+                if(i != 0)
+                    { text.append(", "); }
+                text.append(Def::ColumnNames[i]);
+                }
+            }
+
+        template<typename Text> static constexpr Text buildCreate()
+            {
+            std::array<char const *, NumColumns> sqlTypes =
+                getSqlTypes(std::make_index_sequence<NumColumns>());
+            sqlTypes[0] = DbFieldTraits<KeyType>::KeySqlType;
+            Text text;
+            text.append("CREATE TABLE IF NOT EXISTS ");
+            text.append(Def::TableName);
+            text.append(" (");
+            for(size_t i=0; i<NumColumns; i++)
+                {
+                if(i != 0)
+                    { text.append(", "); }
+                text.append(Def::ColumnNames[i]);
+                text.append(" ");
+                text.append(sqlTypes[i]);
+                if(i == 0)
+                    { text.append(" PRIMARY KEY"); }
+                }
+            text.append(");");
+            return text;
+            }
+
+        // The upsert is the same as DbString ON_CONFLICT with
+        // DO_UPDATE_SET_EXCLUDED.
+        template<typename Text> static constexpr Text buildInsert(bool upsert=false)
+            {
+            Text text;
+            text.append("INSERT INTO ");
+            text.append(Def::TableName);
+            text.append(" (");
+            appendColumnNames(text);
+            text.append(") VALUES (");
+            for(size_t i=0; i<NumColumns; i++)
+                {
+                text.append((i == 0) ? "?" : ",?");
+                }
+            text.append(")");
+            if(upsert)
+                {
+#if(DATABASE == DB_SQLITE)
+                text.append(" ON CONFLICT(");
+                text.append(Def::ColumnNames[0]);
+                text.append(") DO UPDATE SET ");
+#else
+                text.append(" ON DUPLICATE KEY UPDATE ");
+#endif
+                for(size_t i=1; i<NumColumns; i++)
+                    {
+                    if(i != 1)
+                        { text.append(","); }
+                    text.append(Def::ColumnNames[i]);
+#if(DATABASE == DB_SQLITE)
+                    text.append("=excluded.");
+                    text.append(Def::ColumnNames[i]);
+#else
+                    text.append("=VALUES(");
+                    text.append(Def::ColumnNames[i]);
+                    text.append(")");
+#endif
+                    }
+                }
+            text.append(";");
+            return text;
+            }
+
+        template<typename Text> static constexpr Text buildSelect()
+            {
+            Text text;
+            text.append("SELECT ");
+            appendColumnNames(text);
+            text.append(" FROM ");
+            text.append(Def::TableName);
+            text.append(" WHERE ");
+            text.append(Def::ColumnNames[0]);
+            text.append("=?;");
+            return text;
+            }
+
+    public:
+        /// "CREATE TABLE IF NOT EXISTS Struct (key TYPE PRIMARY KEY, column TYPE...);"
+        /// The types are for the backend that is selected with DATABASE.
+        static constexpr auto Create = buildCreate<DbTableSqlText<
+            buildCreate<DbTableSqlLength>().length()>>();
+        /// "INSERT INTO Struct (columns) VALUES (?,...);"
+        static constexpr auto Insert = buildInsert<DbTableSqlText<
+            buildInsert<DbTableSqlLength>().length()>>(false);
+        /// Insert that updates the other columns if the key exists.
+        static constexpr auto Upsert = buildInsert<DbTableSqlText<
+            buildInsert<DbTableSqlLength>(true).length()>>(true);
+        /// "SELECT columns FROM Struct WHERE key=?;"
+        static constexpr auto SelectByKey = buildSelect<DbTableSqlText<
+            buildSelect<DbTableSqlLength>().length()>>();
+    };
+
+/// Binds and gets all members of a struct. The ordinals and column indices
+/// are in the order of DB_TABLE.
+template<typename Struct> class DbTableRow
+    {
+    public:
+        typedef DbTableSql<Struct> Sql;
+
+        static void bind(DbStatement &stmt, Struct const &obj)
+            { bind(stmt, obj, std::make_index_sequence<Sql::NumColumns>()); }
+        static void get(DbStatement &stmt, Struct &obj)
+            { get(stmt, obj, std::make_index_sequence<Sql::NumColumns>()); }
+
+    private:
+        template<size_t ...Indices> static void bind(DbStatement &stmt,
+            Struct const &obj, std::index_sequence<Indices...>)
+            {
+            (DbFieldTraits<typename Sql::template FieldType<Indices>>::bind(stmt,
+                static_cast<int>(Indices + 1),
+                obj.*std::get<Indices>(DbTableDef<Struct>::Members)), ...);
+            }
+        template<size_t ...Indices> static void get(DbStatement &stmt,
+            Struct &obj, std::index_sequence<Indices...>)
+            {
+            (DbFieldTraits<typename Sql::template FieldType<Indices>>::get(stmt,
+                static_cast<int>(Indices),
+                obj.*std::get<Indices>(DbTableDef<Struct>::Members)), ...);
+            }
+    };
+
+/// Accesses the rows of the table of a struct. The statements are prepared
+/// the first time that they are used, and are then kept.
+template<typename Struct> class DbTable
+    {
+    public:
+        typedef DbTableSql<Struct> Sql;
+        typedef typename Sql::KeyType KeyType;
+
+        explicit DbTable(DbAccess &db):
+            mDb(db), mInsert(db), mUpsert(db), mSelect(db), mInsertSet(false),
+            mUpsertSet(false), mSelectSet(false)
+            {}
+
+        /// Creates the table if it does not exist.
+        DbResult createTable()
+            {
+            DbStatement stmt(mDb);
+            DbResult result = stmt.set(Sql::Create.getDbStr());
+            if(result.isOk())
+                {
+                result = stmt.execute();
+                }
+            return result;
+            }
+
+        /// Inserts a row. This fails if the key exists.
+        DbResult insert(Struct const &obj)
+            { return write(mInsert, mInsertSet, Sql::Insert.getDbStr(), obj); }
+
+        /// Inserts a row, or updates the other columns if the key exists.
+        DbResult upsert(Struct const &obj)
+            { return write(mUpsert, mUpsertSet, Sql::Upsert.getDbStr(), obj); }
+
+        /// Inserts the rows in one transaction. This stops at the first error,
+        /// and then no rows are inserted. This must not be called inside
+        /// another transaction.
+        DbResult insertMany(Struct const *objs, size_t numObjs)
+            {
+            DbResult result;
+            DbTransaction transaction(mDb);
+            transaction.begin();
+            for(size_t i=0; i<numObjs && result.isOk(); i++)
+                {
+                result = insert(objs[i]);
+                }
+            if(!result.isOk())
+                {
+                transaction.rollback();
+                }
+            return result;
+            }
+        DbResult insertMany(std::vector<Struct> const &objs)
+            { return insertMany(objs.data(), objs.size()); }
+
+        /// Returns a result with DEC_NotFound if no row has the key.
+        DbResult loadByKey(KeyType const &key, Struct &obj)
+            {
+            DbResult result = prepare(mSelect, mSelectSet, Sql::SelectByKey.getDbStr());
+            if(result.isOk())
+                {
+                DbFieldTraits<KeyType>::bind(mSelect, 1, key);
+                result = mSelect.getRow();
+                if(result.isOk())
+                    {
+                    DbTableRow<Struct>::get(mSelect, obj);
+                    }
+                mSelect.reset();
+                }
+            return result;
+            }
+
+    private:
+        DbAccess &mDb;
+        DbStatement mInsert;
+        DbStatement mUpsert;
+        DbStatement mSelect;
+        bool mInsertSet;
+        bool mUpsertSet;
+        bool mSelectSet;
+
+        DbResult prepare(DbStatement &stmt, bool &isSet, char const *query)
+            {
+            DbResult result;
+            if(!isSet)
+                {
+#if(DATABASE == DB_SQLITE)
+                result = stmt.set(query, SQLITE_PREPARE_PERSISTENT);
+#else
+                result = stmt.set(query);
+#endif
+                isSet = result.isOk();
+                }
+            return result;
+            }
+
+        // Every parameter is bound again before the next execute, so the
+        // struct does not need to be kept after this returns.
+        DbResult write(DbStatement &stmt, bool &isSet, char const *query,
+            Struct const &obj)
+            {
+            DbResult result = prepare(stmt, isSet, query);
+            if(result.isOk())
+                {
+                DbTableRow<Struct>::bind(stmt, obj);
+                result = stmt.execute();
+                stmt.reset();
+                }
+            return result;
+            }
+
+        // Don't allow copies of this class.
+        DbTable(DbTable const &table);
+        DbTable &operator=(DbTable const &table);
+    };
+
+// These call a macro for each member name. The macros are expanded again
+// for compilers that pass __VA_ARGS__ as one argument.
+#define DB_TABLE_EXPAND(x) x
+#define DB_TABLE_FE_1(M, S, a) M(S, a)
+#define DB_TABLE_FE_2(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_1(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_3(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_2(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_4(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_3(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_5(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_4(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_6(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_5(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_7(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_6(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_8(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_7(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_9(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_8(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_10(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_9(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_11(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_10(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_12(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_11(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_13(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_12(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_14(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_13(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_15(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_14(M, S, __VA_ARGS__))
+#define DB_TABLE_FE_16(M, S, a, ...) M(S, a), DB_TABLE_EXPAND(DB_TABLE_FE_15(M, S, __VA_ARGS__))
+#define DB_TABLE_GET_FE(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, \
+    _14, _15, _16, NAME, ...) NAME
+#define DB_TABLE_FOR_EACH(M, S, ...) DB_TABLE_EXPAND(DB_TABLE_GET_FE(__VA_ARGS__, \
+    DB_TABLE_FE_16, DB_TABLE_FE_15, DB_TABLE_FE_14, DB_TABLE_FE_13, DB_TABLE_FE_12, \
+    DB_TABLE_FE_11, DB_TABLE_FE_10, DB_TABLE_FE_9, DB_TABLE_FE_8, DB_TABLE_FE_7, \
+    DB_TABLE_FE_6, DB_TABLE_FE_5, DB_TABLE_FE_4, DB_TABLE_FE_3, DB_TABLE_FE_2, \
+    DB_TABLE_FE_1)(M, S, __VA_ARGS__))
+#define DB_TABLE_COLUMN_NAME(Struct, member) #member
+#define DB_TABLE_MEMBER_PTR(Struct, member) &Struct::member
+
+/// Maps the struct to a table. The first member is the primary key.
+#define DB_TABLE(Struct, ...) \
+    template<> struct DbTableDef<Struct> \
+        { \
+        static constexpr char const TableName[] = #Struct; \
+        static constexpr char const *ColumnNames[] = \
+            { DB_TABLE_FOR_EACH(DB_TABLE_COLUMN_NAME, Struct, __VA_ARGS__) }; \
+        static constexpr auto Members = std::make_tuple( \
+            DB_TABLE_FOR_EACH(DB_TABLE_MEMBER_PTR, Struct, __VA_ARGS__)); \
+        }
+
+#endif
@@ -0,0 +1,233 @@
+/*
+* DbTableCache.cpp
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+#include "DbTableCache.h"
+
+#if(DB_USE_SQLITE && DB_USE_MYSQL)
+#include <algorithm>    // For std::find
+#include <vector>
+
+// The SQL is built here instead of with DbString, since DbString builds SQL
+// for the default backend, and this uses both.
+static DbResult executeLocal(DbSqlite::DbAccess &db, std::string const &query)
+    {
+    DbSqlite::DbStatement stmt(db);
+    DbResult result = stmt.set(query.c_str());
+    if(result.isOk())
+        {
+        result = stmt.execute();
+        }
+    return result;
+    }
+
+DbResult DbTableCache::addTable(DbCachedTableDef const &def)
+    {
+    DbResult result;
+    CachedTable table(def);
+    std::vector<std::string> columns;
+    size_t pos = 0;
+    while(pos != std::string::npos)
+        {
+        size_t endPos = def.mColumns.find(',', pos);
+        std::string column = def.mColumns.substr(pos, (endPos == std::string::npos) ?
+            std::string::npos : endPos - pos);
+        size_t first = column.find_first_not_of(" \t");
+        size_t last = column.find_last_not_of(" \t");
+        columns.push_back((first == std::string::npos) ? std::string() :
+            column.substr(first, last - first + 1));
+        pos = (endPos == std::string::npos) ? endPos : endPos + 1;
+        }
+    table.mNumColumns = static_cast<int>(columns.size());
+    auto iter = std::find(columns.begin(), columns.end(), def.mVersionColumn);
+    if(iter == columns.end() ||
+        std::find(columns.begin(), columns.end(), def.mKeyColumn) == columns.end())
+        {
+        result.setNativeError(DEC_Misuse, 0,
+            "The cached columns must contain the key and version columns");
+        }
+    if(result.isOk())
+        {
+        table.mVersionIndex = static_cast<int>(iter - columns.begin());
+        // The columns do not have types, so SQLite keeps the type of each
+        // value that is copied.
+        result = executeLocal(mLocalDb, "CREATE TABLE IF NOT EXISTS " +
+            def.mTableName + " (" + def.mColumns + ", PRIMARY KEY(" +
+            def.mKeyColumn + "))");
+        }
+    if(result.isOk())
+        {
+        mTables.erase(def.mTableName);
+        mTables.emplace(def.mTableName, table);
+        }
+    return result;
+    }
+
+DbResult DbTableCache::findTable(char const *tableName, CachedTable *&table)
+    {
+    DbResult result;
+    auto iter = mTables.find(tableName);
+    if(iter != mTables.end())
+        {
+        table = &iter->second;
+        }
+    else
+        {
+        table = nullptr;
+        result.setNativeError(DEC_NotFound, 0, "Table is not cached");
+        }
+    return result;
+    }
+
+// All rows are copied if the table has not been filled, otherwise only the
+// rows with a version that is not older than the newest copied version are
+// copied. Rows with the newest version are copied again, since another row
+// may have been changed with the same version after the last refresh.
+DbResult DbTableCache::copyRows(CachedTable &table)
+    {
+    DbCachedTableDef const &def = table.mDef;
+    bool reload = !table.mFilled;
+    std::string select = "SELECT " + def.mColumns + " FROM " + def.mTableName;
+    if(!reload)
+        {
+        select += " WHERE " + def.mVersionColumn + " >= ?";
+        }
+    select += " ORDER BY " + def.mVersionColumn;
+    DbMysql::DbStatement serverStmt(mServerDb);
+    // Prepared statements return native numbers, so the local values keep
+    // the same types. A cursor keeps a full load from using a lot of memory.
+    serverStmt.setPrepareMode(DPM_Prepared);
+    if(reload)
+        {
+        serverStmt.setResultMode(DRM_Cursor);
+        }
+    DbResult result = serverStmt.set(select.c_str());
+    if(result.isOk() && !reload)
+        {
+        serverStmt.bindText(1, table.mMaxVersion.c_str());
+        }
+
+    DbSqlite::DbTransaction transaction(mLocalDb);
+    if(result.isOk() && reload)
+        {
+        result = executeLocal(mLocalDb, "DELETE FROM " + def.mTableName);
+        }
+    std::string insert = "INSERT OR REPLACE INTO " + def.mTableName + " (" +
+        def.mColumns + ") VALUES(";
+    for(int i=0; i<table.mNumColumns; i++)
+        {
+        insert += (i == 0) ? "?" : ", ?";
+        }
+    insert += ")";
+    DbSqlite::DbStatement localStmt(mLocalDb);
+    if(result.isOk())
+        {
+        result = localStmt.set(insert.c_str());
+        }
+    std::string maxVersion = table.mMaxVersion;
+    bool gotRow = true;
+    while(result.isOk() && gotRow)
+        {
+        result = serverStmt.testRow(gotRow);
+        if(result.isOk() && gotRow)
+            {
+            for(int i=0; i<table.mNumColumns; i++)
+                {
+                switch(serverStmt.getColumnType(i))
+                    {
+                    case MYSQL_TYPE_NULL:
+                        localStmt.bindNull(i+1);
+                        break;
+
+                    case MYSQL_TYPE_LONGLONG:
+                        localStmt.bindInt64(i+1, serverStmt.getColumnInt64(i));
+                        break;
+
+                    case MYSQL_TYPE_DOUBLE:
+                        localStmt.bindDouble(i+1, serverStmt.getColumnDouble(i));
+                        break;
+
+                    // The server row is kept until the next testRow, and the
+                    // local insert is done and reset before then, so SQLite
+                    // does not need its own copy.
+                    default:
+                        localStmt.bindTextView(i+1, std::string_view(
+                            serverStmt.getColumnText(i),
+                            static_cast<size_t>(serverStmt.getColumnBytes(i))),
+                            SBM_Static);
+                        break;
+                    }
+                }
+            result = localStmt.execute();
+            localStmt.reset();
+            maxVersion = serverStmt.getColumnText(table.mVersionIndex);
+            }
+        }
+    // If the server fails partway, the local table keeps the rows of the
+    // last refresh instead of an empty or partial copy.
+    if(!result.isOk())
+        {
+        localStmt.reset();
+        transaction.rollback();
+        }
+    if(result.isOk())
+        {
+        table.mMaxVersion = maxVersion;
+        table.mFilled = true;
+        table.mStale = false;
+        table.mRefreshTime = Clock::now();
+        }
+    return result;
+    }
+
+DbResult DbTableCache::refresh(char const *tableName)
+    {
+    CachedTable *table;
+    DbResult result = findTable(tableName, table);
+    if(result.isOk())
+        {
+        result = copyRows(*table);
+        }
+    return result;
+    }
+
+DbResult DbTableCache::refreshIfNeeded(char const *tableName)
+    {
+    CachedTable *table;
+    DbResult result = findTable(tableName, table);
+    if(result.isOk())
+        {
+        if(!table->mFilled || table->mStale || Clock::now() - table->mRefreshTime >
+            std::chrono::seconds(table->mDef.mRefreshSeconds))
+            {
+            result = copyRows(*table);
+            }
+        }
+    return result;
+    }
+
+void DbTableCache::invalidate(char const *tableName, bool rowsDeleted)
+    {
+    auto iter = mTables.find(tableName);
+    if(iter != mTables.end())
+        {
+        iter->second.mStale = true;
+        if(rowsDeleted)
+            {
+            iter->second.mFilled = false;
+            }
+        }
+    }
+
+DbResult DbTableCache::executeWrite(char const *tableName, DbMysql::DbStatement &stmt,
+    bool rowsDeleted)
+    {
+    DbResult result = stmt.execute();
+    // The write may have changed rows even if there was an error.
+    invalidate(tableName, rowsDeleted);
+    return result;
+    }
+
+#endif
@@ -0,0 +1,105 @@
+/*
+* DbTableCache.h
+*
+*  Created: 2026
+*  \copyright 2026 DCBlaha.  Distributed under the Mozilla Public License 2.0.
+*/
+// Mirrors selected MySQL tables into a local SQLite database so that reads
+// do not need a network round trip. This is for tables that change slowly.
+// A table is copied the first time it is used, and then only rows with a
+// version that is not older than the newest copied version are copied.
+// Both backends must be compiled. See DB_USE_SQLITE and DB_USE_MYSQL in
+// DbAccess.h.
+//
+// Example:
+//    DbTableCache cache(mysqlDb, sqliteDb);
+//    cache.addTable(DbCachedTableDef("Item", "id, name, price, updatedAt",
+//        "id", "updatedAt"));
+//    DbResult result = cache.refreshIfNeeded("Item");
+//    DbSqlite::DbStatement stmt(cache.getLocalDb(), "SELECT name FROM Item WHERE id=?");
+
+#ifndef DB_TABLE_CACHE_H
+#define DB_TABLE_CACHE_H
+
+#include "DbAccess.h"
+
+#if(DB_USE_SQLITE && DB_USE_MYSQL)
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+/// Describes a MySQL table that is mirrored in the local database.
+struct DbCachedTableDef
+    {
+    DbCachedTableDef(char const *tableName, char const *columns,
+        char const *keyColumn, char const *versionColumn, int refreshSeconds=60):
+        mTableName(tableName), mColumns(columns), mKeyColumn(keyColumn),
+        mVersionColumn(versionColumn), mRefreshSeconds(refreshSeconds)
+        {}
+    std::string mTableName;
+    // The comma separated columns that are copied. This must contain the
+    // key and version columns.
+    std::string mColumns;
+    std::string mKeyColumn;
+    // A column that increases when a row is changed, such as an updated-at
+    // timestamp or a version number.
+    std::string mVersionColumn;
+    // The local table is refreshed when it is read after this time.
+    int mRefreshSeconds;
+    };
+
+class DbTableCache
+    {
+    public:
+        /// Both databases must be open while the cache is used.
+        DbTableCache(DbMysql::DbAccess &serverDb, DbSqlite::DbAccess &localDb):
+            mServerDb(serverDb), mLocalDb(localDb)
+            {}
+
+        /// The table is created and filled the first time it is refreshed.
+        DbResult addTable(DbCachedTableDef const &def);
+        /// Fills the local table if it has not been filled, or refreshes it
+        /// if it is stale or older than the refresh time. Call this before
+        /// reading the table from getLocalDb().
+        DbResult refreshIfNeeded(char const *tableName);
+        /// Copies the rows that have changed since the last refresh.
+        DbResult refresh(char const *tableName);
+        /// Call this after writing to the table on the server, so that the
+        /// next read refreshes the table. Deleted rows are not found by
+        /// the version column, so the table is reloaded if rows were deleted.
+        void invalidate(char const *tableName, bool rowsDeleted=false);
+        /// Executes a statement on the server, then invalidates the table.
+        DbResult executeWrite(char const *tableName, DbMysql::DbStatement &stmt,
+            bool rowsDeleted=false);
+
+        DbSqlite::DbAccess &getLocalDb()
+            { return mLocalDb; }
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+        struct CachedTable
+            {
+            explicit CachedTable(DbCachedTableDef const &def):
+                mDef(def), mVersionIndex(0), mNumColumns(0), mFilled(false),
+                mStale(false)
+                {}
+            DbCachedTableDef mDef;
+            int mVersionIndex;
+            int mNumColumns;
+            // The table is reloaded when this is false.
+            bool mFilled;
+            bool mStale;
+            // The newest version that was copied, as returned by the server.
+            std::string mMaxVersion;
+            Clock::time_point mRefreshTime;
+            };
+        DbMysql::DbAccess &mServerDb;
+        DbSqlite::DbAccess &mLocalDb;
+        std::unordered_map<std::string, CachedTable> mTables;
+
+        DbResult findTable(char const *tableName, CachedTable *&table);
+        DbResult copyRows(CachedTable &table);
+    };
+
+#endif
+#endif
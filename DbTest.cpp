@@ -1,5 +1,16 @@
 #include "DbAccess.h"
 #include "DbString.h"
+#include "DbConstString.h"
+#include "DbTable.h"
+
+// The SQL for this table is built at compile time from the members.
+struct Pet
+    {
+    int64_t id;
+    std::string name;
+    double weight;
+    };
+DB_TABLE(Pet, id, name, weight);
 
 int main()
     {
@@ -34,21 +45,51 @@ int main()
         {
         printf("Iterate through all Person rows\n");
         DbStatement statement(db);
-        DbString selectStr;
-        selectStr.SELECT("id, name").FROM("Person");
-        result = statement.set(selectStr.getDbStr().c_str());
+        // This query is built at compile time.
+        constexpr auto selectStr = DbConstSql().SELECT("id, name").FROM("Person");
+        result = statement.set(selectStr.getDbStr());
+        // Columns can be found once by name before getting rows.
+        DbColumn idColumn;
+        DbColumn nameColumn;
+        if(result.isOk())
+            {
+            result = statement.getColumn("id", idColumn);
+            }
+        if(result.isOk())
+            {
+            result = statement.getColumn("name", nameColumn);
+            }
         bool gotRow = true;
         while(result.isOk() && gotRow)
             {
             result = statement.testRow(gotRow);
             if(result.isOk() && gotRow)
                 {
-                int id = statement.getColumnInt(0);
-                std::string name = statement.getColumnText(1);
+                int id = statement.getColumnInt(idColumn.getIndex());
+                std::string name = statement.getColumnText(nameColumn.getIndex());
                 printf("  %d %s\n", id, name.c_str());
                 }
             }
         }
+    if(result.isOk())
+        {
+        printf("Store and load a Pet\n");
+        DbTable<Pet> pets(db);
+        result = pets.createTable();
+        if(result.isOk())
+            {
+            result = pets.upsert(Pet{1, "Rover", 12.5});
+            }
+        Pet pet;
+        if(result.isOk())
+            {
+            result = pets.loadByKey(1, pet);
+            }
+        if(result.isOk())
+            {
+            printf("  %d %s %.1f\n", static_cast<int>(pet.id), pet.name.c_str(), pet.weight);
+            }
+        }
     return 0;
     }
 
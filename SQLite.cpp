@@ -6,9 +6,13 @@
 */
 
 #include "SQLite.h"
+#if(DEBUG_STATIC_BINDS)
+#include <sanitizer/asan_interface.h>
+#endif
 
 void SQLiteImporter::loadSymbols()
     {
+    loadModuleSymbol("sqlite3_libversion_number", (ModuleProcPtr*)&sqlite3_libversion_number);
     loadModuleSymbol("sqlite3_open", (ModuleProcPtr*)&sqlite3_open);
     loadModuleSymbol("sqlite3_close", (ModuleProcPtr*)&sqlite3_close);
     loadModuleSymbol("sqlite3_exec", (ModuleProcPtr*)&sqlite3_exec);
@@ -25,6 +29,7 @@ void SQLiteImporter::loadSymbols()
 	loadModuleSymbol("sqlite3_finalize", (ModuleProcPtr*)&sqlite3_finalize);
 	loadModuleSymbol("sqlite3_step", (ModuleProcPtr*)&sqlite3_step);
 	loadModuleSymbol("sqlite3_reset", (ModuleProcPtr*)&sqlite3_reset);
+    loadModuleSymbol("sqlite3_sql", (ModuleProcPtr*)&sqlite3_sql);
 
     loadModuleSymbol("sqlite3_bind_parameter_index", (ModuleProcPtr*)&sqlite3_bind_parameter_index);
     loadModuleSymbol("sqlite3_bind_parameter_count", (ModuleProcPtr*)&sqlite3_bind_parameter_count);
@@ -35,6 +40,8 @@ void SQLiteImporter::loadSymbols()
 	loadModuleSymbol("sqlite3_bind_double", (ModuleProcPtr*)&sqlite3_bind_double);
 	loadModuleSymbol("sqlite3_bind_text", (ModuleProcPtr*)&sqlite3_bind_text);
 
+	loadModuleSymbol("sqlite3_column_count", (ModuleProcPtr*)&sqlite3_column_count);
+	loadModuleSymbol("sqlite3_column_name", (ModuleProcPtr*)&sqlite3_column_name);
 	loadModuleSymbol("sqlite3_column_type", (ModuleProcPtr*)&sqlite3_column_type);
 	loadModuleSymbol("sqlite3_column_int", (ModuleProcPtr*)&sqlite3_column_int);
 	loadModuleSymbol("sqlite3_column_int64", (ModuleProcPtr*)&sqlite3_column_int64);
@@ -43,6 +50,11 @@ void SQLiteImporter::loadSymbols()
 	loadModuleSymbol("sqlite3_column_bytes", (ModuleProcPtr*)&sqlite3_column_bytes);
     loadModuleSymbol("sqlite3_column_text", (ModuleProcPtr*)&sqlite3_column_text);
 
+    loadModuleSymbol("sqlite3_set_authorizer", (ModuleProcPtr*)&sqlite3_set_authorizer);
+    loadModuleSymbol("sqlite3_update_hook", (ModuleProcPtr*)&sqlite3_update_hook);
+    loadModuleSymbol("sqlite3_rollback_hook", (ModuleProcPtr*)&sqlite3_rollback_hook);
+    loadModuleSymbol("sqlite3_expanded_sql", (ModuleProcPtr*)&sqlite3_expanded_sql);
+
     loadModuleSymbol("sqlite3_mutex_alloc", (ModuleProcPtr*)&sqlite3_mutex_alloc);
     loadModuleSymbol("sqlite3_mutex_free", (ModuleProcPtr*)&sqlite3_mutex_free);
     loadModuleSymbol("sqlite3_mutex_enter", (ModuleProcPtr*)&sqlite3_mutex_enter);
@@ -51,6 +63,26 @@ void SQLiteImporter::loadSymbols()
 
     // This must be called for returned error strings.
     loadModuleSymbol("sqlite3_free", (ModuleProcPtr*)&sqlite3_free);
+
+    loadModuleSymbol("sqlite3_open_v2", (ModuleProcPtr*)&sqlite3_open_v2);
+    loadModuleSymbol("sqlite3_prepare_v3", (ModuleProcPtr*)&sqlite3_prepare_v3);
+    loadModuleSymbol("sqlite3_bind_text64", (ModuleProcPtr*)&sqlite3_bind_text64);
+    loadModuleSymbol("sqlite3_bind_blob64", (ModuleProcPtr*)&sqlite3_bind_blob64);
+    loadModuleSymbol("sqlite3_db_config", (ModuleProcPtr*)&sqlite3_db_config);
+
+    // Missing symbols are nullptr, so the optional features are found from
+    // the symbols instead of the version.
+    mCapabilities = SQLiteCapabilities();
+    if(sqlite3_libversion_number)
+        {
+        mCapabilities.mVersionNumber = sqlite3_libversion_number();
+        }
+    mCapabilities.mOpenV2 = (sqlite3_open_v2 != nullptr);
+    mCapabilities.mDbConfig = (sqlite3_db_config != nullptr);
+    mCapabilities.mBind64 = (sqlite3_bind_text64 && sqlite3_bind_blob64);
+    mCapabilities.mResultCacheHooks = (sqlite3_set_authorizer && sqlite3_update_hook &&
+        sqlite3_rollback_hook && sqlite3_expanded_sql);
+    mCapabilities.mPrepareV3 = (sqlite3_prepare_v3 != nullptr);
     }
 
 #if(DEBUG_CALLBACK)
@@ -78,9 +110,17 @@ bool SQLite::loadDbLib(char const *libName)
     return success;
     }
 
-int SQLite::openDb(char const *dbName)
+int SQLite::openDb(char const *dbName, int openFlags)
     {
-    int retCode = handleRetCode(sqlite3_open(dbName, &mDb));
+    int retCode;
+    if(sqlite3_open_v2)
+        {
+        retCode = handleRetCode(sqlite3_open_v2(dbName, &mDb, openFlags, nullptr));
+        }
+    else
+        {
+        retCode = handleRetCode(sqlite3_open(dbName, &mDb));
+        }
     if(IS_SQLITE_OK(retCode))
         {
 #if(DEBUG_CALLBACK)
@@ -151,18 +191,142 @@ void SQLiteStatement::closeStatement()
 //        reset();
 		mDb.handleRetCode(mDb.sqlite3_finalize(mStatement));
 		mStatement = nullptr;
+		mBoundBuffers.clear();
 		}
     }
 
-int SQLiteStatement::set(char const *query)
+int SQLiteStatement::set(char const *query, unsigned int prepareFlags)
     {
     closeStatement();
-	int res = mDb.sqlite3_prepare_v2(mDb.getDb(), query, -1, &mStatement, nullptr);
+    int res;
+    if(prepareFlags != 0 && mDb.sqlite3_prepare_v3)
+        {
+        res = mDb.sqlite3_prepare_v3(mDb.getDb(), query, -1, prepareFlags,
+            &mStatement, nullptr);
+        }
+    else
+        {
+        res = mDb.sqlite3_prepare_v2(mDb.getDb(), query, -1, &mStatement, nullptr);
+        }
+    return mDb.handleRetCode(res);
+    }
+
+// The 64 bit functions do not need the length to fit in an int.
+int SQLiteStatement::bindBytes(int ordinal, const void *data, size_t numBytes,
+    bool text, sqlite3_destructor_type destructor)
+    {
+    // A null pointer would bind NULL instead of an empty value.
+    if(!data)
+        {
+        data = "";
+        }
+    int res;
+    if(mDb.sqlite3_bind_text64 && mDb.sqlite3_bind_blob64)
+        {
+        if(text)
+            {
+            res = mDb.sqlite3_bind_text64(mStatement, ordinal,
+                static_cast<char const *>(data), numBytes, destructor, SQLITE_UTF8);
+            }
+        else
+            {
+            res = mDb.sqlite3_bind_blob64(mStatement, ordinal, data, numBytes,
+                destructor);
+            }
+        }
+    else if(numBytes <= static_cast<size_t>(std::numeric_limits<int>::max()))
+        {
+        if(text)
+            {
+            res = mDb.sqlite3_bind_text(mStatement, ordinal,
+                static_cast<char const *>(data), static_cast<int>(numBytes),
+                destructor);
+            }
+        else
+            {
+            res = mDb.sqlite3_bind_blob(mStatement, ordinal, data,
+                static_cast<int>(numBytes), destructor);
+            }
+        }
+    else
+        {
+        res = SQLITE_TOOBIG;
+        }
     return mDb.handleRetCode(res);
     }
 
+int SQLiteStatement::bindBuffer(int ordinal, const void *data, size_t numBytes,
+    bool text, SQLiteBindModes mode)
+    {
+    releaseBuffer(ordinal);
+    int res;
+    if(mode == SBM_Static)
+        {
+        res = bindBytes(ordinal, data, numBytes, text, SQLITE_STATIC);
+#if(DEBUG_STATIC_BINDS)
+        if(IS_SQLITE_OK(res))
+            {
+            BoundBuffer buffer;
+            buffer.mOrdinal = ordinal;
+            buffer.mData = data;
+            buffer.mNumBytes = numBytes;
+            mBoundBuffers.push_back(std::move(buffer));
+            }
+#endif
+        }
+    else
+        {
+        res = bindBytes(ordinal, data, numBytes, text, SQLITE_TRANSIENT);
+        }
+    return res;
+    }
+
+// The string is kept in its own allocation, so that moving the vector of
+// buffers does not move short strings that are stored inside std::string.
+int SQLiteStatement::bindOwned(int ordinal, std::string &&val, bool text)
+    {
+    releaseBuffer(ordinal);
+    std::unique_ptr<std::string> owned(new std::string(std::move(val)));
+    int res = bindBytes(ordinal, owned->data(), owned->length(), text, SQLITE_STATIC);
+    if(IS_SQLITE_OK(res))
+        {
+        BoundBuffer buffer;
+        buffer.mOrdinal = ordinal;
+        buffer.mOwned = std::move(owned);
+        mBoundBuffers.push_back(std::move(buffer));
+        }
+    return res;
+    }
+
+void SQLiteStatement::eraseBuffer(int ordinal)
+    {
+    for(size_t i=0; i<mBoundBuffers.size(); i++)
+        {
+        if(mBoundBuffers[i].mOrdinal == ordinal)
+            {
+            mBoundBuffers.erase(mBoundBuffers.begin() + static_cast<ptrdiff_t>(i));
+            break;
+            }
+        }
+    }
+
 int SQLiteStatement::step()
 	{
+#if(DEBUG_STATIC_BINDS)
+    for(auto const &buffer : mBoundBuffers)
+        {
+        if(!buffer.mOwned && __asan_region_is_poisoned(
+            const_cast<void *>(buffer.mData), buffer.mNumBytes))
+            {
+            if(mDb.mListener)
+                {
+                mDb.mListener->SQLError(SQLITE_MISUSE,
+                    "A buffer bound with SBM_Static was freed before the step");
+                }
+            return SQLITE_MISUSE;
+            }
+        }
+#endif
     int res = mDb.sqlite3_step(mStatement);
     return mDb.handleRetCode(res);
     }
@@ -185,3 +349,12 @@ void SQLiteTransaction::end()
 		}
 	}
 
+void SQLiteTransaction::rollback()
+	{
+	if(mInTransaction)
+		{
+		mDb.execDb("ROLLBACK TRANSACTION");
+		mInTransaction = false;
+		}
+	}
+
@@ -19,6 +19,10 @@
 #include "DbResult.h"
 #include <stdint.h>
 #include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 #ifdef __linux__
 #include <string.h>
 #endif
@@ -30,6 +34,12 @@ typedef struct sqlite3 sqlite3;
 typedef int (*SQLite_callback)(void*,int,char**,char**);
 typedef void *sqlite3_mutex_ptr;
 typedef struct sqlite3_stmt sqlite3_stmt;
+typedef int (*SQLite_authorizer)(void*,int action,char const*,char const*,
+    char const *dbName,char const *trigger);
+typedef void (*SQLite_updateHook)(void*,int op,char const *dbName,
+    char const *table,int64_t rowid);
+typedef void (*SQLite_rollbackHook)(void*);
+typedef uint64_t sqlite3_uint64;
 
 #define DEBUG_CALLBACK 0
 #define DEBUG_LOG 0
@@ -37,9 +47,20 @@ typedef struct sqlite3_stmt sqlite3_stmt;
 // Set this to SQLITE_STATIC for faster, but less safe mode.
 #define BUFFER_MODE SQLITE_TRANSIENT
 #define RETURN_DOUBLE_NULL_AS_NAN 1
+// This checks at each step that the buffers bound with SBM_Static have not
+// been freed. It needs AddressSanitizer, which marks freed memory.
+#ifndef DEBUG_STATIC_BINDS
+#if defined(__SANITIZE_ADDRESS__)
+#define DEBUG_STATIC_BINDS 1
+#else
+#define DEBUG_STATIC_BINDS 0
+#endif
+#endif
 
 struct SQLiteInterface
     {
+    // Returns a value such as 3045001 for version 3.45.1.
+    int (*sqlite3_libversion_number)(void);
     int (*sqlite3_open)(const char *filename, sqlite3 **ppDb);
     int (*sqlite3_close)(sqlite3 *pDb);
     int (*sqlite3_exec)(sqlite3 *pDb, const char *sql,
@@ -65,6 +86,8 @@ struct SQLiteInterface
     int (*sqlite3_finalize)(sqlite3_stmt *pStmt);
     int (*sqlite3_step)(sqlite3_stmt*);
     int (*sqlite3_reset)(sqlite3_stmt*);
+    // The text that the statement was prepared with.
+    const char *(*sqlite3_sql)(sqlite3_stmt *pStmt);
 
     int (*sqlite3_bind_parameter_index)(sqlite3_stmt*, const char *zName);
     int (*sqlite3_bind_parameter_count)(sqlite3_stmt*);
@@ -77,14 +100,37 @@ struct SQLiteInterface
     int (*sqlite3_bind_blob)(sqlite3_stmt*, int ordinal, const void *bytes,
         int elSize, void(*)(void*));
 
+    int (*sqlite3_column_count)(sqlite3_stmt*);
+    // Memory returned must not be freed by application.
+    const char *(*sqlite3_column_name)(sqlite3_stmt*, int iCol);
     int (*sqlite3_column_type)(sqlite3_stmt*, int iCol);
     int (*sqlite3_column_int)(sqlite3_stmt*, int iCol);
-    int (*sqlite3_column_int64)(sqlite3_stmt*, int iCol);
+    int64_t (*sqlite3_column_int64)(sqlite3_stmt*, int iCol);
     double (*sqlite3_column_double)(sqlite3_stmt*, int iCol);
     const void *(*sqlite3_column_blob)(sqlite3_stmt*, int iCol);
     int (*sqlite3_column_bytes)(sqlite3_stmt*, int iCol);
     char const *(*sqlite3_column_text)(sqlite3_stmt*, int iCol);
 
+    // These are used by the result cache, and are nullptr if the library is
+    // older than 3.14.
+    int (*sqlite3_set_authorizer)(sqlite3*, SQLite_authorizer xAuth, void *pUserData);
+    void *(*sqlite3_update_hook)(sqlite3*, SQLite_updateHook, void*);
+    void *(*sqlite3_rollback_hook)(sqlite3*, SQLite_rollbackHook, void*);
+    // The returned memory must be freed with sqlite3_free.
+    char *(*sqlite3_expanded_sql)(sqlite3_stmt*);
+
+    // These are optional, and are nullptr if the library is too old. See
+    // SQLiteCapabilities for the versions.
+    int (*sqlite3_open_v2)(const char *filename, sqlite3 **ppDb, int flags,
+        const char *zVfs);
+    int (*sqlite3_prepare_v3)(sqlite3 *pDb, const char *sql, int nBytes,
+        unsigned int prepFlags, sqlite3_stmt **ppStmt, const char **pzTail);
+    int (*sqlite3_bind_text64)(sqlite3_stmt*, int ordinal, const char*,
+        sqlite3_uint64 numBytes, void(*)(void*), unsigned char encoding);
+    int (*sqlite3_bind_blob64)(sqlite3_stmt*, int ordinal, const void *bytes,
+        sqlite3_uint64 numBytes, void(*)(void*));
+    int (*sqlite3_db_config)(sqlite3*, int op, ...);
+
     // SQLITE_MUTEX_FAST, SQLITE_MUTEX_RECURSIVE
     sqlite3_mutex_ptr (*sqlite3_mutex_alloc)(int);
     void (*sqlite3_mutex_free)(sqlite3_mutex_ptr);
@@ -104,20 +150,87 @@ struct SQLiteInterface
 // get them from there.
 #define SQLITE_OK 0
 #define SQLITE_ERROR 1
+#define SQLITE_BUSY 5
+#define SQLITE_LOCKED 6
+#define SQLITE_IOERR 10
+#define SQLITE_CORRUPT 11
+#define SQLITE_NOTFOUND 12
+#define SQLITE_FULL 13
+#define SQLITE_CANTOPEN 14
+#define SQLITE_CONSTRAINT 19
+#define SQLITE_MISMATCH 20
+#define SQLITE_TOOBIG 18
+#define SQLITE_MISUSE 21
+#define SQLITE_RANGE 25
+#define SQLITE_INTEGER 1
+#define SQLITE_FLOAT 2
+#define SQLITE_TEXT 3
+#define SQLITE_BLOB 4
 #define SQLITE_NULL 5
 #define SQLITE_ROW 100
 #define SQLITE_DONE 101
 inline bool IS_SQLITE_ERROR(int x)  { return x!=SQLITE_OK && x!=SQLITE_ROW && x!=SQLITE_DONE; }
 inline bool IS_SQLITE_OK(int x)  { return !IS_SQLITE_ERROR(x); }
+// Authorizer action codes.
+#define SQLITE_DELETE 9
+#define SQLITE_INSERT 18
+#define SQLITE_PRAGMA 19
+#define SQLITE_READ 20
+#define SQLITE_SELECT 21
+#define SQLITE_TRANSACTION 22
+#define SQLITE_UPDATE 23
+#define SQLITE_FUNCTION 31
+#define SQLITE_SAVEPOINT 32
+#define SQLITE_RECURSIVE 33
+// Flags for sqlite3_open_v2.
+#define SQLITE_OPEN_READONLY 0x00000001
+#define SQLITE_OPEN_READWRITE 0x00000002
+#define SQLITE_OPEN_CREATE 0x00000004
+#define SQLITE_OPEN_URI 0x00000040
+#define SQLITE_OPEN_NOMUTEX 0x00008000
+#define SQLITE_OPEN_FULLMUTEX 0x00010000
+// Flags for sqlite3_prepare_v3.
+#define SQLITE_PREPARE_PERSISTENT 0x01
+// Options for sqlite3_db_config.
+#define SQLITE_DBCONFIG_LOOKASIDE 1001
+#define SQLITE_UTF8 1
 typedef void (*sqlite3_destructor_type)(void*);
 #define SQLITE_STATIC      ((sqlite3_destructor_type)0)
 #define SQLITE_TRANSIENT   ((sqlite3_destructor_type)-1)
 
+/// The optional features of the loaded library. The wrapper functions use
+/// the newer entry points when they are available, and fall back to the
+/// older ones otherwise.
+struct SQLiteCapabilities
+    {
+    SQLiteCapabilities():
+        mVersionNumber(0), mOpenV2(false), mDbConfig(false), mBind64(false),
+        mResultCacheHooks(false), mPrepareV3(false)
+        {}
+    // A value such as 3045001 for version 3.45.1.
+    int mVersionNumber;
+    // 3.5: Open flags such as SQLITE_OPEN_NOMUTEX.
+    bool mOpenV2;
+    // 3.7: Lookaside configuration.
+    bool mDbConfig;
+    // 3.8.7: Text and blob lengths larger than an int.
+    bool mBind64;
+    // 3.14: The hooks needed by the result cache.
+    bool mResultCacheHooks;
+    // 3.20: SQLITE_PREPARE_PERSISTENT for statements that are kept.
+    bool mPrepareV3;
+    };
+
 /// This loads the symbols from the DLL into the interface.
 class SQLiteImporter:public SQLiteInterface, public Module
     {
     public:
         void loadSymbols();
+        SQLiteCapabilities const &getCapabilities() const
+            { return mCapabilities; }
+
+    private:
+        SQLiteCapabilities mCapabilities;
     };
 
 /// Functions that return errors and results will call functions in this
@@ -154,7 +267,10 @@ class SQLite:public SQLiteImporter
         bool loadDbLib(char const *libName);
 
         /// The dbName is the name of the file that will be opened.
-        int openDb(char const *dbName);
+        /// @param openFlags The SQLITE_OPEN_... flags. These are ignored if
+        ///     the library does not have sqlite3_open_v2.
+        int openDb(char const *dbName,
+            int openFlags=SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
 
         /// This is called from the destructor, so does not need an additional
         /// call unless it must be closed early.
@@ -181,6 +297,18 @@ class SQLite:public SQLiteImporter
         int handleRetCode(int retCode);
     };
 
+/// How text and blob views are bound.
+enum SQLiteBindModes
+    {
+    // SQLite copies the value, so the buffer can be changed after the bind.
+    SBM_Copy,
+    // SQLite uses the buffer without copying it. The caller must keep the
+    // buffer unchanged until the parameter is bound again, the bindings are
+    // cleared, or the statement is set again or destroyed. A reset keeps
+    // the binding like any other, so a rerun reads the buffer again.
+    SBM_Static
+    };
+
 /// This was created for type safety.
 struct SQLiteResult
     {
@@ -202,7 +330,7 @@ public:
         mDb(db), mStatement(nullptr)
         {}
     SQLiteStatement(SQLite &db, char const *query):
-        mDb(db)
+        mDb(db), mStatement(nullptr)
         { set(query); }
 
     // This does a finalize.
@@ -212,7 +340,10 @@ public:
     SQLite &getDb()
         { return mDb; }
 
-    int set(char const *query);
+    /// @param prepareFlags Use SQLITE_PREPARE_PERSISTENT for statements that
+    ///     are kept and run many times. This is ignored if the library does
+    ///     not have sqlite3_prepare_v3.
+    int set(char const *query, unsigned int prepareFlags=0);
     // If the query is failing, make sure the bound values are in memory.
     // Search for SQLITE_STATIC in the code for more info.
 
@@ -226,7 +357,18 @@ public:
 
     // Reset the bound values.
     int clearBindings()
-        { return mDb.handleRetCode(mDb.sqlite3_clear_bindings(mStatement)); }
+        {
+        int retCode = mDb.handleRetCode(mDb.sqlite3_clear_bindings(mStatement));
+        mBoundBuffers.clear();
+        return retCode;
+        }
+
+    // The number of columns in the result.
+    int getColumnCount() const
+        { return mDb.sqlite3_column_count(mStatement); }
+    // This is the name or "AS" name of the column in the query.
+    char const *getColumnName(int columnIndex) const
+        { return mDb.sqlite3_column_name(mStatement, columnIndex); }
 
     // Column indices are base 0.
     int getColumnInt(int columnIndex) const
@@ -247,6 +389,9 @@ public:
     double getColumnDouble(int columnIndex) const
         { return mDb.sqlite3_column_double(mStatement, columnIndex); }
 #endif
+    // Returns SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL.
+    int getColumnType(int columnIndex) const
+        { return mDb.sqlite3_column_type(mStatement, columnIndex); }
     // Since this must be called in order, this is removed.
 //    int getColumnBytes(int columnIndex) const
 //        { return mDb->sqlite3_column_bytes(mStatement, columnIndex); }
@@ -267,61 +412,116 @@ public:
     int getBindCount()
         { return mDb.sqlite3_bind_parameter_count(mStatement); }
     int bindNull(int ordinal)
-        { return mDb.handleRetCode(mDb.sqlite3_bind_null(mStatement, ordinal)); }
-    int bindNull(char const *param)
         {
-        return mDb.handleRetCode(mDb.sqlite3_bind_null(mStatement,
-            mDb.sqlite3_bind_parameter_index(mStatement, param)));
+        releaseBuffer(ordinal);
+        return mDb.handleRetCode(mDb.sqlite3_bind_null(mStatement, ordinal));
         }
+    int bindNull(char const *param)
+        { return bindNull(mDb.sqlite3_bind_parameter_index(mStatement, param)); }
     int bindInt(int ordinal, int val)
-        { return mDb.handleRetCode(mDb.sqlite3_bind_int(mStatement, ordinal, val)); }
-    int bindInt(char const *param, int val)
         {
-        return mDb.handleRetCode(mDb.sqlite3_bind_int(mStatement, 
-            mDb.sqlite3_bind_parameter_index(mStatement, param), val));
+        releaseBuffer(ordinal);
+        return mDb.handleRetCode(mDb.sqlite3_bind_int(mStatement, ordinal, val));
         }
-    int bindInt64(char const *param, int64_t val)
+    int bindInt(char const *param, int val)
+        { return bindInt(mDb.sqlite3_bind_parameter_index(mStatement, param), val); }
+    int bindInt64(int ordinal, int64_t val)
         {
-        return mDb.handleRetCode(mDb.sqlite3_bind_int64(mStatement, 
-            mDb.sqlite3_bind_parameter_index(mStatement, param), val));
+        releaseBuffer(ordinal);
+        return mDb.handleRetCode(mDb.sqlite3_bind_int64(mStatement, ordinal, val));
         }
+    int bindInt64(char const *param, int64_t val)
+        { return bindInt64(mDb.sqlite3_bind_parameter_index(mStatement, param), val); }
     int bindFloat(int ordinal, float val)
         { return bindDouble(ordinal, val); }
     int bindFloat(char const *param, float val)
         { return bindDouble(param, val); }
     int bindDouble(int ordinal, double val)
-        { return mDb.handleRetCode(mDb.sqlite3_bind_double(mStatement, ordinal, val)); }
-    int bindDouble(char const *param, double val)
-        { 
-        return mDb.handleRetCode(mDb.sqlite3_bind_double(mStatement, 
-            mDb.sqlite3_bind_parameter_index(mStatement, param), val));
+        {
+        releaseBuffer(ordinal);
+        return mDb.handleRetCode(mDb.sqlite3_bind_double(mStatement, ordinal, val));
         }
+    int bindDouble(char const *param, double val)
+        { return bindDouble(mDb.sqlite3_bind_parameter_index(mStatement, param), val); }
     // WARNING - SQLITE_STATIC means that the val parameter must be around while
     // the statement is executing.
     int bindText(int ordinal, char const *val)
         {
         /// @todo - strlen may not be right for UTF-8
+        releaseBuffer(ordinal);
         return mDb.handleRetCode(mDb.sqlite3_bind_text(mStatement, ordinal, val,
             static_cast<int>(strlen(val)), BUFFER_MODE));
         }
     int bindText(char const *param, char const *val)
-        {
-        /// @todo - strlen may not be right for UTF-8
-        return mDb.handleRetCode(mDb.sqlite3_bind_text(mStatement,
-            mDb.sqlite3_bind_parameter_index(mStatement, param), val,
-            static_cast<int>(strlen(val)), BUFFER_MODE));
-        }
+        { return bindText(mDb.sqlite3_bind_parameter_index(mStatement, param), val); }
     int bindBlob(int ordinal, const void *bytes, int elNumBytes)
         {
+        releaseBuffer(ordinal);
         return mDb.handleRetCode(mDb.sqlite3_bind_blob(mStatement, ordinal,
             bytes, elNumBytes, BUFFER_MODE));
         }
+    // The text is always copied, so it does not need to be kept while
+    // the statement is executing.
+    int bindTextCopy(int ordinal, char const *val, size_t len)
+        { return bindTextView(ordinal, std::string_view(val, len), SBM_Copy); }
+    // The bytes are always copied.
+    int bindBlobCopy(int ordinal, const void *bytes, size_t numBytes)
+        { return bindBlobView(ordinal, bytes, numBytes, SBM_Copy); }
+    /// The length is taken from the view, so the text does not need a null
+    /// terminator. See SQLiteBindModes for the lifetime of the buffer.
+    int bindTextView(int ordinal, std::string_view val, SQLiteBindModes mode)
+        { return bindBuffer(ordinal, val.data(), val.length(), true, mode); }
+    int bindBlobView(int ordinal, const void *bytes, size_t numBytes,
+        SQLiteBindModes mode)
+        { return bindBuffer(ordinal, bytes, numBytes, false, mode); }
+    /// The string is moved into the statement, and is kept until the
+    /// parameter is bound again, the bindings are cleared, or the statement
+    /// is set again. This does not copy the value.
+    int bindTextOwned(int ordinal, std::string &&val)
+        { return bindOwned(ordinal, std::move(val), true); }
+    /// The string contains the bytes of the blob.
+    int bindBlobOwned(int ordinal, std::string &&bytes)
+        { return bindOwned(ordinal, std::move(bytes), false); }
+
+protected:
+    sqlite3_stmt *getStatement() const
+        { return mStatement; }
 
 private:
+    /// A buffer that SQLite uses without a copy.
+    struct BoundBuffer
+        {
+        int mOrdinal;
+#if(DEBUG_STATIC_BINDS)
+        // These are only set for SBM_Static. SBM_Static buffers are only
+        // kept here when DEBUG_STATIC_BINDS is set.
+        const void *mData;
+        size_t mNumBytes;
+#endif
+        // This is nullptr for SBM_Static.
+        std::unique_ptr<std::string> mOwned;
+        };
     sqlite3_stmt *mStatement;
     SQLite &mDb;
+    std::vector<BoundBuffer> mBoundBuffers;
 
     void closeStatement();
+    // This must be called by each bind function, since a buffer is no longer
+    // used after the parameter is bound again.
+    void releaseBuffer(int ordinal)
+        {
+        if(!mBoundBuffers.empty())
+            {
+            eraseBuffer(ordinal);
+            }
+        }
+    void eraseBuffer(int ordinal);
+    int bindBuffer(int ordinal, const void *data, size_t numBytes, bool text,
+        SQLiteBindModes mode);
+    int bindOwned(int ordinal, std::string &&val, bool text);
+    /// Calls the 64 bit bind functions if they are available.
+    int bindBytes(int ordinal, const void *data, size_t numBytes, bool text,
+        sqlite3_destructor_type destructor);
     // Don't allow copies of this class.
     SQLiteStatement& operator=(const SQLiteStatement &self);
 };
@@ -345,6 +545,22 @@ class SQLiteTransaction
             }
         void begin();
         void end();
+        /// Discards the changes of the transaction. The destructor then
+        /// does not commit.
+        void rollback();
+        bool isInTransaction() const
+            { return mInTransaction; }
+
+    protected:
+        /// This allows a derived class to begin the transaction.
+        SQLiteTransaction(SQLite &db, bool beginNow):
+            mDb(db), mInTransaction(false)
+            {
+            if(beginNow)
+                {
+                begin();
+                }
+            }
 
     private:
         SQLite &mDb;